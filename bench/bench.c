@@ -0,0 +1,86 @@
+#include "bench.h"
+#include "hamming_channel.h"
+#include "hamming_io.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int bench_make_dir(const char *parent, char *dir, size_t size) {
+    if (parent == NULL) {
+        parent = getenv("TMPDIR");
+    }
+
+    snprintf(dir, size, "%s/hamming_bench.XXXXXX", parent != NULL ? parent : "/tmp");
+
+    if (mkdtemp(dir) == NULL) {
+        perror(dir);
+        return -1;
+    }
+
+    return 0;
+}
+
+int bench_write_payload(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *path,
+                        size_t size,
+                        uint64_t seed) {
+    struct hamming_channel random;
+    uint8_t *buf;
+    size_t written = 0;
+    int fd;
+
+    // the channel is only used for its random number generator
+    hamming_channel_init(&random, HAMMING_CHANNEL_UNIFORM, 0.0, 0, seed);
+    buf = dc_malloc(env, err, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    if (buf == NULL) {
+        return -1;
+    }
+
+    fd = dc_open(env, err, path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    while (dc_error_has_no_error(err) && written < size) {
+        size_t nbyte = size - written < HAMMING_DEFAULT_CHUNK_SIZE ? size - written : HAMMING_DEFAULT_CHUNK_SIZE;
+
+        for (size_t i = 0; i < nbyte; i++) {
+            buf[i] = (uint8_t) (hamming_channel_random(&random) >> 56);
+        }
+
+        if (hamming_write_fully(env, err, fd, buf, nbyte) == -1) {
+            break;
+        }
+
+        written += nbyte;
+    }
+
+    if (fd != -1) {
+        dc_dc_close(env, err, fd);
+    }
+
+    dc_free(env, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+void bench_remove_planes(const char *prefix) {
+    char path[PATH_MAX];
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == 0) {
+            unlink(path);
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s.meta", prefix);
+    unlink(path);
+}
+
+void bench_error_reporter(const struct dc_error *err) {
+    fprintf(stderr, "ERROR: %s\n", err->message);
+}
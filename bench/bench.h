@@ -0,0 +1,45 @@
+#ifndef HAMMING_BENCH_H
+#define HAMMING_BENCH_H
+
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Creates a fresh directory for the files of a benchmark run.
+ * @param parent the directory to create it in, NULL for $TMPDIR or /tmp
+ * @param dir receives the path of the directory
+ * @param size the size of dir
+ * @return 0 on success, -1 on failure
+ */
+int bench_make_dir(const char *parent, char *dir, size_t size);
+
+/**
+ * Writes a file of random bytes, the same bytes for the same seed.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param path the file to write
+ * @param size the number of bytes
+ * @param seed the seed of the random bytes
+ * @return 0 on success, -1 on failure
+ */
+int bench_write_payload(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *path,
+                        size_t size,
+                        uint64_t seed);
+
+/**
+ * Removes the plane files and the sidecar of a prefix, whichever exist.
+ * @param prefix the prefix of the plane files
+ */
+void bench_remove_planes(const char *prefix);
+
+/**
+ * Reports an error on standard error.
+ * @param err the error
+ */
+void bench_error_reporter(const struct dc_error *err);
+
+#endif // HAMMING_BENCH_H
@@ -0,0 +1,321 @@
+/*
+ * Decoder throughput and correction against the bit error rate.
+ *
+ * Encodes a random payload once, then for every channel and rate copies the planes, damages
+ * the copy with the channel and times hamming_decode on it. The output is one row per run,
+ * in columns a plotting tool can read directly:
+ *
+ *     hamming_ber_bench [SIZE] [DIRECTORY] > ber.dat
+ *     gnuplot -e "set logscale x; plot 'ber.dat' using 2:4 title 'MB/s'"
+ */
+
+#include "bench.h"
+#include "hamming_arena.h"
+#include "hamming_channel.h"
+#include "hamming_clock.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_options.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Payload size when none is given.
+ */
+#define DEFAULT_SIZE ((size_t) 16 * 1024 * 1024)
+
+/**
+ * Room for the longest file name the benchmark adds to its directory.
+ */
+#define NAME_SIZE sizeof("/output")
+
+/**
+ * Seed of the payload and of every channel, so runs can be compared.
+ */
+#define SEED 1
+
+/**
+ * One damaged decode to measure.
+ */
+struct run {
+    enum hamming_channel_mode mode;
+    double ber;
+};
+
+static const struct run runs[] = {
+        {HAMMING_CHANNEL_UNIFORM, 0.0},
+        {HAMMING_CHANNEL_UNIFORM, 1e-6},
+        {HAMMING_CHANNEL_UNIFORM, 1e-5},
+        {HAMMING_CHANNEL_UNIFORM, 1e-4},
+        {HAMMING_CHANNEL_UNIFORM, 1e-3},
+        {HAMMING_CHANNEL_UNIFORM, 1e-2},
+        {HAMMING_CHANNEL_BURST, 1e-5},
+        {HAMMING_CHANNEL_BURST, 1e-4},
+        {HAMMING_CHANNEL_BURST, 1e-3},
+        {HAMMING_CHANNEL_PLANE, 0.0},
+};
+
+static const char *const mode_names[] = {"uniform", "burst", "plane"};
+
+static int copy_file(const struct dc_posix_env *env, struct dc_error *err, const char *from, const char *to);
+
+static int copy_planes(const struct dc_posix_env *env, struct dc_error *err, const char *from, const char *to);
+
+static int count_wrong(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *expected,
+                       const char *actual,
+                       uint64_t *wrong);
+
+int main(int argc, char *argv[]) {
+    struct dc_posix_env env;
+    struct dc_error err;
+    struct hamming_arena arena = {0};
+    struct hamming_encode_options encode;
+    struct hamming_decode_options decode;
+    struct hamming_encode_stats encode_stats = {0};
+    char dir[PATH_MAX];
+    char input[PATH_MAX + NAME_SIZE];
+    char output[PATH_MAX + NAME_SIZE];
+    char clean[PATH_MAX + NAME_SIZE];
+    char noisy[PATH_MAX + NAME_SIZE];
+    size_t size = DEFAULT_SIZE;
+    int ret_val = EXIT_FAILURE;
+    int fd;
+
+    dc_error_init(&err, bench_error_reporter);
+    dc_posix_env_init(&env, NULL);
+
+    if (argc > 1 && hamming_parse_size(argv[1], &size) == -1) {
+        fprintf(stderr, "usage: %s [SIZE] [DIRECTORY]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (bench_make_dir(argc > 2 ? argv[2] : NULL, dir, sizeof(dir)) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    snprintf(input, sizeof(input), "%s/input", dir);
+    snprintf(output, sizeof(output), "%s/output", dir);
+    snprintf(clean, sizeof(clean), "%s/clean", dir);
+    snprintf(noisy, sizeof(noisy), "%s/noisy", dir);
+
+    hamming_encode_options_init(&encode);
+    encode.binary = true;
+    hamming_decode_options_init(&decode);
+    decode.binary = true;
+
+    if (bench_write_payload(&env, &err, input, size, SEED) == -1) {
+        goto done;
+    }
+
+    fd = dc_open(&env, &err, input, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(&err)) {
+        goto done;
+    }
+
+    if (hamming_encode(&env, &err, &arena, fd, clean, &encode, &encode_stats) == -1) {
+        dc_dc_close(&env, &err, fd);
+        goto done;
+    }
+
+    dc_dc_close(&env, &err, fd);
+    printf("# %zu bytes, %zu bits per plane set\n", size, size * BITS_INC_HAMMING);
+    printf("# %-7s %10s %12s %10s %12s %14s %12s\n", "mode", "ber", "flipped", "MB/s", "corrected", "uncorrectable",
+           "wrong bytes");
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        struct hamming_channel channel;
+        struct hamming_decode_stats stats = {0};
+        uint64_t wrong;
+        size_t lost;
+        double start;
+        double seconds;
+        int out_fd;
+
+        if (copy_planes(&env, &err, clean, noisy) == -1) {
+            goto done;
+        }
+
+        hamming_channel_init(&channel, runs[i].mode, runs[i].ber, 0, SEED);
+
+        if (hamming_channel_planes(&env, &err, noisy, &channel, &lost) == -1) {
+            goto done;
+        }
+
+        out_fd = dc_open(&env, &err, output, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+        if (dc_error_has_error(&err)) {
+            goto done;
+        }
+
+        // only the decode is timed, the planes it reads are in the page cache
+        start = hamming_clock_now();
+
+        if (hamming_decode(&env, &err, &arena, noisy, out_fd, &decode, &stats) == -1) {
+            dc_dc_close(&env, &err, out_fd);
+            goto done;
+        }
+
+        seconds = hamming_clock_now() - start;
+        dc_dc_close(&env, &err, out_fd);
+
+        if (count_wrong(&env, &err, input, output, &wrong) == -1) {
+            goto done;
+        }
+
+        printf("  %-7s %10.0e %12" PRIu64 " %10.1f %12" PRIu64 " %14" PRIu64 " %12" PRIu64 "\n",
+               mode_names[runs[i].mode], runs[i].ber, channel.flipped, (double) size / seconds / 1e6, stats.corrected,
+               stats.uncorrectable, wrong);
+        fflush(stdout);
+        bench_remove_planes(noisy);
+    }
+
+    ret_val = EXIT_SUCCESS;
+
+done:
+    bench_remove_planes(clean);
+    bench_remove_planes(noisy);
+    unlink(input);
+    unlink(output);
+    rmdir(dir);
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(&env, &arena);
+    }
+
+    return ret_val;
+}
+
+static int copy_file(const struct dc_posix_env *env, struct dc_error *err, const char *from, const char *to) {
+    uint8_t *buf;
+    ssize_t nread;
+    int in_fd;
+    int out_fd;
+
+    in_fd = dc_open(env, err, from, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    out_fd = dc_open(env, err, to, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+    buf = dc_malloc(env, err, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    while (buf != NULL && dc_error_has_no_error(err) &&
+           (nread = hamming_read_fully(env, err, in_fd, buf, HAMMING_DEFAULT_CHUNK_SIZE)) > 0) {
+        if (hamming_write_fully(env, err, out_fd, buf, (size_t) nread) == -1) {
+            break;
+        }
+    }
+
+    if (buf != NULL) {
+        dc_free(env, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+    }
+
+    if (out_fd != -1) {
+        dc_dc_close(env, err, out_fd);
+    }
+
+    dc_dc_close(env, err, in_fd);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int copy_planes(const struct dc_posix_env *env, struct dc_error *err, const char *from, const char *to) {
+    char from_path[PATH_MAX];
+    char to_path[PATH_MAX];
+    char *from_meta;
+    char *to_meta;
+    size_t from_size;
+    size_t to_size;
+    int ret_val = 0;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING && ret_val == 0; index++) {
+        hamming_plane_path(from, index, from_path, sizeof(from_path));
+        hamming_plane_path(to, index, to_path, sizeof(to_path));
+
+        // constant planes have no file
+        if (access(from_path, F_OK) == 0) {
+            ret_val = copy_file(env, err, from_path, to_path);
+        }
+    }
+
+    from_meta = hamming_meta_path(env, err, from, &from_size);
+    to_meta = hamming_meta_path(env, err, to, &to_size);
+
+    if (ret_val == 0 && from_meta != NULL && to_meta != NULL) {
+        ret_val = copy_file(env, err, from_meta, to_meta);
+    }
+
+    if (from_meta != NULL) {
+        dc_free(env, from_meta, from_size);
+    }
+
+    if (to_meta != NULL) {
+        dc_free(env, to_meta, to_size);
+    }
+
+    return dc_error_has_error(err) ? -1 : ret_val;
+}
+
+static int count_wrong(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *expected,
+                       const char *actual,
+                       uint64_t *wrong) {
+    uint8_t *buf;
+    ssize_t expected_read;
+    ssize_t actual_read;
+    int expected_fd;
+    int actual_fd;
+
+    *wrong = 0;
+    buf = dc_malloc(env, err, 2 * HAMMING_DEFAULT_CHUNK_SIZE);
+
+    if (buf == NULL) {
+        return -1;
+    }
+
+    expected_fd = dc_open(env, err, expected, DC_O_RDONLY, 0);
+    actual_fd = dc_error_has_no_error(err) ? dc_open(env, err, actual, DC_O_RDONLY, 0) : -1;
+
+    while (dc_error_has_no_error(err)) {
+        expected_read = hamming_read_fully(env, err, expected_fd, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+        actual_read = hamming_read_fully(env, err, actual_fd, buf + HAMMING_DEFAULT_CHUNK_SIZE,
+                                         HAMMING_DEFAULT_CHUNK_SIZE);
+
+        if (expected_read <= 0 || actual_read < 0) {
+            break;
+        }
+
+        // missing output counts as wrong
+        for (ssize_t i = 0; i < expected_read; i++) {
+            if (i >= actual_read || buf[i] != buf[HAMMING_DEFAULT_CHUNK_SIZE + (size_t) i]) {
+                (*wrong)++;
+            }
+        }
+    }
+
+    if (actual_fd != -1) {
+        dc_dc_close(env, err, actual_fd);
+    }
+
+    if (expected_fd != -1) {
+        dc_dc_close(env, err, expected_fd);
+    }
+
+    dc_free(env, buf, 2 * HAMMING_DEFAULT_CHUNK_SIZE);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
@@ -0,0 +1,484 @@
+/*
+ * Each codec kernel in isolation, the reference implementation against its replacement.
+ *
+ * The reference kernels are the character-at-a-time functions the planes were first
+ * produced with; the optimized ones work on eight characters or 64 plane bits at once.
+ * Every kernel runs on buffers sized for the L1 cache, the L2 cache and main memory, with a
+ * warm-up run and enough repetitions for a stable median and 99th percentile:
+ *
+ *     hamming_kernel_bench [l1] [l2] [dram] [huge]
+ *
+ * encode-stores compares writing the planes through the cache with writing them with
+ * non-temporal stores, which only pays off once the planes no longer fit in the last level
+ * cache, as at the dram size. With huge the buffers are backed by huge pages, to compare
+ * against a run without it for the cost of TLB misses.
+ *
+ * Before anything is timed the optimized and streaming encodes and the optimized decode are checked against the
+ * reference ones on the same input, damaged for the decode.
+ */
+
+#include "bench.h"
+#include "hamming_arena.h"
+#include "hamming_channel.h"
+#include "hamming_clock.h"
+#include "hamming_codec.h"
+#include <dc_posix/dc_stdlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Time each kernel is run for at one size, in seconds, within the repetition limits.
+ */
+#define TARGET_SECONDS 0.3
+
+#define MIN_REPETITIONS 5
+
+#define MAX_REPETITIONS 2000
+
+/**
+ * Bit error rate of the planes the decoding kernels are given.
+ */
+#define DECODE_BER 1e-3
+
+#define SEED 1
+
+/**
+ * The data every kernel works on, for one buffer size.
+ */
+struct kernel_data {
+    struct hamming_buffers buffers;
+    size_t count;
+    int parity;
+    uint8_t *clean[BITS_INC_HAMMING];   // the encoded planes
+    uint8_t *noisy[BITS_INC_HAMMING];   // the encoded planes after the channel
+    uint8_t *unpacked;                  // the noisy planes as 8 data and 4 parity bits per character
+    uint8_t *unpacked_noisy;            // a copy of unpacked to restore it from
+    uint8_t *expected;                  // the characters the reference decode produced
+    size_t plane_bytes;
+    struct hamming_decode_stats stats;
+};
+
+typedef void (*kernel_fn)(struct kernel_data *data);
+
+/**
+ * A building block of the codec: its reference implementation, its replacement (NULL when
+ * it has been fused into another kernel), what has to be restored before each run and what
+ * the two implementations are called in the report.
+ */
+struct kernel {
+    const char *name;
+    kernel_fn prepare;
+    kernel_fn reference;
+    kernel_fn optimized;
+    const char *labels[2];
+};
+
+/**
+ * A buffer size, named after the level of the memory hierarchy it fits in.
+ */
+struct size_class {
+    const char *name;
+    size_t count; // characters
+};
+
+static const struct size_class size_classes[] = {
+        {"l1", (size_t) 4 * 1024},
+        {"l2", (size_t) 128 * 1024},
+        {"dram", (size_t) 16 * 1024 * 1024},
+};
+
+static void restore_clean(struct kernel_data *data);
+
+static void restore_noisy(struct kernel_data *data);
+
+static void bits_reference(struct kernel_data *data);
+
+static void bits_optimized(struct kernel_data *data);
+
+static void parity_reference(struct kernel_data *data);
+
+static void parity_optimized(struct kernel_data *data);
+
+static void pack_reference(struct kernel_data *data);
+
+static void extract_reference(struct kernel_data *data);
+
+static void extract_optimized(struct kernel_data *data);
+
+static void correct_reference(struct kernel_data *data);
+
+static void correct_optimized(struct kernel_data *data);
+
+static void encode_reference(struct kernel_data *data);
+
+static void encode_optimized(struct kernel_data *data);
+
+static void encode_cached(struct kernel_data *data);
+
+static void encode_streaming(struct kernel_data *data);
+
+static void decode_reference(struct kernel_data *data);
+
+static void decode_optimized(struct kernel_data *data);
+
+static const struct kernel kernels[] = {
+        {"byte-to-bits", NULL, bits_reference, bits_optimized, {"reference", "optimized"}},
+        {"parity", restore_clean, parity_reference, parity_optimized, {"reference", "optimized"}},
+        {"pack", NULL, pack_reference, NULL, {"reference", "fused"}},
+        {"extract", restore_noisy, extract_reference, extract_optimized, {"reference", "optimized"}},
+        {"correct", restore_noisy, correct_reference, correct_optimized, {"reference", "optimized"}},
+        {"encode", NULL, encode_reference, encode_optimized, {"reference", "optimized"}},
+        {"encode-stores", NULL, encode_cached, encode_streaming, {"cached", "streaming"}},
+        {"decode", restore_noisy, decode_reference, decode_optimized, {"reference", "optimized"}},
+};
+
+static int setup(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 struct hamming_arena *arena,
+                 size_t count,
+                 unsigned int flags,
+                 struct kernel_data *data);
+
+static int check(struct kernel_data *data);
+
+static double measure(struct kernel_data *data, kernel_fn prepare, kernel_fn kernel, double *p99, double *times);
+
+static int compare_times(const void *a, const void *b);
+
+int main(int argc, char *argv[]) {
+    struct dc_posix_env env;
+    struct dc_error err;
+    struct hamming_arena arena = {0};
+    double *times;
+    unsigned int flags = 0;
+    bool all_sizes = true;
+
+    dc_error_init(&err, bench_error_reporter);
+    dc_posix_env_init(&env, NULL);
+    times = dc_malloc(&env, &err, MAX_REPETITIONS * sizeof(double));
+
+    if (times == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    for (int arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "huge") == 0) {
+            flags |= HAMMING_ARENA_HUGE_PAGES;
+        } else {
+            all_sizes = false;
+        }
+    }
+
+    printf("# %-5s %-13s %-10s %12s %12s %10s %8s\n", "size", "kernel", "impl", "median ns/B", "p99 ns/B", "MB/s",
+           "speedup");
+
+    for (size_t i = 0; i < sizeof(size_classes) / sizeof(size_classes[0]); i++) {
+        struct kernel_data data;
+        bool selected = all_sizes;
+
+        for (int arg = 1; arg < argc; arg++) {
+            selected = selected || strcmp(argv[arg], size_classes[i].name) == 0;
+        }
+
+        if (!selected) {
+            continue;
+        }
+
+        if (setup(&env, &err, &arena, size_classes[i].count, flags, &data) == -1) {
+            return EXIT_FAILURE;
+        }
+
+        if (check(&data) == -1) {
+            fprintf(stderr, "optimized kernels differ from the reference at %zu characters\n", data.count);
+            return EXIT_FAILURE;
+        }
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+            double reference_p99;
+            double reference = measure(&data, kernels[k].prepare, kernels[k].reference, &reference_p99, times);
+
+            printf("  %-5s %-13s %-10s %12.3f %12.3f %10.1f %8s\n", size_classes[i].name, kernels[k].name,
+                   kernels[k].labels[0], reference * 1e9 / (double) data.count, reference_p99 * 1e9 / (double) data.count,
+                   (double) data.count / reference / 1e6, "");
+
+            if (kernels[k].optimized != NULL) {
+                double optimized_p99;
+                double optimized = measure(&data, kernels[k].prepare, kernels[k].optimized, &optimized_p99, times);
+
+                printf("  %-5s %-13s %-10s %12.3f %12.3f %10.1f %7.1fx\n", size_classes[i].name, kernels[k].name,
+                       kernels[k].labels[1], optimized * 1e9 / (double) data.count,
+                       optimized_p99 * 1e9 / (double) data.count, (double) data.count / optimized / 1e6,
+                       reference / optimized);
+            } else {
+                printf("  %-5s %-13s %-10s %12s %12s %10s %8s\n", size_classes[i].name, kernels[k].name,
+                       kernels[k].labels[1],
+                       "-", "-", "-", "-");
+            }
+
+            fflush(stdout);
+        }
+    }
+
+    dc_free(&env, times, MAX_REPETITIONS * sizeof(double));
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(&env, &arena);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int setup(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 struct hamming_arena *arena,
+                 size_t count,
+                 unsigned int flags,
+                 struct kernel_data *data) {
+    struct hamming_channel channel;
+    size_t nbytes = count / BITS_PER_BYTE;
+
+    data->count = count;
+    data->parity = 0;
+    data->plane_bytes = nbytes;
+
+    if (hamming_arena_reserve(env, err, arena,
+                              hamming_buffers_arena_size(count) + 2 * BITS_INC_HAMMING * hamming_arena_align(nbytes) +
+                              2 * hamming_arena_align(BITS_INC_HAMMING * count) + hamming_arena_align(count), flags) == -1 ||
+        hamming_buffers_init(arena, &data->buffers, count) == -1) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        data->clean[index] = hamming_arena_alloc(arena, nbytes);
+        data->noisy[index] = hamming_arena_alloc(arena, nbytes);
+    }
+
+    data->unpacked = hamming_arena_alloc(arena, BITS_INC_HAMMING * count);
+    data->unpacked_noisy = hamming_arena_alloc(arena, BITS_INC_HAMMING * count);
+    data->expected = hamming_arena_alloc(arena, count);
+
+    // the same random characters for every size
+    hamming_channel_init(&channel, HAMMING_CHANNEL_UNIFORM, DECODE_BER, 0, SEED);
+
+    for (size_t i = 0; i < count; i++) {
+        data->buffers.chars[i] = (uint8_t) (hamming_channel_random(&channel) >> 56);
+    }
+
+    // the reference encode also leaves the unpacked bits the parity and pack kernels start from
+    hamming_encode_chunk_reference(&data->buffers, count, data->parity);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        memcpy(data->clean[index], data->buffers.planes[index], nbytes);
+        memcpy(data->noisy[index], data->buffers.planes[index], nbytes);
+        hamming_channel_apply(&channel, data->noisy[index], nbytes);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            insertItemToArray(i, index, nbytes, count, data->noisy[index], data->unpacked_noisy + BITS_INC_HAMMING * i,
+                              data->unpacked_noisy + BITS_INC_HAMMING * i + BITS_PER_BYTE);
+        }
+    }
+
+    return 0;
+}
+
+static int check(struct kernel_data *data) {
+    struct hamming_decode_stats reference;
+
+    encode_optimized(data);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (memcmp(data->buffers.planes[index], data->clean[index], data->plane_bytes) != 0) {
+            return -1;
+        }
+    }
+
+    encode_streaming(data);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (memcmp(data->buffers.planes[index], data->clean[index], data->plane_bytes) != 0) {
+            return -1;
+        }
+    }
+
+    restore_noisy(data);
+    decode_reference(data);
+    reference = data->stats;
+    memcpy(data->expected, data->buffers.chars, data->count);
+    restore_noisy(data);
+    decode_optimized(data);
+
+    if (memcmp(data->expected, data->buffers.chars, data->count) != 0 || reference.corrected != data->stats.corrected ||
+        reference.uncorrectable != data->stats.uncorrectable) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static double measure(struct kernel_data *data, kernel_fn prepare, kernel_fn kernel, double *p99, double *times) {
+    size_t repetitions;
+    double start;
+    double once;
+
+    // the warm-up run also sizes the number of repetitions
+    if (prepare != NULL) {
+        prepare(data);
+    }
+
+    start = hamming_clock_now();
+    kernel(data);
+    once = hamming_clock_now() - start;
+    repetitions = once > 0.0 ? (size_t) (TARGET_SECONDS / once) : MAX_REPETITIONS;
+    repetitions = repetitions < MIN_REPETITIONS ? MIN_REPETITIONS : repetitions;
+    repetitions = repetitions > MAX_REPETITIONS ? MAX_REPETITIONS : repetitions;
+
+    for (size_t i = 0; i < repetitions; i++) {
+        if (prepare != NULL) {
+            prepare(data);
+        }
+
+        start = hamming_clock_now();
+        kernel(data);
+        times[i] = hamming_clock_now() - start;
+    }
+
+    qsort(times, repetitions, sizeof(double), compare_times);
+    *p99 = times[(repetitions * 99 + 99) / 100 - 1];
+
+    return times[repetitions / 2];
+}
+
+static int compare_times(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+static void restore_clean(struct kernel_data *data) {
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        memcpy(data->buffers.planes[index], data->clean[index], data->plane_bytes);
+    }
+}
+
+static void restore_noisy(struct kernel_data *data) {
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        memcpy(data->buffers.planes[index], data->noisy[index], data->plane_bytes);
+    }
+
+    memcpy(data->unpacked, data->unpacked_noisy, BITS_INC_HAMMING * data->count);
+    memset(&data->stats, 0, sizeof(data->stats));
+}
+
+static void bits_reference(struct kernel_data *data) {
+    uint8_t array_of_bits[BITS_PER_BYTE];
+
+    for (size_t i = 0; i < data->count; i++) {
+        generate_array_of_bits_from_character(array_of_bits, BITS_PER_BYTE, data->buffers.chars[i]);
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            data->buffers.bits[index][i] = array_of_bits[index];
+        }
+    }
+}
+
+static void bits_optimized(struct kernel_data *data) {
+    // goes straight to the packed planes, so it also does the work of pack
+    hamming_transpose_chars(data->buffers.chars, data->count, data->buffers.planes);
+}
+
+static void parity_reference(struct kernel_data *data) {
+    uint8_t array_of_bits[BITS_PER_BYTE];
+    uint8_t array_hamming[NUMBER_HAMMING_BITS];
+
+    for (size_t i = 0; i < data->count; i++) {
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            array_of_bits[index] = data->buffers.bits[index][i];
+        }
+
+        generate_array_of_hamming_bits(array_hamming, array_of_bits, data->parity);
+
+        for (size_t index = 0; index < NUMBER_HAMMING_BITS; index++) {
+            data->buffers.bits[BITS_PER_BYTE + index][i] = array_hamming[index];
+        }
+    }
+}
+
+static void parity_optimized(struct kernel_data *data) {
+    hamming_parity_planes(data->buffers.planes, data->count, data->parity);
+}
+
+static void pack_reference(struct kernel_data *data) {
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        pack_plane(data->buffers.bits[index], data->count, data->buffers.planes[index]);
+    }
+}
+
+static void extract_reference(struct kernel_data *data) {
+    size_t nbytes = data->plane_bytes;
+
+    for (size_t i = 0; i < data->count; i++) {
+        uint8_t *unpacked = data->unpacked + BITS_INC_HAMMING * i;
+
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            insertItemToArray(i, index, nbytes, data->count, data->buffers.planes[index], unpacked,
+                              unpacked + BITS_PER_BYTE);
+        }
+    }
+}
+
+static void extract_optimized(struct kernel_data *data) {
+    hamming_transpose_planes((const uint8_t *const *) data->buffers.planes, data->count, data->buffers.chars);
+}
+
+static void correct_reference(struct kernel_data *data) {
+    for (size_t i = 0; i < data->count; i++) {
+        uint8_t *unpacked = data->unpacked + BITS_INC_HAMMING * i;
+
+        switch (handleErrorDetection(data->parity, unpacked, unpacked + BITS_PER_BYTE, &data->buffers.chars[i])) {
+            case HAMMING_CLEAN:
+                break;
+            case HAMMING_CORRECTED:
+                data->stats.corrected++;
+                break;
+            case HAMMING_UNCORRECTABLE:
+                data->stats.uncorrectable++;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void correct_optimized(struct kernel_data *data) {
+    hamming_correct_planes(data->buffers.planes, data->count, data->parity, &data->stats);
+}
+
+static void encode_reference(struct kernel_data *data) {
+    hamming_encode_chunk_reference(&data->buffers, data->count, data->parity);
+}
+
+static void encode_optimized(struct kernel_data *data) {
+    hamming_encode_chunk(&data->buffers, data->count, data->parity);
+}
+
+static void encode_cached(struct kernel_data *data) {
+    // what hamming_encode_chunk does for a chunk that fits in the cache, whatever the size
+    hamming_transpose_chars(data->buffers.chars, data->count, data->buffers.planes);
+    hamming_parity_planes(data->buffers.planes, data->count, data->parity);
+}
+
+static void encode_streaming(struct kernel_data *data) {
+    hamming_encode_chunk_streaming(&data->buffers, data->count, data->parity);
+}
+
+static void decode_reference(struct kernel_data *data) {
+    hamming_decode_chunk_reference(&data->buffers, data->count, data->parity, &data->stats);
+}
+
+static void decode_optimized(struct kernel_data *data) {
+    hamming_decode_chunk(&data->buffers, data->count, data->parity, &data->stats);
+}
@@ -0,0 +1,200 @@
+/*
+ * Throughput and hardware counters of the encode and decode paths.
+ *
+ * Encodes a random payload to plane files and decodes it back, with and without
+ * verification, reading the CPU's counters around every run. Counts are per input byte, so
+ * branch misses per byte point straight at the bit-by-bit kernels:
+ *
+ *     hamming_path_bench [SIZE] [DIRECTORY] [THREADS]
+ *
+ * Counters that cannot be opened, in a container or with a strict perf_event_paranoid, are
+ * shown as "-" and only the time is measured.
+ */
+
+#include "bench.h"
+#include "hamming_arena.h"
+#include "hamming_clock.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include "hamming_options.h"
+#include "hamming_pipeline.h"
+#include "perf.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Payload size when none is given.
+ */
+#define DEFAULT_SIZE ((size_t) 16 * 1024 * 1024)
+
+/**
+ * Room for the longest file name the benchmark adds to its directory.
+ */
+#define NAME_SIZE sizeof("/output")
+
+/**
+ * Timed runs of every path, after one untimed run to warm the caches.
+ */
+#define REPETITIONS 5
+
+/**
+ * Seed of the payload.
+ */
+#define SEED 1
+
+/**
+ * The paths measured.
+ */
+enum path {
+    PATH_ENCODE,
+    PATH_DECODE,
+    PATH_EXTRACT, // decode without verification
+    PATH_COUNT
+};
+
+static const char *const path_names[PATH_COUNT] = {"encode", "decode", "extract"};
+
+/**
+ * What a run needs.
+ */
+struct bench {
+    struct dc_posix_env env;
+    struct dc_error err;
+    struct hamming_arena arena;
+    struct perf_counters counters;
+    size_t threads;
+    char input[PATH_MAX + NAME_SIZE];
+    char output[PATH_MAX + NAME_SIZE];
+    char prefix[PATH_MAX + NAME_SIZE];
+};
+
+static int run_path(struct bench *bench, enum path path, double *seconds);
+
+int main(int argc, char *argv[]) {
+    struct bench bench = {0};
+    char dir[PATH_MAX];
+    size_t size = DEFAULT_SIZE;
+    size_t available;
+    int ret_val = EXIT_FAILURE;
+
+    dc_error_init(&bench.err, bench_error_reporter);
+    dc_posix_env_init(&bench.env, NULL);
+
+    if ((argc > 1 && hamming_parse_size(argv[1], &size) == -1) ||
+        (argc > 3 && hamming_parse_count(argv[3], HAMMING_PIPELINE_MAX_WORKERS, &bench.threads) == -1)) {
+        fprintf(stderr, "usage: %s [SIZE] [DIRECTORY] [THREADS]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (bench_make_dir(argc > 2 ? argv[2] : NULL, dir, sizeof(dir)) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    snprintf(bench.input, sizeof(bench.input), "%s/input", dir);
+    snprintf(bench.output, sizeof(bench.output), "%s/output", dir);
+    snprintf(bench.prefix, sizeof(bench.prefix), "%s/planes", dir);
+    available = perf_open(&bench.counters);
+
+    if (bench_write_payload(&bench.env, &bench.err, bench.input, size, SEED) == -1) {
+        goto done;
+    }
+
+    printf("# %zu bytes, %zu threads, best of %d runs, %zu of %d hardware counters\n", size, bench.threads,
+           REPETITIONS, available, PERF_COUNTERS);
+    printf("# %-7s %10s", "path", "MB/s");
+    perf_print_header(stdout);
+    printf("\n");
+
+    // every path reads what the one before it wrote, the encode comes first
+    for (int path = 0; path < PATH_COUNT; path++) {
+        struct perf_counters best;
+        double best_seconds = 0.0;
+        double seconds;
+
+        if (run_path(&bench, (enum path) path, &seconds) == -1) {
+            goto done;
+        }
+
+        for (int i = 0; i < REPETITIONS; i++) {
+            perf_start(&bench.counters);
+
+            if (run_path(&bench, (enum path) path, &seconds) == -1) {
+                goto done;
+            }
+
+            perf_stop(&bench.counters);
+
+            if (i == 0 || seconds < best_seconds) {
+                best_seconds = seconds;
+                best = bench.counters;
+            }
+        }
+
+        printf("  %-7s %10.1f", path_names[path], (double) size / best_seconds / 1e6);
+        perf_print(stdout, &best, size);
+        printf("\n");
+        fflush(stdout);
+    }
+
+    ret_val = EXIT_SUCCESS;
+
+done:
+    perf_close(&bench.counters);
+    bench_remove_planes(bench.prefix);
+    unlink(bench.input);
+    unlink(bench.output);
+    rmdir(dir);
+
+    if (bench.arena.base != NULL) {
+        hamming_arena_destroy(&bench.env, &bench.arena);
+    }
+
+    return ret_val;
+}
+
+static int run_path(struct bench *bench, enum path path, double *seconds) {
+    struct hamming_encode_options encode;
+    struct hamming_decode_options decode;
+    struct hamming_encode_stats encode_stats = {0};
+    struct hamming_decode_stats decode_stats = {0};
+    double start;
+    int ret_val;
+    int fd;
+
+    hamming_encode_options_init(&encode);
+    encode.binary = true;
+    encode.threads = bench->threads;
+    hamming_decode_options_init(&decode);
+    decode.binary = true;
+    decode.threads = bench->threads;
+    decode.verify = path != PATH_EXTRACT;
+
+    if (path == PATH_ENCODE) {
+        fd = dc_open(&bench->env, &bench->err, bench->input, DC_O_RDONLY, 0);
+    } else {
+        fd = dc_open(&bench->env, &bench->err, bench->output, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY,
+                     S_IRUSR | S_IWUSR);
+    }
+
+    if (dc_error_has_error(&bench->err)) {
+        return -1;
+    }
+
+    start = hamming_clock_now();
+
+    if (path == PATH_ENCODE) {
+        ret_val = hamming_encode(&bench->env, &bench->err, &bench->arena, fd, bench->prefix, &encode, &encode_stats);
+    } else {
+        ret_val = hamming_decode(&bench->env, &bench->err, &bench->arena, bench->prefix, fd, &decode, &decode_stats);
+    }
+
+    *seconds = hamming_clock_now() - start;
+    dc_dc_close(&bench->env, &bench->err, fd);
+
+    return ret_val == -1 || dc_error_has_error(&bench->err) ? -1 : 0;
+}
@@ -0,0 +1,141 @@
+#include "perf.h"
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+static const char *const names[PERF_COUNTERS] = {"cycles/B", "instr/B", "br-miss/B", "L1D-miss/B", "LLC-miss/B"};
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config);
+#endif
+
+size_t perf_open(struct perf_counters *counters) {
+    size_t available = 0;
+
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        counters->fds[i] = -1;
+        counters->values[i] = 0;
+    }
+
+#ifdef __linux__
+    counters->fds[PERF_CYCLES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counters->fds[PERF_INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counters->fds[PERF_BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    counters->fds[PERF_L1D_MISSES] =
+            open_counter(PERF_TYPE_HW_CACHE,
+                         PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    counters->fds[PERF_LLC_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        if (counters->fds[i] != -1) {
+            available++;
+        }
+    }
+
+    return available;
+}
+
+void perf_start(struct perf_counters *counters) {
+#ifdef __linux__
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        if (counters->fds[i] != -1) {
+            ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void) counters;
+#endif
+}
+
+void perf_stop(struct perf_counters *counters) {
+#ifdef __linux__
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        uint64_t read_format[3]; // value, time enabled, time running
+
+        counters->values[i] = 0;
+
+        if (counters->fds[i] == -1) {
+            continue;
+        }
+
+        ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        if (read(counters->fds[i], read_format, sizeof(read_format)) != (ssize_t) sizeof(read_format)) {
+            continue;
+        }
+
+        // with more counters than the PMU has, each one only ran part of the time
+        if (read_format[2] > 0 && read_format[2] < read_format[1]) {
+            read_format[0] = (uint64_t) ((double) read_format[0] * (double) read_format[1] / (double) read_format[2]);
+        }
+
+        counters->values[i] = read_format[0];
+    }
+#else
+    (void) counters;
+#endif
+}
+
+void perf_close(struct perf_counters *counters) {
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        if (counters->fds[i] != -1) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+    }
+}
+
+void perf_print_header(FILE *stream) {
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        fprintf(stream, " %11s", names[i]);
+    }
+
+    fprintf(stream, " %6s", "IPC");
+}
+
+void perf_print(FILE *stream, const struct perf_counters *counters, uint64_t bytes) {
+    for (size_t i = 0; i < PERF_COUNTERS; i++) {
+        if (counters->fds[i] == -1 || bytes == 0) {
+            fprintf(stream, " %11s", "-");
+        } else {
+            fprintf(stream, " %11.3f", (double) counters->values[i] / (double) bytes);
+        }
+    }
+
+    if (counters->fds[PERF_CYCLES] != -1 && counters->fds[PERF_INSTRUCTIONS] != -1 &&
+        counters->values[PERF_CYCLES] > 0) {
+        fprintf(stream, " %6.2f",
+                (double) counters->values[PERF_INSTRUCTIONS] / (double) counters->values[PERF_CYCLES]);
+    } else {
+        fprintf(stream, " %6s", "-");
+    }
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    long fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1; // the pipeline and pool threads started by the measured code count too
+    attr.exclude_kernel = 1; // allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+
+    return fd < 0 ? -1 : (int) fd;
+}
+#endif
@@ -0,0 +1,71 @@
+#ifndef HAMMING_BENCH_PERF_H
+#define HAMMING_BENCH_PERF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * The hardware counters read around a measured region.
+ */
+enum perf_counter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_COUNTERS // number of counters
+};
+
+/**
+ * A set of hardware counters. A counter the kernel or the CPU does not offer, or that the
+ * process is not allowed to open, stays unavailable and is reported as such; the measured
+ * code runs the same either way.
+ */
+struct perf_counters {
+    int fds[PERF_COUNTERS];         // -1 for an unavailable counter
+    uint64_t values[PERF_COUNTERS]; // counts of the last region, scaled if the counter was multiplexed
+};
+
+/**
+ * Opens every counter that can be opened for the calling process and the threads it starts
+ * afterwards. The counters are stopped until perf_start.
+ * @param counters the counters to open
+ * @return the number of counters available
+ */
+size_t perf_open(struct perf_counters *counters);
+
+/**
+ * Resets the counters and starts counting.
+ * @param counters the counters
+ */
+void perf_start(struct perf_counters *counters);
+
+/**
+ * Stops counting and reads the counts of the region since perf_start into values.
+ * @param counters the counters
+ */
+void perf_stop(struct perf_counters *counters);
+
+/**
+ * Closes every counter.
+ * @param counters the counters
+ */
+void perf_close(struct perf_counters *counters);
+
+/**
+ * Writes the column headers matching perf_print.
+ * @param stream where to write
+ */
+void perf_print_header(FILE *stream);
+
+/**
+ * Writes the counts of the last region per byte processed, "-" for an unavailable counter.
+ * @param stream where to write
+ * @param counters the counters
+ * @param bytes the bytes processed in the region
+ */
+void perf_print(FILE *stream, const struct perf_counters *counters, uint64_t bytes);
+
+#endif // HAMMING_BENCH_PERF_H
@@ -0,0 +1,68 @@
+#ifndef HAMMING_ARCHIVE_H
+#define HAMMING_ARCHIVE_H
+
+#include "hamming_arena.h"
+#include "hamming_batch.h"
+#include "hamming_codec.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdint.h>
+
+/**
+ * Bytes of each plane collected before they are written, so many small members share a
+ * write.
+ */
+#define HAMMING_ARCHIVE_STAGE_SIZE ((size_t) 256 * 1024)
+
+/**
+ * Encodes many messages into the twelve plane files of one prefix, one after another, so
+ * they cost one plane set rather than one each. Every job of the batch is a member: its
+ * input is the message file and its output the member id, a decimal number. A member
+ * starts on a plane byte boundary, a multiple of 8 characters. The "<prefix>.index" file
+ * maps the ids, sorted, to where the members start, their length and their parity, and the
+ * sidecar records the length of the whole plane set but no parity. Either every member is
+ * archived or the archive fails.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk and stage buffers, reserved (and reused) as needed
+ * @param batch the members to archive
+ * @param prefix the prefix of the plane files
+ * @param options how to encode, only the parity, text or binary, chunk size, durability and
+ *                huge pages apply
+ * @param stats counters to add the result of every member to
+ * @return 0 on success, -1 on failure or if a member id is not a number or appears twice
+ */
+int hamming_archive_encode(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           struct hamming_arena *arena,
+                           const struct hamming_batch *batch,
+                           const char *prefix,
+                           const struct hamming_encode_options *options,
+                           struct hamming_encode_stats *stats);
+
+/**
+ * Decodes one member of an archive: a binary search of the index, then reads of just the
+ * member's bytes from each plane. One missing or short plane file is rebuilt from the
+ * others, as in hamming_decode.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the archive
+ * @param id the id of the member
+ * @param out_fd the file descriptor to write the member to
+ * @param options how to decode, the parity comes from the index
+ * @param stats counters to add the result of every character to
+ * @return 0 on success, -1 on failure or if the archive has no such member
+ */
+int hamming_archive_decode(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           struct hamming_arena *arena,
+                           const char *prefix,
+                           uint64_t id,
+                           int out_fd,
+                           const struct hamming_decode_options *options,
+                           struct hamming_decode_stats *stats);
+
+#endif // HAMMING_ARCHIVE_H
@@ -0,0 +1,111 @@
+#ifndef HAMMING_ARENA_H
+#define HAMMING_ARENA_H
+
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Alignment of every allocation handed out by an arena, one cache line.
+ */
+#define HAMMING_ARENA_ALIGNMENT 64
+
+/**
+ * Alignment of the start of an arena, one page, so pieces can be aligned for direct I/O.
+ */
+#define HAMMING_ARENA_BASE_ALIGNMENT 4096
+
+/**
+ * Size of a huge page.
+ */
+#define HAMMING_HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+/**
+ * Back the arena with reserved huge pages when the system has them, otherwise with memory
+ * aligned to a huge page and advised for transparent huge pages, otherwise normal pages.
+ */
+#define HAMMING_ARENA_HUGE_PAGES 0x01U
+
+/**
+ * A block of memory that is allocated once per run and handed out in aligned pieces.
+ * Nothing is freed individually, the arena is reset or destroyed as a whole.
+ */
+struct hamming_arena {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    bool mapped; // base came from mmap rather than posix_memalign
+};
+
+/**
+ * Allocates the memory of an arena.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena to set up
+ * @param size the number of bytes the arena can hand out
+ * @param flags 0 or HAMMING_ARENA_HUGE_PAGES
+ * @return 0 on success, -1 on failure
+ */
+int hamming_arena_init(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       size_t size,
+                       unsigned int flags);
+
+/**
+ * Makes sure an arena can hand out at least size bytes and resets it. The memory is only
+ * reallocated when the arena is too small, so an arena reused across requests of similar
+ * size allocates once. The arena must be zeroed before its first use.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena to reserve
+ * @param size the number of bytes the arena must be able to hand out
+ * @param flags 0 or HAMMING_ARENA_HUGE_PAGES, only used when the memory is reallocated
+ * @return 0 on success, -1 on failure
+ */
+int hamming_arena_reserve(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          size_t size,
+                          unsigned int flags);
+
+/**
+ * Hands out the next aligned piece of an arena.
+ * @param arena the arena to allocate from
+ * @param size the number of bytes needed
+ * @return the memory, or NULL if the arena does not have size bytes left
+ */
+void *hamming_arena_alloc(struct hamming_arena *arena, size_t size);
+
+/**
+ * Hands out the next piece of an arena with a stricter alignment than the default.
+ * @param arena the arena to allocate from
+ * @param size the number of bytes needed
+ * @param alignment a power of two, at most HAMMING_ARENA_BASE_ALIGNMENT
+ * @return the memory, or NULL if the arena does not have size bytes left
+ */
+void *hamming_arena_alloc_aligned(struct hamming_arena *arena, size_t size, size_t alignment);
+
+/**
+ * Makes all of the arena available again, invalidating everything it handed out.
+ * @param arena the arena to reset
+ */
+void hamming_arena_reset(struct hamming_arena *arena);
+
+/**
+ * Releases the memory of an arena.
+ * @param env Current working environment
+ * @param arena the arena to release
+ */
+void hamming_arena_destroy(const struct dc_posix_env *env, struct hamming_arena *arena);
+
+/**
+ * Rounds a size up to the arena alignment.
+ * @param size the size to round
+ * @return the rounded size
+ */
+size_t hamming_arena_align(size_t size);
+
+#endif // HAMMING_ARENA_H
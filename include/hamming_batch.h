@@ -0,0 +1,109 @@
+#ifndef HAMMING_BATCH_H
+#define HAMMING_BATCH_H
+
+#include "hamming_codec.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Longest error message kept for a failed job.
+ */
+#define HAMMING_BATCH_MESSAGE_SIZE 256
+
+/**
+ * Which way the jobs of a batch go.
+ */
+enum hamming_batch_mode {
+    HAMMING_BATCH_ENCODE, // input is a message file, output a plane prefix
+    HAMMING_BATCH_DECODE  // input is a plane prefix, output a message file
+};
+
+/**
+ * One line of a manifest and, once run, its result.
+ */
+struct hamming_batch_job {
+    const char *input;
+    const char *output;
+    int parity;                        // 0 for even, 1 for odd, -1 for the parity of the batch
+    bool ok;
+    uint64_t characters;               // characters encoded or decoded
+    struct hamming_decode_stats stats; // decoding results
+    struct hamming_flush_stats flush;  // cost of the durability mode, encoding only
+    double seconds;
+    char message[HAMMING_BATCH_MESSAGE_SIZE]; // why the job failed
+};
+
+/**
+ * The jobs of a manifest. The job strings point into text.
+ */
+struct hamming_batch {
+    char *text;
+    size_t text_size;
+    struct hamming_batch_job *jobs;
+    size_t count;
+    size_t capacity;
+    struct hamming_flush_stats flush; // the barriers shared by all jobs
+};
+
+/**
+ * How the jobs of a batch are run. Each job runs on one worker, with the encode or decode
+ * options of the batch.
+ */
+struct hamming_batch_config {
+    enum hamming_batch_mode mode;
+    size_t workers; // pool threads, 0 for one per online processor
+    struct hamming_encode_options encode;
+    struct hamming_decode_options decode;
+};
+
+/**
+ * Reads a manifest. Every line names an input and an output separated by whitespace, and
+ * optionally "even" or "odd" to override the parity for that job. Blank lines and
+ * everything after a '#' are ignored.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param path the manifest to read
+ * @param batch the batch to fill
+ * @return 0 on success, -1 on failure
+ */
+int hamming_batch_load(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *path,
+                       struct hamming_batch *batch);
+
+/**
+ * Runs every job of a batch on a work-stealing pool. A failing job does not stop the others.
+ * When encoding in batched or syncfs durability mode the jobs issue no flush barrier of their
+ * own, batched jobs only start the write back of their planes, and one syncfs per file system
+ * holding outputs makes all of them durable at the end.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param batch the jobs to run, their results are filled in
+ * @param config how to run the jobs
+ * @return the number of failed jobs, or -1 if the batch could not be run
+ */
+int hamming_batch_run(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_batch *batch,
+                      const struct hamming_batch_config *config);
+
+/**
+ * Prints one line per job and the totals of a batch to stdout.
+ * @param batch the batch that was run
+ * @param seconds the wall time of the whole batch
+ */
+void hamming_batch_report(const struct hamming_batch *batch, double seconds);
+
+/**
+ * Releases the memory of a batch.
+ * @param env Current working environment
+ * @param batch the batch to release
+ */
+void hamming_batch_destroy(const struct dc_posix_env *env, struct hamming_batch *batch);
+
+#endif // HAMMING_BATCH_H
@@ -0,0 +1,63 @@
+#ifndef HAMMING_CACHE_H
+#define HAMMING_CACHE_H
+
+#include "hamming_arena.h"
+#include "hamming_codec.h"
+#include "hamming_decode.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Starts every cache entry, followed by the rest of the entry header.
+ */
+#define HAMMING_CACHE_MAGIC "HDC1"
+
+/**
+ * Ends the name of every cache entry, "<hash>.hdc", the only files eviction touches.
+ */
+#define HAMMING_CACHE_SUFFIX ".hdc"
+
+/**
+ * Most bytes the cache holds when no size is given.
+ */
+#define HAMMING_CACHE_DEFAULT_SIZE ((size_t) 1024 * 1024 * 1024)
+
+/**
+ * Decodes a plane set through the cache in options->cache_dir. An entry is the decoded
+ * output of one prefix with one parity, output mode and verify setting, together with the
+ * device, inode, size and modification time of the twelve plane files and the sidecar it
+ * was decoded from. When all of them still match, the output and the decode stats are
+ * copied from the entry and no plane is read. Otherwise the plane set is decoded into a new
+ * entry, which replaces the stale one, and then copied out; the least recently used entries
+ * are evicted once the cache is larger than options->cache_size. A decode that repairs a
+ * plane changes the plane set it reads, so it bypasses the cache.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the plane files
+ * @param out_fd the file descriptor to write the message to
+ * @param options how to decode, cache_dir must be set
+ * @param stats counters to add the result of every character to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_cache_decode(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         const char *prefix,
+                         int out_fd,
+                         const struct hamming_decode_options *options,
+                         struct hamming_decode_stats *stats);
+
+/**
+ * Removes the least recently used entries until the cache holds at most size bytes.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param dir the cache directory
+ * @param size the most bytes the entries may take
+ * @return 0 on success, -1 if the directory cannot be read
+ */
+int hamming_cache_evict(const struct dc_posix_env *env, struct dc_error *err, const char *dir, size_t size);
+
+#endif // HAMMING_CACHE_H
@@ -0,0 +1,103 @@
+#ifndef HAMMING_CHANNEL_H
+#define HAMMING_CHANNEL_H
+
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bits flipped in a row by one burst when none is configured.
+ */
+#define HAMMING_CHANNEL_DEFAULT_BURST 16
+
+/**
+ * How a noisy channel damages what goes through it.
+ */
+enum hamming_channel_mode {
+    HAMMING_CHANNEL_UNIFORM, // every bit flips independently at the error rate
+    HAMMING_CHANNEL_BURST,   // runs of burst_length bits flip together, at the same average rate
+    HAMMING_CHANNEL_PLANE    // one whole plane is lost, the bits of the others are left alone
+};
+
+/**
+ * A simulated noisy channel. Errors are placed by drawing the gap to the next one from a
+ * geometric distribution, so the cost is per error rather than per bit, and the gap carries
+ * over from one buffer to the next as if they were one stream.
+ */
+struct hamming_channel {
+    enum hamming_channel_mode mode;
+    double rate;         // average fraction of the bits flipped
+    size_t burst_length; // bits flipped in a row by one burst
+    uint64_t rng[4];     // xoshiro256** state
+    uint64_t gap;        // bits left alone before the next error or burst, UINT64_MAX for none
+    size_t burst_left;   // bits of the current burst still to flip
+    uint64_t flipped;    // bits flipped so far
+};
+
+/**
+ * Parses a channel mode, "uniform", "burst" or "plane".
+ * @param env Current working environment
+ * @param str the string to parse
+ * @param mode receives the mode
+ * @return 0 on success, -1 if str is not a mode
+ */
+int hamming_channel_parse(const struct dc_posix_env *env, const char *str, enum hamming_channel_mode *mode);
+
+/**
+ * Sets up a channel. The same seed gives the same errors.
+ * @param channel the channel to initialize
+ * @param mode how the channel damages bits
+ * @param rate the bit error rate, from 0 to 1
+ * @param burst_length bits flipped in a row in burst mode, 0 for the default
+ * @param seed the seed of the random number generator
+ */
+void hamming_channel_init(struct hamming_channel *channel,
+                          enum hamming_channel_mode mode,
+                          double rate,
+                          size_t burst_length,
+                          uint64_t seed);
+
+/**
+ * Draws the next number of the channel's random number generator.
+ * @param channel the channel
+ * @return 64 random bits
+ */
+uint64_t hamming_channel_random(struct hamming_channel *channel);
+
+/**
+ * Sends a buffer through the channel, flipping its bits in place. Plane mode leaves the
+ * buffer alone, see hamming_channel_lose_plane.
+ * @param channel the channel
+ * @param buf the bytes to damage
+ * @param size the number of bytes
+ */
+void hamming_channel_apply(struct hamming_channel *channel, uint8_t *buf, size_t size);
+
+/**
+ * Picks the plane a plane mode channel loses.
+ * @param channel the channel
+ * @param planes mask of the planes that can be lost, not 0
+ * @return the index of the lost plane
+ */
+size_t hamming_channel_lose_plane(struct hamming_channel *channel, unsigned int planes);
+
+/**
+ * Sends the plane files of a prefix through the channel, in place and in plane order.
+ * Planes without a file are skipped. In plane mode one of the plane files is removed
+ * instead.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param channel the channel
+ * @param lost receives the removed plane, BITS_INC_HAMMING if none
+ * @return 0 on success, -1 on failure
+ */
+int hamming_channel_planes(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *prefix,
+                           struct hamming_channel *channel,
+                           size_t *lost);
+
+#endif // HAMMING_CHANNEL_H
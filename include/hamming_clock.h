@@ -0,0 +1,10 @@
+#ifndef HAMMING_CLOCK_H
+#define HAMMING_CLOCK_H
+
+/**
+ * Gets the current time of the monotonic clock, for measuring how long something took.
+ * @return the time in seconds
+ */
+double hamming_clock_now(void);
+
+#endif // HAMMING_CLOCK_H
@@ -0,0 +1,333 @@
+#ifndef HAMMING_CODEC_H
+#define HAMMING_CODEC_H
+
+#include "hamming_arena.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NUMBER_HAMMING_BITS 4
+#define BITS_PER_BYTE 8
+#define BITS_INC_HAMMING 12
+#define B10000000 UINT8_C(0x80)
+#define B01000000 UINT8_C(0x40)
+#define B00100000 UINT8_C(0x20)
+#define B00010000 UINT8_C(0x10)
+#define B00001000 UINT8_C(0x08)
+#define B00000100 UINT8_C(0x04)
+#define B00000010 UINT8_C(0x02)
+#define B00000001 UINT8_C(0x01)
+
+/**
+ * Number of characters encoded or decoded per chunk when none is configured.
+ */
+#define HAMMING_DEFAULT_CHUNK_SIZE ((size_t) 64 * 1024)
+
+/**
+ * Alignment and size granularity of the packed plane buffers, the block size O_DIRECT needs.
+ */
+#define HAMMING_PLANE_ALIGNMENT ((size_t) 4096)
+
+/**
+ * Size assumed for the last level cache when the system does not report it.
+ */
+#define HAMMING_DEFAULT_LLC_SIZE ((size_t) 8 * 1024 * 1024)
+
+/**
+ * Result of checking the parity bits of a single character.
+ */
+enum hamming_check {
+    HAMMING_CLEAN,
+    HAMMING_CORRECTED,
+    HAMMING_UNCORRECTABLE
+};
+
+/**
+ * Which stores hamming_encode_chunk writes the planes with.
+ */
+enum hamming_store_kernel {
+    HAMMING_STORES_AUTO,     // streaming once a chunk and its planes are larger than the last level cache
+    HAMMING_STORES_CACHED,   // always through the cache
+    HAMMING_STORES_STREAMING // always hamming_encode_chunk_streaming
+};
+
+/**
+ * Counters collected while decoding.
+ */
+struct hamming_decode_stats {
+    uint64_t characters;
+    uint64_t corrected;
+    uint64_t uncorrectable;
+    unsigned int erased; // mask of the planes that were missing and rebuilt from the others
+    bool parity_detected; // the parity was not given but read from the sidecar or found by sampling
+    bool parity_sampled;  // the parity was found by sampling the planes
+    bool parity_mismatch; // sampling found another parity than the sidecar records
+    int parity;           // the parity found, 0 for even, 1 for odd
+};
+
+/**
+ * The buffers needed to encode or decode one chunk. Every buffer is carved out of an arena
+ * once and reused for every chunk.
+ */
+struct hamming_buffers {
+    size_t chunk_size;                 // characters per chunk, a multiple of BITS_PER_BYTE
+    uint8_t *chars;                    // chunk_size + 1 characters, the spare byte lets a reader look ahead
+    uint8_t *bits[BITS_INC_HAMMING];   // chunk_size unpacked bits per plane
+    uint8_t *planes[BITS_INC_HAMMING]; // chunk_size / BITS_PER_BYTE packed bytes per plane, rounded up to
+                                       // HAMMING_PLANE_ALIGNMENT and aligned to it
+};
+
+/**
+ * Rounds a chunk size up to a whole number of plane bytes.
+ * @param chunk_size the requested number of characters per chunk, 0 for the default
+ * @return the chunk size that will be used
+ */
+size_t hamming_chunk_size(size_t chunk_size);
+
+/**
+ * Gets the number of arena bytes needed by hamming_buffers_init.
+ * @param chunk_size the number of characters per chunk, as returned by hamming_chunk_size
+ * @return the arena size needed for one set of buffers
+ */
+size_t hamming_buffers_arena_size(size_t chunk_size);
+
+/**
+ * Carves one set of chunk buffers out of an arena.
+ * @param arena the arena to allocate from
+ * @param buffers the buffers to set up
+ * @param chunk_size the number of characters per chunk, as returned by hamming_chunk_size
+ * @return 0 on success, -1 if the arena is too small
+ */
+int hamming_buffers_init(struct hamming_arena *arena, struct hamming_buffers *buffers, size_t chunk_size);
+
+/**
+ * Encodes count characters from buffers->chars into the twelve plane buffers. Each plane
+ * receives (count + 7) / 8 bytes, the characters of a partial last byte are stored in its
+ * low bits. Eight characters at a time are transposed into the data planes and the parity
+ * planes are computed from those a word at a time, or with hamming_encode_chunk_streaming
+ * when the chunk is larger than the cache or hamming_set_store_kernel says so.
+ * @param buffers the chunk buffers
+ * @param count the number of characters to encode, at most buffers->chunk_size
+ * @param parity 0 for even, 1 for odd
+ */
+void hamming_encode_chunk(struct hamming_buffers *buffers, size_t count, int parity);
+
+/**
+ * Encodes a chunk like hamming_encode_chunk, computing the parity planes along with the data
+ * planes 64 characters at a time and writing all twelve with non-temporal stores where the
+ * CPU has them. Planes that do not fit in the cache then go straight to memory instead of
+ * evicting the characters still to be read. hamming_encode_chunk switches to it by itself
+ * once a chunk and its planes are larger than the last level cache.
+ * @param buffers the chunk buffers
+ * @param count the number of characters to encode, at most buffers->chunk_size
+ * @param parity 0 for even, 1 for odd
+ */
+void hamming_encode_chunk_streaming(struct hamming_buffers *buffers, size_t count, int parity);
+
+/**
+ * Gets the size of the last level cache, read once from the system.
+ * @return the size in bytes, HAMMING_DEFAULT_LLC_SIZE when the system does not say
+ */
+size_t hamming_llc_size(void);
+
+/**
+ * Chooses the stores of hamming_encode_chunk for every thread, HAMMING_STORES_AUTO until set.
+ * @param kernel the stores to use
+ */
+void hamming_set_store_kernel(enum hamming_store_kernel kernel);
+
+/**
+ * Encodes a chunk a character and a bit at a time, the way the planes were first produced.
+ * Kept as the baseline hamming_encode_chunk is measured and checked against; the result is
+ * the same.
+ * @param buffers the chunk buffers
+ * @param count the number of characters to encode, at most buffers->chunk_size
+ * @param parity 0 for even, 1 for odd
+ */
+void hamming_encode_chunk_reference(struct hamming_buffers *buffers, size_t count, int parity);
+
+/**
+ * Decodes count characters from the twelve plane buffers into buffers->chars, correcting
+ * the characters that can be corrected. The data planes are corrected in place a word at a
+ * time and then transposed back into characters.
+ * @param buffers the chunk buffers
+ * @param count the number of characters to decode, at most buffers->chunk_size
+ * @param parity 0 for even, 1 for odd
+ * @param stats counters to add the result of every character to
+ */
+void hamming_decode_chunk(struct hamming_buffers *buffers,
+                          size_t count,
+                          int parity,
+                          struct hamming_decode_stats *stats);
+
+/**
+ * Decodes a chunk a character and a bit at a time with insertItemToArray and
+ * handleErrorDetection. Kept as the baseline hamming_decode_chunk is measured and checked
+ * against; the characters and counters are the same, the planes are left alone.
+ * @param buffers the chunk buffers
+ * @param count the number of characters to decode, at most buffers->chunk_size
+ * @param parity 0 for even, 1 for odd
+ * @param stats counters to add the result of every character to
+ */
+void hamming_decode_chunk_reference(struct hamming_buffers *buffers,
+                                    size_t count,
+                                    int parity,
+                                    struct hamming_decode_stats *stats);
+
+/**
+ * Copies the data bits of count characters from planes 0 to 7 into buffers->chars without
+ * looking at the parity planes, so nothing is checked or corrected.
+ * @param buffers the chunk buffers, only planes 0 to 7 need to be filled
+ * @param count the number of characters to extract, at most buffers->chunk_size
+ * @param stats counters to add the characters to
+ */
+void hamming_extract_chunk(struct hamming_buffers *buffers, size_t count, struct hamming_decode_stats *stats);
+
+/**
+ * Transposes characters into the eight data planes, replacing
+ * generate_array_of_bits_from_character and pack_plane for planes 0 to 7.
+ * @param chars the characters
+ * @param count the number of characters
+ * @param planes receives (count + 7) / 8 bytes in each of planes[0] to planes[7]
+ */
+void hamming_transpose_chars(const uint8_t chars[], size_t count, uint8_t *const planes[]);
+
+/**
+ * Transposes the eight data planes back into characters, replacing insertItemToArray for
+ * planes 0 to 7. Bits past count in a partial last byte are ignored.
+ * @param planes the data planes, planes[0] to planes[7]
+ * @param count the number of characters
+ * @param chars receives count characters
+ */
+void hamming_transpose_planes(const uint8_t *const planes[], size_t count, uint8_t chars[]);
+
+/**
+ * Computes the four parity planes from the eight data planes, replacing
+ * generate_array_of_hamming_bits. Every parity bit of a character is the XOR of data bits in
+ * the same position of other planes, so whole words are computed at once.
+ * @param planes the twelve planes, 0 to 7 filled, 8 to 11 receive the parity bits
+ * @param count the number of characters
+ * @param parity 0 for even, 1 for odd
+ */
+void hamming_parity_planes(uint8_t *const planes[], size_t count, int parity);
+
+/**
+ * Checks and corrects the data planes in place, replacing handleErrorDetection. The four
+ * syndrome bits of 64 characters are computed a word at a time and a data bit is flipped
+ * where exactly two checks fail, as handleErrorDetection does.
+ * @param planes the twelve planes
+ * @param count the number of characters
+ * @param parity 0 for even, 1 for odd
+ * @param stats receives the corrected and uncorrectable characters
+ */
+void hamming_correct_planes(uint8_t *const planes[], size_t count, int parity, struct hamming_decode_stats *stats);
+
+/**
+ * Rebuilds one lost plane of a chunk from the planes that share a parity check with it.
+ * Every character has at most this one erased bit, whose position is known, so the XOR of
+ * the other members of the check gives it back. Whole words of eight plane bytes, 64
+ * characters, are rebuilt at a time.
+ * @param buffers the chunk buffers, every plane but the erased one filled
+ * @param count the number of characters in the chunk
+ * @param parity 0 for even, 1 for odd
+ * @param erased the plane to rebuild, from 0 to 11 (inclusive)
+ */
+void hamming_rebuild_plane(struct hamming_buffers *buffers, size_t count, int parity, size_t erased);
+
+/**
+ * Checks whether every bit of a packed plane is the same.
+ * @param plane the packed plane
+ * @param count the number of characters in the plane
+ * @return 0 or 1 when every bit has that value (0 when count is 0), -1 when they differ
+ */
+int hamming_plane_constant(const uint8_t plane[], size_t count);
+
+/**
+ * Fills a packed plane whose bits are all the same.
+ * @param plane the packed plane
+ * @param count the number of characters in the plane
+ * @param value 0 or 1
+ */
+void hamming_fill_plane(uint8_t plane[], size_t count, int value);
+
+/**
+ * Creates an array of size 8 from a single character that represents that character's
+ * binary value.
+ * @param array_of_bits the array that represents binary value of a character
+ * @param length length bits per byte
+ * @param byte the character to be "binarized"
+ */
+void generate_array_of_bits_from_character(uint8_t array_of_bits[BITS_PER_BYTE], size_t length, uint8_t byte);
+
+/**
+ * Creates and add values to an array of size 4 that represents 4 parity bits of a character.
+ * @param array_of_hamming_bits the array that represents 4 parity bits of a character
+ * @param array_of_bits the array that represents binary value of a character
+ * @param parity value, 0 for even, 1 for odd
+ */
+void generate_array_of_hamming_bits(uint8_t array_of_hamming_bits[NUMBER_HAMMING_BITS],
+                                    uint8_t array_of_bits[BITS_PER_BYTE],
+                                    int parity);
+
+/**
+ * Packs the unpacked bits of one plane into bytes, 8 characters per byte with the first
+ * character in the high bit. The characters of a partial last byte are stored in its low bits.
+ * @param bits one unpacked bit (0 or 1) per character
+ * @param count the number of characters
+ * @param plane receives (count + 7) / 8 packed bytes
+ */
+void pack_plane(const uint8_t bits[], size_t count, uint8_t plane[]);
+
+/**
+ * Inserts items to arrays. At position messageIndex % 8 per nbytes byte (position 0->7)
+ * from index file (0->11 files), extract the bit value of the current position and add it
+ * to array_bits array of bits or add to hamming_bits array of parity bits.
+ * Example, index file from 0 to 7, the bit will be inserted to an array of size 8 to represent a byte of
+ * a letter, index file from 8 to 11, the current bit will be inserted to an array of size 4 to represent
+ * 4 parity bits of the current letter.
+ * @param messageIndex current message index
+ * @param index current file index, from 0 to 11 (inclusive)
+ * @param nbytes value of the current byte working on
+ * @param numOfCharsInMessage number of characters in the message, the last byte holds numOfCharsInMessage % 8 of them
+ * @param word the message taken from the file
+ * @param array_bits array of 8 integers that represent a single byte in a file at position nbytes - 1
+ * @param hamming_bit array of 4 integers that represent 4 parity bits of a letter
+ */
+void insertItemToArray(size_t messageIndex,
+                       size_t index,
+                       size_t nbytes,
+                       size_t numOfCharsInMessage,
+                       const uint8_t word[],
+                       uint8_t array_bits[],
+                       uint8_t hamming_bit[]);
+
+/**
+ * Checks the parity bits of a character and corrects the data bit they point to.
+ * @param parity_int 0 for even, 1 for odd
+ * @param array_bits array of 8 integers that represent the data bits of the character
+ * @param hamming_bits array of 4 integers that represent the parity bits of the character
+ * @param value receives the (corrected) character
+ * @return whether the character was clean, corrected or could not be corrected
+ */
+enum hamming_check handleErrorDetection(int parity_int,
+                                        uint8_t array_bits[],
+                                        const uint8_t hamming_bits[],
+                                        uint8_t *value);
+
+/**
+ * Checks whether a bit is a 1 or a 0. Returns 1 if the bit is 1, 0 if
+ * bit is 0.
+ * @param byteToCheck uint8_t checks whether a bit is 1 or 0
+ * @return 1 if the bit is 1, 0 if the bit is 0
+ */
+uint8_t checkBit1Or0(uint8_t byteToCheck);
+
+/**
+ * Flips the given bit to the opposite. If the given bit is 0, flip it to 1,
+ * and vice versa.
+ * @param bitToFlip uint8_t bit represented in type uint8_t to be flipped
+ * @return uint8_t the bit after flipped
+ */
+uint8_t flipBit(uint8_t bitToFlip);
+
+#endif // HAMMING_CODEC_H
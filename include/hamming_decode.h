@@ -0,0 +1,68 @@
+#ifndef HAMMING_DECODE_H
+#define HAMMING_DECODE_H
+
+#include "hamming_arena.h"
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Parity option that takes the parity the sidecar records, or samples the planes for it
+ * when there is none, see hamming_find_parity.
+ */
+#define HAMMING_PARITY_AUTO (-1)
+
+/**
+ * Parity option that samples the planes for the parity even when the sidecar records one,
+ * to check it.
+ */
+#define HAMMING_PARITY_CHECK (-2)
+
+/**
+ * How a plane set is decoded.
+ */
+struct hamming_decode_options {
+    int parity;        // 0 for even, 1 for odd, HAMMING_PARITY_AUTO or HAMMING_PARITY_CHECK to detect it
+    bool binary;       // write every byte of the recorded length, otherwise only printable characters
+    size_t chunk_size; // characters per chunk, 0 for the default
+    size_t threads;    // decoding workers, 0 to decode on the calling thread
+    bool direct_io;    // bypass the page cache for the plane files
+    bool verify;       // read the parity planes and correct errors, otherwise trust planes 0 to 7
+    bool repair;       // write a plane that was missing or short back once it is rebuilt
+    bool huge_pages;   // back the chunk buffers with huge pages
+    const char *cache_dir; // reuse the output of earlier decodes kept here, NULL for no cache
+    size_t cache_size;     // most bytes the cache may hold
+};
+
+/**
+ * Sets every option to its default value.
+ * @param options the options to initialize
+ */
+void hamming_decode_options_init(struct hamming_decode_options *options);
+
+/**
+ * Decodes the twelve plane files of a prefix and writes the message to a file descriptor.
+ * One plane file that is missing or shorter than the others is an erasure: its bits are
+ * rebuilt from the other eleven planes and its index is added to stats->erased. With a cache
+ * directory the output comes from hamming_cache_decode. An automatic parity is detected
+ * first and recorded in the stats.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the plane files
+ * @param out_fd the file descriptor to write the message to
+ * @param options how to decode
+ * @param stats counters to add the result of every character to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_decode(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   const char *prefix,
+                   int out_fd,
+                   const struct hamming_decode_options *options,
+                   struct hamming_decode_stats *stats);
+
+#endif // HAMMING_DECODE_H
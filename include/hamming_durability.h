@@ -0,0 +1,79 @@
+#ifndef HAMMING_DURABILITY_H
+#define HAMMING_DURABILITY_H
+
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * How hard the encoder works to get the plane files onto stable storage before it returns.
+ */
+enum hamming_durability {
+    HAMMING_DURABILITY_NONE,      // leave the data in the page cache
+    HAMMING_DURABILITY_FDATASYNC, // flush every plane file and the sidecar one after the other
+    HAMMING_DURABILITY_BATCHED,   // write back all planes together, then one flush of the sidecar
+    HAMMING_DURABILITY_SYNCFS     // one flush of the whole file system
+};
+
+/**
+ * What making the output durable cost.
+ */
+struct hamming_flush_stats {
+    uint64_t barriers; // flushes that waited for the device
+    double seconds;    // time spent writing back and flushing
+};
+
+/**
+ * Parses a durability mode, "none", "fdatasync", "batched" or "syncfs".
+ * @param env Current working environment
+ * @param str the string to parse
+ * @param mode receives the mode
+ * @return 0 on success, -1 if str is not a mode
+ */
+int hamming_durability_parse(const struct dc_posix_env *env, const char *str, enum hamming_durability *mode);
+
+/**
+ * Writes back the plane files, called once all planes are written and before they are
+ * closed. Batched mode starts the write back of all twelve files before waiting for any
+ * of them, so the device sees one large batch rather than twelve small ones, and issues no
+ * barrier of its own.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fds the open plane files
+ * @param mode the durability mode
+ * @param deferred a syncfs by the caller makes the planes durable later, so batched mode only
+ *                 starts their write back
+ * @param stats the costs to add to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_durability_planes(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const int fds[BITS_INC_HAMMING],
+                              enum hamming_durability mode,
+                              bool deferred,
+                              struct hamming_flush_stats *stats);
+
+/**
+ * Issues the flush barrier that makes a plane set durable, called once its sidecar is
+ * written. In fdatasync and batched mode the barrier is an fdatasync of the sidecar and an
+ * fsync of the directory naming the plane set. In batched mode that one fdatasync also commits
+ * the sizes and block allocations of the planes written back before it, which holds on file
+ * systems that commit metadata in one ordered journal, such as ext4 and XFS; elsewhere use
+ * fdatasync mode. Striped planes have the directories (or, with syncfs, the file systems) they
+ * were written to flushed as well.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane set
+ * @param mode the durability mode
+ * @param stats the costs to add to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_durability_commit(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *prefix,
+                              enum hamming_durability mode,
+                              struct hamming_flush_stats *stats);
+
+#endif // HAMMING_DURABILITY_H
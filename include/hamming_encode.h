@@ -0,0 +1,62 @@
+#ifndef HAMMING_ENCODE_H
+#define HAMMING_ENCODE_H
+
+#include "hamming_arena.h"
+#include "hamming_durability.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * How a message is encoded.
+ */
+struct hamming_encode_options {
+    int parity;        // 0 for even, 1 for odd
+    bool binary;       // encode every byte, otherwise a trailing newline is dropped
+    size_t chunk_size; // characters per chunk, 0 for the default
+    size_t threads;    // encoding workers, 0 to encode on the calling thread
+    bool direct_io;    // bypass the page cache for the plane files
+    enum hamming_durability durability;
+    bool defer_commit; // leave the flush barrier to the caller, which batches it across messages
+    bool elide_constant; // record planes whose bits are all the same in the sidecar instead of writing them
+    bool sparse;         // leave holes in the plane files where a block has no bit set
+    bool huge_pages;     // back the chunk buffers with huge pages
+};
+
+/**
+ * What encoding a message did.
+ */
+struct hamming_encode_stats {
+    uint64_t characters;              // characters encoded
+    struct hamming_flush_stats flush; // cost of the durability mode
+};
+
+/**
+ * Sets every option to its default value.
+ * @param options the options to initialize
+ */
+void hamming_encode_options_init(struct hamming_encode_options *options);
+
+/**
+ * Encodes everything that can be read from a file descriptor into the twelve plane files
+ * and the metadata sidecar of a prefix.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param in_fd the file descriptor to read the message from
+ * @param prefix the prefix of the plane files
+ * @param options how to encode
+ * @param stats counters to add the result of the message to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_encode(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   int in_fd,
+                   const char *prefix,
+                   const struct hamming_encode_options *options,
+                   struct hamming_encode_stats *stats);
+
+#endif // HAMMING_ENCODE_H
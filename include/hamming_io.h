@@ -0,0 +1,225 @@
+#ifndef HAMMING_IO_H
+#define HAMMING_IO_H
+
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * The open flag that bypasses the page cache, 0 where the system has none.
+ */
+#ifdef O_DIRECT
+#define HAMMING_O_DIRECT O_DIRECT
+#else
+#define HAMMING_O_DIRECT 0
+#endif
+
+/**
+ * Builds the path of one plane file, "<prefix>_<index>.hamming", inside the plane's directory
+ * when the planes are striped, see hamming_stripe_set.
+ * @param prefix the prefix of the plane files
+ * @param index the plane, from 0 to 11 (inclusive)
+ * @param path receives the path
+ * @param size the size of path
+ * @return 0 on success, -1 if the path does not fit
+ */
+int hamming_plane_path(const char *prefix, size_t index, char *path, size_t size);
+
+/**
+ * Opens all twelve plane files. Either all of them are opened or none are.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param oflag the open flags
+ * @param mode the mode for created files
+ * @param fds receives one file descriptor per plane
+ * @return 0 on success, -1 on failure
+ */
+int hamming_open_planes(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        int oflag,
+                        mode_t mode,
+                        int fds[BITS_INC_HAMMING]);
+
+/**
+ * Bit of a plane in a plane set mask.
+ */
+#define HAMMING_PLANE_BIT(index) (1U << (index))
+
+/**
+ * Every plane in a plane set mask.
+ */
+#define HAMMING_ALL_PLANES ((1U << BITS_INC_HAMMING) - 1U)
+
+/**
+ * Opens some of the plane files, the others are marked as closed (-1). Either all of the
+ * requested files are opened or none are.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param planes the planes to open, a mask of HAMMING_PLANE_BIT
+ * @param oflag the open flags
+ * @param mode the mode for created files
+ * @param fds receives one file descriptor per plane
+ * @return 0 on success, -1 on failure
+ */
+int hamming_open_plane_set(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *prefix,
+                           unsigned int planes,
+                           int oflag,
+                           mode_t mode,
+                           int fds[BITS_INC_HAMMING]);
+
+/**
+ * Looks for a plane file that is missing or shorter than it should be. Such a plane is an
+ * erasure: its bits are lost but their position is known, so a single one can be rebuilt
+ * from the other eleven planes.
+ * @param prefix the prefix of the plane files
+ * @param planes the planes that should have a file, a mask of HAMMING_PLANE_BIT
+ * @param length the number of encoded characters, or UINT64_MAX to expect the size of the
+ *               longest plane
+ * @param erased receives the mask of the planes that are missing or short
+ * @return 0 on success, -1 if none of the planes has a file
+ */
+int hamming_find_erasures(const char *prefix, unsigned int planes, uint64_t length, unsigned int *erased);
+
+/**
+ * Closes every open plane file descriptor and marks it as closed (-1).
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fds the plane file descriptors
+ */
+void hamming_close_planes(const struct dc_posix_env *env, struct dc_error *err, int fds[BITS_INC_HAMMING]);
+
+/**
+ * Reads until size bytes have been read or the end of the file is reached. Every read is
+ * paced by the I/O limits, see hamming_throttle_start.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to read
+ * @param buf receives the bytes
+ * @param size the number of bytes wanted
+ * @return the number of bytes read, less than size only at the end of the file, -1 on failure
+ */
+ssize_t hamming_read_fully(const struct dc_posix_env *env, struct dc_error *err, int fd, void *buf, size_t size);
+
+/**
+ * Reads from an offset until size bytes have been read or the end of the file is reached,
+ * without moving the file offset. Every read is paced by the I/O limits.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to read
+ * @param buf receives the bytes
+ * @param size the number of bytes wanted
+ * @param offset the file offset to read from
+ * @return the number of bytes read, less than size only at the end of the file, -1 on failure
+ */
+ssize_t hamming_pread_fully(const struct dc_posix_env *env,
+                            struct dc_error *err,
+                            int fd,
+                            void *buf,
+                            size_t size,
+                            uint64_t offset);
+
+/**
+ * Writes all size bytes, retrying short writes. Every write is paced by the I/O limits.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to write
+ * @param buf the bytes to write
+ * @param size the number of bytes to write
+ * @return 0 on success, -1 on failure
+ */
+int hamming_write_fully(const struct dc_posix_env *env, struct dc_error *err, int fd, const void *buf, size_t size);
+
+/**
+ * Rounds a chunk size up so that every plane of a full chunk is a whole number of
+ * HAMMING_PLANE_ALIGNMENT blocks, keeping the file offsets of direct I/O aligned.
+ * @param chunk_size the number of characters per chunk, as returned by hamming_chunk_size
+ * @return the chunk size to use for direct I/O
+ */
+size_t hamming_direct_chunk_size(size_t chunk_size);
+
+/**
+ * Reads from a file opened with HAMMING_O_DIRECT at an aligned offset. Whole blocks are
+ * read, so buf must be aligned and have room for size rounded up to HAMMING_PLANE_ALIGNMENT.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to read
+ * @param buf receives the bytes
+ * @param size the number of bytes wanted
+ * @return the number of bytes read, less than size only at the end of the file, -1 on failure
+ */
+ssize_t hamming_read_direct(const struct dc_posix_env *env, struct dc_error *err, int fd, void *buf, size_t size);
+
+/**
+ * Writes to a file opened with HAMMING_O_DIRECT at an aligned offset. An unaligned size can
+ * only be the end of the file: the last block is padded with zeros, written whole and the
+ * file is then truncated to its real length. buf must be aligned and have room for size
+ * rounded up to HAMMING_PLANE_ALIGNMENT.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to write
+ * @param buf the bytes to write
+ * @param size the number of bytes to write
+ * @param offset the file offset the bytes are written at
+ * @return 0 on success, -1 on failure
+ */
+int hamming_write_direct(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         int fd,
+                         void *buf,
+                         size_t size,
+                         uint64_t offset);
+
+/**
+ * Writes the blocks of a plane that have a bit set and seeks over the blocks that are all
+ * zeros, leaving holes the file system does not allocate. A hole at the end of the file does
+ * not extend it, so the caller truncates the file to its real length once everything is
+ * written.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to write, positioned at offset
+ * @param buf the bytes to write
+ * @param size the number of bytes to write
+ * @param offset the file offset the bytes are written at
+ * @param direct fd was opened with HAMMING_O_DIRECT, see hamming_write_direct
+ * @return 0 on success, -1 on failure
+ */
+int hamming_write_sparse(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         int fd,
+                         uint8_t *buf,
+                         size_t size,
+                         uint64_t offset,
+                         bool direct);
+
+/**
+ * Reads from a file that may have holes, asking the file system where its data is and
+ * filling the holes with zeros instead of reading them. Falls back to a plain read where
+ * holes cannot be found.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param fd the file to read
+ * @param buf where to put the bytes read
+ * @param size the number of bytes wanted
+ * @param offset the file offset to read from
+ * @param direct fd was opened with HAMMING_O_DIRECT, see hamming_read_direct
+ * @return the number of bytes read, less than size only at the end of the file, or -1 on failure
+ */
+ssize_t hamming_read_sparse(const struct dc_posix_env *env,
+                            struct dc_error *err,
+                            int fd,
+                            uint8_t *buf,
+                            size_t size,
+                            uint64_t offset,
+                            bool direct);
+
+#endif // HAMMING_IO_H
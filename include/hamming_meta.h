@@ -0,0 +1,85 @@
+#ifndef HAMMING_META_H
+#define HAMMING_META_H
+
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Newest metadata sidecar version. Version 2 sidecars record constant planes, which have no
+ * plane file, and are only written when there are some so other sidecars stay readable by
+ * version 1 decoders.
+ */
+#define HAMMING_META_VERSION 2
+
+/**
+ * Version of a sidecar without constant planes.
+ */
+#define HAMMING_META_VERSION_PLANES 1
+
+/**
+ * Parity of a sidecar that records none, such as an archive's, whose members each have the
+ * parity their index entry gives.
+ */
+#define HAMMING_META_NO_PARITY (-1)
+
+/**
+ * Largest metadata sidecar that will be read back.
+ */
+#define HAMMING_META_MAX_SIZE 4096
+
+/**
+ * Description of an encoded plane set, kept in the "<prefix>.meta" sidecar next to the
+ * twelve "<prefix>_N.hamming" plane files.
+ */
+struct hamming_meta {
+    unsigned int version;
+    uint64_t length; // exact number of payload bytes encoded in the planes
+    int parity;      // 0 for even, 1 for odd, HAMMING_META_NO_PARITY if not recorded
+    unsigned int constant;      // mask of the planes whose bits are all the same, they have no file
+    unsigned int constant_ones; // mask of the constant planes whose bits are all 1
+    bool sparse;                // the plane files have holes where their blocks are all zeros
+};
+
+/**
+ * Sets every field of the metadata to its default value.
+ * @param meta the metadata to initialize
+ */
+void hamming_meta_init(struct hamming_meta *meta);
+
+/**
+ * Writes the metadata sidecar for the given prefix, replacing any existing one.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param meta the metadata to write
+ * @return 0 on success, -1 on failure
+ */
+int hamming_meta_write(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       const struct hamming_meta *meta);
+
+/**
+ * Builds the path of the metadata sidecar, "<prefix>.meta".
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param size receives the size of the returned buffer, for dc_free
+ * @return the path, or NULL on failure
+ */
+char *hamming_meta_path(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, size_t *size);
+
+/**
+ * Reads the metadata sidecar for the given prefix. Unknown keys are ignored so that
+ * newer sidecars can still be read.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param meta the metadata to fill in
+ * @return 0 on success, -1 if the sidecar is missing or malformed
+ */
+int hamming_meta_read(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, struct hamming_meta *meta);
+
+#endif // HAMMING_META_H
@@ -0,0 +1,55 @@
+#ifndef HAMMING_OPTIONS_H
+#define HAMMING_OPTIONS_H
+
+#include "hamming_codec.h"
+#include <stddef.h>
+
+/**
+ * Parses a size such as "4096", "64K", "8M" or "1G" (binary units).
+ * @param str the string to parse
+ * @param value receives the size in bytes
+ * @return 0 on success, -1 if str is not a valid size
+ */
+int hamming_parse_size(const char *str, size_t *value);
+
+/**
+ * Parses a plain decimal count such as a number of threads.
+ * @param str the string to parse
+ * @param max the largest count accepted
+ * @param value receives the count
+ * @return 0 on success, -1 if str is not a valid count
+ */
+int hamming_parse_count(const char *str, size_t max, size_t *value);
+
+/**
+ * Parses a rate from 0 to 1 such as "0.001" or "1e-4".
+ * @param str the string to parse
+ * @param value receives the rate
+ * @return 0 on success, -1 if str is not a valid rate
+ */
+int hamming_parse_rate(const char *str, double *value);
+
+/**
+ * Parses a limit such as "50" or "12.5", 0 for no limit.
+ * @param str the string to parse
+ * @param value receives the limit
+ * @return 0 on success, -1 if str is not a valid limit
+ */
+int hamming_parse_limit(const char *str, double *value);
+
+/**
+ * Parses the stores of the encoding kernel, "auto", "cached" or "streaming".
+ * @param str the string to parse
+ * @param kernel receives the stores
+ * @return 0 on success, -1 if str is not one of them
+ */
+int hamming_parse_stores(const char *str, enum hamming_store_kernel *kernel);
+
+/**
+ * Gets the name hamming_parse_stores takes for some stores.
+ * @param kernel the stores
+ * @return the name
+ */
+const char *hamming_stores_name(enum hamming_store_kernel kernel);
+
+#endif // HAMMING_OPTIONS_H
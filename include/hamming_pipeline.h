@@ -0,0 +1,86 @@
+#ifndef HAMMING_PIPELINE_H
+#define HAMMING_PIPELINE_H
+
+#include "hamming_arena.h"
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Most worker threads a pipeline will start.
+ */
+#define HAMMING_PIPELINE_MAX_WORKERS 64
+
+/**
+ * Chunks in flight per worker when none is configured, enough for the reader to fill one
+ * while the worker computes another and the writer flushes a third.
+ */
+#define HAMMING_PIPELINE_DEFAULT_DEPTH 3
+
+/**
+ * One chunk travelling through the pipeline.
+ */
+struct hamming_chunk {
+    struct hamming_buffers buffers;
+    uint64_t sequence; // position of the chunk in the input, starting at 0
+    size_t count;      // characters in the chunk
+    bool final;        // no chunk follows this one
+    struct hamming_decode_stats stats; // filled in by decoding stages
+};
+
+/**
+ * A pipeline stage. The read stage fills the chunk and sets count and final, the work stage
+ * transforms it and the write stage flushes it.
+ * @param env Current working environment
+ * @param err Error tracking, private to the thread running the stage
+ * @param chunk the chunk to process
+ * @param arg the arg of the pipeline configuration
+ * @return 0 on success, -1 to stop the pipeline
+ */
+typedef int (*hamming_stage)(const struct dc_posix_env *env,
+                             struct dc_error *err,
+                             struct hamming_chunk *chunk,
+                             void *arg);
+
+/**
+ * How a pipeline is run. The read stage always runs on one thread and the write stage on
+ * the calling thread, and both see the chunks in input order. With 0 workers the three
+ * stages run one after the other on the calling thread.
+ */
+struct hamming_pipeline_config {
+    size_t chunk_size; // characters per chunk, as returned by hamming_chunk_size
+    size_t workers;    // threads running the work stage
+    size_t depth;      // chunks in flight per worker, 0 for the default
+    hamming_stage read;
+    hamming_stage work;
+    hamming_stage write;
+    void *arg;
+    const char *work_name; // what the work stage is called in a trace, NULL for "work"
+};
+
+/**
+ * Gets the number of arena bytes needed by hamming_pipeline_run.
+ * @param config the pipeline configuration
+ * @return the arena size needed
+ */
+size_t hamming_pipeline_arena_size(const struct hamming_pipeline_config *config);
+
+/**
+ * Runs chunks through the read, work and write stages until the read stage marks a chunk
+ * as final or a stage fails. The read stage runs on its own thread and each worker on
+ * another, connected by single-producer single-consumer rings.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena to allocate the chunks and rings from
+ * @param config the pipeline configuration
+ * @return 0 on success, -1 on failure
+ */
+int hamming_pipeline_run(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         const struct hamming_pipeline_config *config);
+
+#endif // HAMMING_PIPELINE_H
@@ -0,0 +1,53 @@
+#ifndef HAMMING_POOL_H
+#define HAMMING_POOL_H
+
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stddef.h>
+
+/**
+ * Most threads a pool will run.
+ */
+#define HAMMING_POOL_MAX_WORKERS 256
+
+/**
+ * Runs one task of a pool.
+ * @param env Current working environment
+ * @param err Error tracking, private to the worker and reset after every task
+ * @param worker the worker running the task, from 0 to workers - 1, for per-worker state
+ * @param task the task to run, from 0 to tasks - 1
+ * @param arg the arg given to hamming_pool_run
+ */
+typedef void (*hamming_task)(const struct dc_posix_env *env,
+                             struct dc_error *err,
+                             size_t worker,
+                             size_t task,
+                             void *arg);
+
+/**
+ * Gets the number of workers to use when none is configured, one per online processor.
+ * @return the number of online processors, at least 1
+ */
+size_t hamming_pool_default_workers(void);
+
+/**
+ * Runs every task once on a work-stealing pool. The tasks are dealt round robin to the
+ * workers up front. A worker runs its own tasks newest first, and once it runs out it steals
+ * the oldest task of another worker, so uneven task sizes balance out. The calling thread is
+ * worker 0.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param workers the number of workers, at least 1
+ * @param tasks the number of tasks
+ * @param task the function running a task
+ * @param arg passed to every task
+ * @return 0 once every task has run, -1 if the pool could not be started
+ */
+int hamming_pool_run(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     size_t workers,
+                     size_t tasks,
+                     hamming_task task,
+                     void *arg);
+
+#endif // HAMMING_POOL_H
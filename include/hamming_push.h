@@ -0,0 +1,95 @@
+#ifndef HAMMING_PUSH_H
+#define HAMMING_PUSH_H
+
+#include "hamming_arena.h"
+#include "hamming_codec.h"
+#include "hamming_decode.h"
+#include "hamming_stream.h"
+#include <dc_error/error.h>
+#include <dc_fsm/fsm.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * What a push returned.
+ */
+enum hamming_push_status {
+    HAMMING_PUSH_MORE,   // all the input was taken, nothing is decoded until more is pushed
+    HAMMING_PUSH_OUTPUT, // a frame is decoded, the input may not all have been taken
+    HAMMING_PUSH_END     // the stream has ended, nothing more is taken
+};
+
+/**
+ * A framed stream decoder the caller feeds, for a thread that cannot block on its input.
+ * It is a dc_fsm state machine that stops wherever the input runs out and picks up there on
+ * the next push, holding at most one frame.
+ */
+struct hamming_push_decoder {
+    struct dc_fsm_info *fsm;
+    int state;          // the state the next push starts in
+    bool binary;        // hand back every byte, otherwise only printable characters
+    bool verify;        // correct errors with the parity planes, otherwise trust planes 0 to 7
+    int parity;
+    size_t frame_size;  // most characters in a frame, from the stream header
+    uint64_t sequence;  // of the next frame
+    size_t count;       // characters in the frame being gathered
+    size_t length;      // decoded characters handed back by the last push
+    size_t plane;       // plane slice being gathered
+    size_t have;        // bytes of the header or slice gathered so far
+    uint8_t header[HAMMING_FRAME_HEADER_SIZE];
+    struct hamming_arena arena;
+    struct hamming_buffers buffers;
+    const uint8_t *input; // the push in progress
+    size_t input_size;
+    size_t consumed;
+    enum hamming_push_status status;
+    struct hamming_decode_stats stats;
+};
+
+/**
+ * Sets up a decoder for a new stream. Nothing is allocated for the frames until the stream
+ * header has been pushed.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param decoder the decoder to initialize
+ * @param options how to decode, only binary and verify apply
+ * @return 0 on success, -1 on failure
+ */
+int hamming_push_decoder_init(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              struct hamming_push_decoder *decoder,
+                              const struct hamming_decode_options *options);
+
+/**
+ * Releases what a decoder holds.
+ * @param env Current working environment
+ * @param decoder the decoder
+ */
+void hamming_push_decoder_destroy(const struct dc_posix_env *env, struct hamming_push_decoder *decoder);
+
+/**
+ * Takes stream bytes, in pieces of any size, until a frame is decoded or the input runs out.
+ * After HAMMING_PUSH_OUTPUT the decoded characters stay valid until the next push, which
+ * should hand over the input that was not taken.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param decoder the decoder
+ * @param input the next bytes of the stream
+ * @param size the number of bytes
+ * @param consumed receives the number of bytes taken
+ * @param output receives the decoded characters on HAMMING_PUSH_OUTPUT
+ * @param length receives the number of decoded characters, 0 unless HAMMING_PUSH_OUTPUT
+ * @return the status, or -1 on a damaged stream
+ */
+int hamming_push(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 struct hamming_push_decoder *decoder,
+                 const uint8_t *input,
+                 size_t size,
+                 size_t *consumed,
+                 const uint8_t **output,
+                 size_t *length);
+
+#endif // HAMMING_PUSH_H
@@ -0,0 +1,71 @@
+#ifndef HAMMING_RING_H
+#define HAMMING_RING_H
+
+#include "hamming_arena.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A bounded lock-free queue of pointers between exactly one producer thread and exactly one
+ * consumer thread. A full ring makes the producer wait, which is the backpressure between
+ * pipeline stages.
+ */
+struct hamming_ring {
+    _Alignas(HAMMING_ARENA_ALIGNMENT) atomic_size_t head; // next slot to pop, only advanced by the consumer
+    _Alignas(HAMMING_ARENA_ALIGNMENT) atomic_size_t tail; // next slot to push, only advanced by the producer
+    _Alignas(HAMMING_ARENA_ALIGNMENT) size_t mask;
+    void **slots;
+};
+
+/**
+ * Gets the number of arena bytes needed by hamming_ring_init.
+ * @param capacity the number of items the ring must hold
+ * @return the arena size needed for one ring
+ */
+size_t hamming_ring_arena_size(size_t capacity);
+
+/**
+ * Sets up an empty ring with room for at least capacity items.
+ * @param ring the ring to set up
+ * @param arena the arena to allocate the slots from
+ * @param capacity the number of items the ring must hold
+ * @return 0 on success, -1 if the arena is too small
+ */
+int hamming_ring_init(struct hamming_ring *ring, struct hamming_arena *arena, size_t capacity);
+
+/**
+ * Adds an item without waiting. Only the producer thread may call this.
+ * @param ring the ring to add to
+ * @param item the item to add, NULL is allowed
+ * @return false if the ring is full
+ */
+bool hamming_ring_try_push(struct hamming_ring *ring, void *item);
+
+/**
+ * Removes the oldest item without waiting. Only the consumer thread may call this.
+ * @param ring the ring to remove from
+ * @param item receives the item
+ * @return false if the ring is empty
+ */
+bool hamming_ring_try_pop(struct hamming_ring *ring, void **item);
+
+/**
+ * Adds an item, waiting while the ring is full. Only the producer thread may call this.
+ * @param ring the ring to add to
+ * @param item the item to add, NULL is allowed
+ * @param cancel stop waiting once this is set
+ * @return false if the wait was cancelled
+ */
+bool hamming_ring_push(struct hamming_ring *ring, void *item, const atomic_bool *cancel);
+
+/**
+ * Removes the oldest item, waiting while the ring is empty. Only the consumer thread may call this.
+ * @param ring the ring to remove from
+ * @param item receives the item
+ * @param cancel stop waiting once this is set
+ * @return false if the wait was cancelled
+ */
+bool hamming_ring_pop(struct hamming_ring *ring, void **item, const atomic_bool *cancel);
+
+#endif // HAMMING_RING_H
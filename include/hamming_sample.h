@@ -0,0 +1,133 @@
+#ifndef HAMMING_SAMPLE_H
+#define HAMMING_SAMPLE_H
+
+#include "hamming_arena.h"
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Bytes of each plane in a sampled block, so a block is HAMMING_SAMPLE_BLOCK_SIZE * 8
+ * characters read with one aligned read per plane.
+ */
+#define HAMMING_SAMPLE_BLOCK_SIZE HAMMING_PLANE_ALIGNMENT
+
+/**
+ * Normal quantile of the confidence intervals, 95% two-sided.
+ */
+#define HAMMING_SAMPLE_Z 1.96
+
+/**
+ * Blocks read to detect the parity, spread over the plane set.
+ */
+#define HAMMING_SAMPLE_PARITY_BLOCKS 8
+
+/**
+ * An estimated fraction of the characters and its 95% confidence interval.
+ */
+struct hamming_sample_estimate {
+    double rate;
+    double low;
+    double high;
+};
+
+/**
+ * What sampling a plane set found.
+ */
+struct hamming_sample_report {
+    uint64_t blocks;        // blocks checked
+    uint64_t total_blocks;  // blocks in the plane set
+    uint64_t characters;    // characters checked
+    uint64_t corrected;     // characters with a correctable error
+    uint64_t uncorrectable; // characters with an error that cannot be corrected
+    struct hamming_sample_estimate corrected_rate;
+    struct hamming_sample_estimate uncorrectable_rate;
+};
+
+/**
+ * Estimates how damaged a plane set is from a random sample of its blocks, reading only
+ * those slices of the twelve planes and checking their syndromes. The blocks are picked
+ * with a seeded random number generator, so the same seed checks the same blocks, and are
+ * read in file order. The error rates are ratio estimates over the sampled blocks; their
+ * intervals come from the spread between blocks, which accounts for errors that cluster,
+ * with the finite population correction. When no error was seen, or only one block was
+ * checked, the Wilson score interval over the characters is used instead.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the block buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the plane files
+ * @param parity 0 for even, 1 for odd
+ * @param rate the fraction of the blocks to check, at least one block is
+ * @param seed the seed of the random number generator
+ * @param report receives the result
+ * @return 0 on success, -1 on failure or if a plane is missing or short
+ */
+int hamming_sample(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   const char *prefix,
+                   int parity,
+                   double rate,
+                   uint64_t seed,
+                   struct hamming_sample_report *report);
+
+/**
+ * What checking a sample under both parities found.
+ */
+struct hamming_parity_guess {
+    int parity;           // the parity with fewer flagged characters, 0 for even, 1 for odd
+    uint64_t characters;  // characters checked
+    uint64_t flagged[2];  // characters with a non-zero syndrome under even and under odd parity
+    bool sampled;         // the planes were sampled, otherwise the parity is the recorded one
+    int recorded;         // the parity the sidecar records, HAMMING_META_NO_PARITY for none
+};
+
+/**
+ * Finds the parity a plane set was encoded with from a few of its blocks. A character's
+ * syndrome under odd parity is the complement of its syndrome under even parity, so under
+ * the right parity almost every character checks out and under the wrong one almost none
+ * does.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the block buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the plane files
+ * @param guess receives the parity and the counts it was chosen on
+ * @return 0 on success, -1 on failure or if a plane is missing or short
+ */
+int hamming_sample_parity(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          const char *prefix,
+                          struct hamming_parity_guess *guess);
+
+/**
+ * Finds the parity a plane set was encoded with: the one its sidecar records, read without
+ * touching the planes, or, with no sidecar, no parity in it, or when asked to check it, the
+ * one hamming_sample_parity finds. An empty plane set is never sampled, it takes the recorded
+ * parity or, with none, even parity.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the block buffers, reserved (and reused) as needed
+ * @param prefix the prefix of the plane files
+ * @param check sample the planes even when the sidecar records the parity
+ * @param guess receives the parity, where it came from and what the sidecar records
+ * @return 0 on success, -1 on failure or if the planes had to be sampled and one is missing or short
+ */
+int hamming_find_parity(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct hamming_arena *arena,
+                        const char *prefix,
+                        bool check,
+                        struct hamming_parity_guess *guess);
+
+/**
+ * Writes a sampling report.
+ * @param stream where to write
+ * @param report the report
+ */
+void hamming_sample_print(FILE *stream, const struct hamming_sample_report *report);
+
+#endif // HAMMING_SAMPLE_H
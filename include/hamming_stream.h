@@ -0,0 +1,109 @@
+#ifndef HAMMING_STREAM_H
+#define HAMMING_STREAM_H
+
+#include "hamming_arena.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Starts a framed stream, followed by the frame size and the parity.
+ */
+#define HAMMING_STREAM_MAGIC "HMS1"
+
+/**
+ * Bytes of the stream header: the magic, the frame size as a 32-bit little-endian number,
+ * the parity and three reserved bytes of 0.
+ */
+#define HAMMING_STREAM_HEADER_SIZE 12
+
+/**
+ * Bytes of a frame header: the sequence number as a 64-bit little-endian number, the
+ * characters in the frame as a 32-bit one, the parity and three reserved bytes of 0. The
+ * twelve plane slices follow, (characters + 7) / 8 bytes each, and a frame of 0 characters
+ * ends the stream.
+ */
+#define HAMMING_FRAME_HEADER_SIZE 16
+
+/**
+ * Largest frame size a decoder accepts, which bounds the memory a stream can make it use.
+ */
+#define HAMMING_STREAM_MAX_FRAME_SIZE ((size_t) 64 * 1024 * 1024)
+
+/**
+ * Encodes everything that can be read from a file descriptor into a framed stream. A frame
+ * is sent as soon as it is full or the input has nothing more to read for now, so a slow
+ * producer gets small frames with little delay and a fast one gets full frames. The plane
+ * file options (direct I/O, durability, elision, holes) do not apply.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param in_fd the file descriptor to read the message from
+ * @param out_fd the file descriptor to write the stream to
+ * @param options how to encode, chunk_size is the most characters in a frame
+ * @param stats counters to add the result of the message to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_encode_stream(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          int in_fd,
+                          int out_fd,
+                          const struct hamming_encode_options *options,
+                          struct hamming_encode_stats *stats);
+
+/**
+ * Decodes a framed stream as the frames arrive and writes the message to a file descriptor.
+ * The frame size and parity come from the stream, and a stream that ends before its last
+ * frame is an error once everything before it has been written.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param arena the arena for the chunk buffers, reserved (and reused) as needed
+ * @param in_fd the file descriptor to read the stream from
+ * @param out_fd the file descriptor to write the message to
+ * @param options how to decode, the parity and plane file options do not apply
+ * @param stats counters to add the result of every character to
+ * @return 0 on success, -1 on failure
+ */
+int hamming_decode_stream(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          int in_fd,
+                          int out_fd,
+                          const struct hamming_decode_options *options,
+                          struct hamming_decode_stats *stats);
+
+/**
+ * Checks a stream header and reads what it says.
+ * @param err Error tracking
+ * @param header the stream header
+ * @param frame_size receives the most characters in a frame
+ * @param parity receives 0 for even, 1 for odd
+ * @return 0 on success, -1 if it is not a stream header or a damaged one
+ */
+int hamming_stream_header_parse(struct dc_error *err,
+                                const uint8_t header[HAMMING_STREAM_HEADER_SIZE],
+                                size_t *frame_size,
+                                int *parity);
+
+/**
+ * Checks a frame header against the stream it belongs to.
+ * @param err Error tracking
+ * @param header the frame header
+ * @param sequence the sequence number the frame must have
+ * @param frame_size the most characters in a frame
+ * @param parity the parity of the stream
+ * @param count receives the characters in the frame, 0 at the end of the stream
+ * @return 0 on success, -1 if the frame is out of sequence or damaged
+ */
+int hamming_frame_header_parse(struct dc_error *err,
+                               const uint8_t header[HAMMING_FRAME_HEADER_SIZE],
+                               uint64_t sequence,
+                               size_t frame_size,
+                               int parity,
+                               size_t *count);
+
+#endif // HAMMING_STREAM_H
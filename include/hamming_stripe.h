@@ -0,0 +1,117 @@
+#ifndef HAMMING_STRIPE_H
+#define HAMMING_STRIPE_H
+
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Most directories the planes can be striped across, one plane each.
+ */
+#define HAMMING_STRIPE_MAX_DIRS BITS_INC_HAMMING
+
+/**
+ * Does the I/O of one plane.
+ * @param env Current working environment
+ * @param err Error tracking, private to the thread doing the I/O
+ * @param index the plane, from 0 to 11 (inclusive)
+ * @param arg the arg given to hamming_stripe_run
+ * @return 0 on success, -1 to stop the other planes of the same device
+ */
+typedef int (*hamming_plane_io)(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg);
+
+struct hamming_stripe;
+
+/**
+ * One I/O worker, serving the planes of one device.
+ */
+struct hamming_stripe_worker {
+    struct hamming_stripe *stripe;
+    size_t device;
+    struct dc_error err;
+    pthread_t thread;
+    bool started;
+};
+
+/**
+ * The I/O workers of a plane set, started once and given a round of plane I/O per chunk.
+ * The calling thread serves device 0.
+ */
+struct hamming_stripe {
+    const struct dc_posix_env *env;
+    size_t devices;
+    pthread_mutex_t lock;
+    pthread_cond_t start; // a round is posted or the workers are stopping
+    pthread_cond_t done;  // the last worker finished its part of the round
+    uint64_t round;
+    size_t pending;       // workers still busy with the round
+    bool stopping;
+    unsigned int planes;  // the planes of the round, a mask of HAMMING_PLANE_BIT
+    hamming_plane_io io;
+    void *arg;
+    struct hamming_stripe_worker workers[HAMMING_STRIPE_MAX_DIRS];
+};
+
+/**
+ * Places the plane files in several directories, plane N in directory N mod D, so that
+ * directories on different devices share the bandwidth and the loss of one device only
+ * loses its planes. The prefix is taken relative to each directory; the sidecar stays at
+ * the prefix itself. Applies to every plane path built afterwards.
+ * @param err Error tracking
+ * @param dirs the directories separated by commas, NULL or empty to keep every plane at the prefix
+ * @return 0 on success, -1 if a directory is empty or too long or there are too many
+ */
+int hamming_stripe_set(struct dc_error *err, const char *dirs);
+
+/**
+ * Gets the number of directories the planes are striped across.
+ * @return the number of directories, 1 when the planes are not striped
+ */
+size_t hamming_stripe_devices(void);
+
+/**
+ * Gets the directory of a plane.
+ * @param index the plane, from 0 to 11 (inclusive)
+ * @return the directory, NULL when the planes are not striped
+ */
+const char *hamming_stripe_dir(size_t index);
+
+/**
+ * Starts one I/O worker per directory the planes are striped across, none when they are
+ * not striped.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param stripe the workers to start
+ * @return 0 on success, -1 if a thread could not be started, then none are running
+ */
+int hamming_stripe_start(const struct dc_posix_env *env, struct dc_error *err, struct hamming_stripe *stripe);
+
+/**
+ * Does the I/O of some planes, each device's planes in order on its own worker while the
+ * devices run concurrently, and waits for all of them.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param stripe the started workers
+ * @param planes the planes to do the I/O of, a mask of HAMMING_PLANE_BIT
+ * @param io the I/O of one plane
+ * @param arg passed to io
+ * @return 0 on success, -1 if the I/O of a plane failed
+ */
+int hamming_stripe_run(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_stripe *stripe,
+                       unsigned int planes,
+                       hamming_plane_io io,
+                       void *arg);
+
+/**
+ * Stops the I/O workers and waits for them.
+ * @param stripe the started workers
+ */
+void hamming_stripe_stop(struct hamming_stripe *stripe);
+
+#endif // HAMMING_STRIPE_H
@@ -0,0 +1,95 @@
+#ifndef HAMMING_SYSCALLS_H
+#define HAMMING_SYSCALLS_H
+
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * The calls counted.
+ */
+enum hamming_syscall {
+    HAMMING_SYSCALL_OPEN,
+    HAMMING_SYSCALL_READ,
+    HAMMING_SYSCALL_WRITE,
+    HAMMING_SYSCALL_CLOSE,
+    HAMMING_SYSCALL_MALLOC,
+    HAMMING_SYSCALL_CALLOC,
+    HAMMING_SYSCALLS // number of calls counted
+};
+
+/**
+ * What was counted since hamming_syscalls_start.
+ */
+struct hamming_syscall_counts {
+    uint64_t calls[HAMMING_SYSCALLS];
+    uint64_t bytes[HAMMING_SYSCALLS]; // nothing for opens and closes
+};
+
+/**
+ * Starts counting. Until then the tracer and the byte counts do nothing, so the tracer can be
+ * installed before the options are known.
+ */
+void hamming_syscalls_start(void);
+
+/**
+ * A dc_posix_env tracer counting the calls of every thread to dc_open, dc_read, dc_write,
+ * dc_close, dc_malloc and dc_calloc, whoever makes them.
+ * @param env Current working environment
+ * @param file_name the file of the traced call
+ * @param function_name the function traced
+ * @param line_number the line of the traced call
+ */
+void hamming_syscalls_tracer(const struct dc_posix_env *env,
+                             const char *file_name,
+                             const char *function_name,
+                             size_t line_number);
+
+/**
+ * Counts a call made without going through dc_posix, which the tracer does not see.
+ * @param call the kind of call
+ */
+void hamming_syscalls_add_call(enum hamming_syscall call);
+
+/**
+ * Adds to the bytes moved or allocated by a kind of call. The tracer does not see the
+ * arguments, so the I/O helpers and hamming_malloc report them.
+ * @param call the kind of call
+ * @param bytes the number of bytes
+ */
+void hamming_syscalls_add_bytes(enum hamming_syscall call, size_t bytes);
+
+/**
+ * dc_malloc, with the bytes counted.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param size the number of bytes
+ * @return the memory, or NULL on failure
+ */
+void *hamming_malloc(const struct dc_posix_env *env, struct dc_error *err, size_t size);
+
+/**
+ * dc_calloc, with the bytes counted.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param count the number of elements
+ * @param size the size of an element
+ * @return the memory, or NULL on failure
+ */
+void *hamming_calloc(const struct dc_posix_env *env, struct dc_error *err, size_t count, size_t size);
+
+/**
+ * Reads the counts so far.
+ * @param counts receives the counts
+ */
+void hamming_syscalls_get(struct hamming_syscall_counts *counts);
+
+/**
+ * Writes a summary of the counts so far. The bytes of allocations made inside the dc
+ * libraries are not seen, only their number.
+ * @param stream where to write
+ */
+void hamming_syscalls_print(FILE *stream);
+
+#endif // HAMMING_SYSCALLS_H
@@ -0,0 +1,75 @@
+#ifndef HAMMING_THROTTLE_H
+#define HAMMING_THROTTLE_H
+
+#include <dc_error/error.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Seconds of I/O at the limit that can be done at once after being idle.
+ */
+#define HAMMING_THROTTLE_BURST_SECONDS 0.1
+
+/**
+ * How fast the plane files and the message may be read and written, 0 for no limit.
+ */
+struct hamming_throttle_limits {
+    double read_mbps;  // megabytes (10^6 bytes) read per second
+    double write_mbps; // megabytes written per second
+    double iops;       // reads and writes per second
+};
+
+/**
+ * What the limits cost since hamming_throttle_start.
+ */
+struct hamming_throttle_stats {
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint64_t operations; // reads and writes
+    uint64_t waits;      // times a thread was held back
+    double seconds;      // time the threads were held back, added across threads
+};
+
+/**
+ * Starts limiting every read and write of the I/O helpers, across all threads. Each limit
+ * is a token bucket holding HAMMING_THROTTLE_BURST_SECONDS worth of I/O; a call that takes
+ * more than there is runs and leaves a debt the calling thread sleeps off afterwards, so
+ * large calls are not starved and the callers are served in turn.
+ * @param limits the limits
+ */
+void hamming_throttle_start(const struct hamming_throttle_limits *limits);
+
+/**
+ * Accounts for one read, waiting as long as the limits require.
+ * @param size the number of bytes read
+ */
+void hamming_throttle_read(size_t size);
+
+/**
+ * Accounts for one write, waiting as long as the limits require.
+ * @param size the number of bytes written
+ */
+void hamming_throttle_write(size_t size);
+
+/**
+ * Moves the calling thread, and the threads it starts afterwards, to the idle I/O
+ * scheduling class, so the disk only serves them when nothing else wants it.
+ * @param err Error tracking
+ * @return 0 on success, -1 if the system has no I/O priorities or refuses
+ */
+int hamming_throttle_idle(struct dc_error *err);
+
+/**
+ * Reads the stats so far.
+ * @param stats receives the stats
+ */
+void hamming_throttle_get(struct hamming_throttle_stats *stats);
+
+/**
+ * Writes a summary of the stats so far.
+ * @param stream where to write
+ */
+void hamming_throttle_print(FILE *stream);
+
+#endif // HAMMING_THROTTLE_H
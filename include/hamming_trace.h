@@ -0,0 +1,66 @@
+#ifndef HAMMING_TRACE_H
+#define HAMMING_TRACE_H
+
+#include <dc_error/error.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Events each thread can record, past that its spans are dropped and counted.
+ */
+#define HAMMING_TRACE_THREAD_EVENTS ((size_t) 64 * 1024)
+
+/**
+ * Longest thread name kept, including the terminating 0.
+ */
+#define HAMMING_TRACE_NAME_SIZE 32
+
+/**
+ * A span that is not about one chunk.
+ */
+#define HAMMING_TRACE_NO_CHUNK UINT64_MAX
+
+/**
+ * A span that is not about one plane.
+ */
+#define HAMMING_TRACE_NO_PLANE SIZE_MAX
+
+/**
+ * Starts recording spans for hamming_trace_finish to write to a file. Until then
+ * hamming_trace_begin and hamming_trace_end do nothing. The calling thread is named "main".
+ * @param err Error tracking
+ * @param path the file to write the trace to
+ * @return 0 on success, -1 if the path is too long
+ */
+int hamming_trace_start(struct dc_error *err, const char *path);
+
+/**
+ * Names the calling thread in the trace.
+ * @param name the name, cut to HAMMING_TRACE_NAME_SIZE - 1 characters
+ */
+void hamming_trace_thread(const char *name);
+
+/**
+ * Begins a span of the calling thread. Each thread records into a buffer of its own, linked
+ * into the trace without a lock on its first span, so recording an event takes no lock.
+ * Spans nest, and each must be ended on the thread that began it.
+ * @param name what the span is, a string that outlives the trace
+ * @param chunk the sequence number of the chunk, HAMMING_TRACE_NO_CHUNK for none
+ * @param plane the plane, HAMMING_TRACE_NO_PLANE for none
+ */
+void hamming_trace_begin(const char *name, uint64_t chunk, size_t plane);
+
+/**
+ * Ends the innermost span of the calling thread.
+ */
+void hamming_trace_end(void);
+
+/**
+ * Stops recording and writes every thread's spans in the Chrome trace event format, which
+ * chrome://tracing and Perfetto open. Every thread that recorded must have finished.
+ * @param err Error tracking
+ * @return 0 on success or if nothing was started, -1 if the file could not be written
+ */
+int hamming_trace_finish(struct dc_error *err);
+
+#endif // HAMMING_TRACE_H
@@ -0,0 +1,88 @@
+#ifndef HAMMING_TUNE_H
+#define HAMMING_TUNE_H
+
+#include "hamming_codec.h"
+#include <dc_error/error.h>
+#include <dc_posix/dc_posix_env.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * Each setting is timed until this many seconds have passed, and at least twice, keeping
+ * the fastest run.
+ */
+#define HAMMING_TUNE_MIN_SECONDS 0.25
+
+/**
+ * Most runs timed for one setting.
+ */
+#define HAMMING_TUNE_MAX_RUNS 16
+
+/**
+ * Largest config file that is read back to be updated.
+ */
+#define HAMMING_TUNE_MAX_CONFIG_SIZE ((size_t) 64 * 1024)
+
+/**
+ * Which tool is tuned.
+ */
+enum hamming_tune_mode {
+    HAMMING_TUNE_ENCODE,
+    HAMMING_TUNE_DECODE
+};
+
+/**
+ * The fastest settings found.
+ */
+struct hamming_tune_result {
+    size_t chunk_size;
+    size_t threads;
+    bool direct_io;
+    enum hamming_store_kernel stores; // encoding only
+    size_t parallel_threshold;        // characters below which a message is coded on the calling thread
+    double mbps;                      // megabytes (10^6 bytes) of message per second with these settings
+};
+
+/**
+ * Times encoding or decoding a random message on this host, in the directory of the prefix
+ * (and the plane directories, when striping), and picks the settings one after the other:
+ * the chunk size, the number of threads, the stores (when encoding) and direct I/O. Then the
+ * smallest message the threads pay off for is looked for with messages of 64K, 256K, 1M, 4M
+ * and 16M characters. The scratch files, "<prefix>.tune" and its planes, are removed after.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param mode the tool to tune
+ * @param prefix where the scratch files go
+ * @param size the characters of the message to time
+ * @param log receives one line per timed setting
+ * @param result receives the fastest settings
+ * @return 0 on success, -1 on failure
+ */
+int hamming_tune(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 enum hamming_tune_mode mode,
+                 const char *prefix,
+                 size_t size,
+                 FILE *log,
+                 struct hamming_tune_result *result);
+
+/**
+ * Writes the settings of a tune into a config file, one "key=value" line each under the
+ * names of the command line options. The lines of other settings already in the file are
+ * kept, the file is replaced as a whole.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param path the config file
+ * @param mode the tool that was tuned
+ * @param result the settings to write
+ * @return 0 on success, -1 on failure
+ */
+int hamming_tune_write_config(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *path,
+                              enum hamming_tune_mode mode,
+                              const struct hamming_tune_result *result);
+
+#endif // HAMMING_TUNE_H
@@ -10,7 +10,7 @@ int main(int argc, char *argv[]) {
 
     reporter = error_reporter;
     tracer = trace_reporter;
-    tracer = NULL;
+    tracer = hamming_syscalls_tracer; // counts nothing unless --count-syscalls is given
     dc_error_init(&err, reporter);
     dc_posix_env_init(&env, tracer);
     info = dc_application_info_create(&env, &err, "Ascii to hamming application");
@@ -23,6 +23,16 @@ int main(int argc, char *argv[]) {
 }
 
 static struct dc_application_settings *create_settings(const struct dc_posix_env *env, struct dc_error *err) {
+    static const bool default_binary = false;
+    static const bool default_direct_io = false;
+    static const bool default_elide_constant = false;
+    static const bool default_sparse = false;
+    static const bool default_count_syscalls = false;
+    static const bool default_to_stdout = false;
+    static const bool default_huge_pages = false;
+    static const bool default_idle_io = false;
+    static const bool default_archive = false;
+    static const bool default_tune = false;
     struct application_settings *settings;
 
     DC_TRACE(env);
@@ -35,6 +45,28 @@ static struct dc_application_settings *create_settings(const struct dc_posix_env
     settings->opts.parent.config_path = dc_setting_path_create(env, err);
     settings->parity = dc_setting_string_create(env, err);
     settings->prefix = dc_setting_string_create(env, err);
+    settings->binary = dc_setting_bool_create(env, err);
+    settings->chunk_size = dc_setting_string_create(env, err);
+    settings->threads = dc_setting_string_create(env, err);
+    settings->manifest = dc_setting_string_create(env, err);
+    settings->direct_io = dc_setting_bool_create(env, err);
+    settings->durability = dc_setting_string_create(env, err);
+    settings->elide_constant = dc_setting_bool_create(env, err);
+    settings->sparse = dc_setting_bool_create(env, err);
+    settings->count_syscalls = dc_setting_bool_create(env, err);
+    settings->to_stdout = dc_setting_bool_create(env, err);
+    settings->huge_pages = dc_setting_bool_create(env, err);
+    settings->max_read_mbps = dc_setting_string_create(env, err);
+    settings->max_write_mbps = dc_setting_string_create(env, err);
+    settings->max_iops = dc_setting_string_create(env, err);
+    settings->idle_io = dc_setting_bool_create(env, err);
+    settings->plane_dirs = dc_setting_string_create(env, err);
+    settings->archive = dc_setting_bool_create(env, err);
+    settings->tune = dc_setting_bool_create(env, err);
+    settings->tune_size = dc_setting_string_create(env, err);
+    settings->stores = dc_setting_string_create(env, err);
+    settings->parallel_threshold = dc_setting_string_create(env, err);
+    settings->trace_file = dc_setting_string_create(env, err);
 
     struct options opts[] = {
             {(struct dc_setting *) settings->opts.parent.config_path,
@@ -67,13 +99,233 @@ static struct dc_application_settings *create_settings(const struct dc_posix_env
                     "prefix",
                     dc_string_from_config,
                     "file"},
+            {(struct dc_setting *) settings->binary,
+                    dc_options_set_bool,
+                    "binary",
+                    no_argument,
+                    'b',
+                    "BINARY",
+                    dc_flag_from_string,
+                    "binary",
+                    dc_flag_from_config,
+                    &default_binary},
+            {(struct dc_setting *) settings->chunk_size,
+                    dc_options_set_string,
+                    "chunk-size",
+                    required_argument,
+                    'k',
+                    "CHUNK_SIZE",
+                    dc_string_from_string,
+                    "chunk-size",
+                    dc_string_from_config,
+                    "64K"},
+            {(struct dc_setting *) settings->threads,
+                    dc_options_set_string,
+                    "threads",
+                    required_argument,
+                    't',
+                    "THREADS",
+                    dc_string_from_string,
+                    "threads",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->manifest,
+                    dc_options_set_string,
+                    "manifest",
+                    required_argument,
+                    'm',
+                    "MANIFEST",
+                    dc_string_from_string,
+                    "manifest",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->direct_io,
+                    dc_options_set_bool,
+                    "direct-io",
+                    no_argument,
+                    'd',
+                    "DIRECT_IO",
+                    dc_flag_from_string,
+                    "direct-io",
+                    dc_flag_from_config,
+                    &default_direct_io},
+            {(struct dc_setting *) settings->durability,
+                    dc_options_set_string,
+                    "durability",
+                    required_argument,
+                    'y',
+                    "DURABILITY",
+                    dc_string_from_string,
+                    "durability",
+                    dc_string_from_config,
+                    "none"},
+            {(struct dc_setting *) settings->elide_constant,
+                    dc_options_set_bool,
+                    "elide-constant",
+                    no_argument,
+                    'z',
+                    "ELIDE_CONSTANT",
+                    dc_flag_from_string,
+                    "elide-constant",
+                    dc_flag_from_config,
+                    &default_elide_constant},
+            {(struct dc_setting *) settings->sparse,
+                    dc_options_set_bool,
+                    "sparse",
+                    no_argument,
+                    's',
+                    "SPARSE",
+                    dc_flag_from_string,
+                    "sparse",
+                    dc_flag_from_config,
+                    &default_sparse},
+            {(struct dc_setting *) settings->count_syscalls,
+                    dc_options_set_bool,
+                    "count-syscalls",
+                    no_argument,
+                    'C',
+                    "COUNT_SYSCALLS",
+                    dc_flag_from_string,
+                    "count-syscalls",
+                    dc_flag_from_config,
+                    &default_count_syscalls},
+            {(struct dc_setting *) settings->to_stdout,
+                    dc_options_set_bool,
+                    "stdout",
+                    no_argument,
+                    'o',
+                    "STDOUT",
+                    dc_flag_from_string,
+                    "stdout",
+                    dc_flag_from_config,
+                    &default_to_stdout},
+            {(struct dc_setting *) settings->huge_pages,
+                    dc_options_set_bool,
+                    "huge-pages",
+                    no_argument,
+                    'H',
+                    "HUGE_PAGES",
+                    dc_flag_from_string,
+                    "huge-pages",
+                    dc_flag_from_config,
+                    &default_huge_pages},
+            {(struct dc_setting *) settings->max_read_mbps,
+                    dc_options_set_string,
+                    "max-read-mbps",
+                    required_argument,
+                    'R',
+                    "MAX_READ_MBPS",
+                    dc_string_from_string,
+                    "max-read-mbps",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->max_write_mbps,
+                    dc_options_set_string,
+                    "max-write-mbps",
+                    required_argument,
+                    'W',
+                    "MAX_WRITE_MBPS",
+                    dc_string_from_string,
+                    "max-write-mbps",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->max_iops,
+                    dc_options_set_string,
+                    "max-iops",
+                    required_argument,
+                    'I',
+                    "MAX_IOPS",
+                    dc_string_from_string,
+                    "max-iops",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->idle_io,
+                    dc_options_set_bool,
+                    "idle-io",
+                    no_argument,
+                    'L',
+                    "IDLE_IO",
+                    dc_flag_from_string,
+                    "idle-io",
+                    dc_flag_from_config,
+                    &default_idle_io},
+            {(struct dc_setting *) settings->plane_dirs,
+                    dc_options_set_string,
+                    "plane-dirs",
+                    required_argument,
+                    'P',
+                    "PLANE_DIRS",
+                    dc_string_from_string,
+                    "plane-dirs",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->archive,
+                    dc_options_set_bool,
+                    "archive",
+                    no_argument,
+                    'A',
+                    "ARCHIVE",
+                    dc_flag_from_string,
+                    "archive",
+                    dc_flag_from_config,
+                    &default_archive},
+            {(struct dc_setting *) settings->tune,
+                    dc_options_set_bool,
+                    "tune",
+                    no_argument,
+                    'U',
+                    "TUNE",
+                    dc_flag_from_string,
+                    "tune",
+                    dc_flag_from_config,
+                    &default_tune},
+            {(struct dc_setting *) settings->tune_size,
+                    dc_options_set_string,
+                    "tune-size",
+                    required_argument,
+                    'Z',
+                    "TUNE_SIZE",
+                    dc_string_from_string,
+                    "tune-size",
+                    dc_string_from_config,
+                    "64M"},
+            {(struct dc_setting *) settings->stores,
+                    dc_options_set_string,
+                    "stores",
+                    required_argument,
+                    'T',
+                    "STORES",
+                    dc_string_from_string,
+                    "stores",
+                    dc_string_from_config,
+                    "auto"},
+            {(struct dc_setting *) settings->parallel_threshold,
+                    dc_options_set_string,
+                    "parallel-threshold",
+                    required_argument,
+                    'Q',
+                    "PARALLEL_THRESHOLD",
+                    dc_string_from_string,
+                    "parallel-threshold",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->trace_file,
+                    dc_options_set_string,
+                    "trace-file",
+                    required_argument,
+                    'J',
+                    "TRACE_FILE",
+                    dc_string_from_string,
+                    "trace-file",
+                    dc_string_from_config,
+                    NULL},
     };
 
     settings->opts.opts_count = (sizeof(opts) / sizeof(struct options)) + 1;
     settings->opts.opts_size = sizeof(struct options);
     settings->opts.opts = dc_calloc(env, err, settings->opts.opts_count, settings->opts.opts_size);
     dc_memcpy(env, settings->opts.opts, opts, sizeof(opts));
-    settings->opts.flags = "p:e:";
+    settings->opts.flags = "p:e:bk:t:m:dy:zsCoHR:W:I:LP:AUZ:T:Q:J:";
     settings->opts.env_prefix = "ASCII_HAMMING_";
 
     return (struct dc_application_settings *) settings;
@@ -88,6 +340,28 @@ static int destroy_settings(const struct dc_posix_env *env,
     app_settings = (struct application_settings *) *psettings;
     dc_setting_string_destroy(env, &app_settings->parity);
     dc_setting_string_destroy(env, &app_settings->prefix);
+    dc_setting_bool_destroy(env, &app_settings->binary);
+    dc_setting_string_destroy(env, &app_settings->chunk_size);
+    dc_setting_string_destroy(env, &app_settings->threads);
+    dc_setting_string_destroy(env, &app_settings->manifest);
+    dc_setting_bool_destroy(env, &app_settings->direct_io);
+    dc_setting_string_destroy(env, &app_settings->durability);
+    dc_setting_bool_destroy(env, &app_settings->elide_constant);
+    dc_setting_bool_destroy(env, &app_settings->sparse);
+    dc_setting_bool_destroy(env, &app_settings->count_syscalls);
+    dc_setting_bool_destroy(env, &app_settings->to_stdout);
+    dc_setting_bool_destroy(env, &app_settings->huge_pages);
+    dc_setting_string_destroy(env, &app_settings->max_read_mbps);
+    dc_setting_string_destroy(env, &app_settings->max_write_mbps);
+    dc_setting_string_destroy(env, &app_settings->max_iops);
+    dc_setting_bool_destroy(env, &app_settings->idle_io);
+    dc_setting_string_destroy(env, &app_settings->plane_dirs);
+    dc_setting_bool_destroy(env, &app_settings->archive);
+    dc_setting_bool_destroy(env, &app_settings->tune);
+    dc_setting_string_destroy(env, &app_settings->tune_size);
+    dc_setting_string_destroy(env, &app_settings->stores);
+    dc_setting_string_destroy(env, &app_settings->parallel_threshold);
+    dc_setting_string_destroy(env, &app_settings->trace_file);
     dc_free(env, app_settings->opts.opts, app_settings->opts.opts_count);
     dc_free(env, *psettings, sizeof(struct application_settings));
 
@@ -102,184 +376,249 @@ static int run(const struct dc_posix_env *env, struct dc_error *err, struct dc_a
     struct application_settings *app_settings;
     const char *parity;
     const char *prefix;
-    int parity_int;
-    char chars[BUF_SIZE];
-    ssize_t nread;
-    uint8_t byte;
-    uint8_t array_of_bits[BITS_PER_BYTE];
-    uint8_t array_hamming[4];
-    mode_t modes = S_IRUSR | S_IWUSR;
-    int fd;
+    const char *manifest;
+    size_t threads;
+    struct hamming_encode_options options;
+    struct hamming_arena arena = {0};
+    struct hamming_encode_stats stats = {0};
+    struct hamming_throttle_limits limits;
+    enum hamming_store_kernel stores;
+    size_t parallel_threshold;
+    struct stat input;
+    bool throttled;
+    int ret_val = EXIT_SUCCESS;
 
     DC_TRACE(env);
 
     app_settings = (struct application_settings *) settings;
     parity = dc_setting_string_get(env, app_settings->parity);
     prefix = dc_setting_string_get(env, app_settings->prefix);
+    manifest = dc_setting_string_get(env, app_settings->manifest);
+    hamming_encode_options_init(&options);
 
-    if (!dc_strcmp(env, parity, "odd")) parity_int = 1;
-    else if (!dc_strcmp(env, parity, "even")) parity_int = 0;
+    if (!dc_strcmp(env, parity, "odd")) options.parity = 1;
+    else if (!dc_strcmp(env, parity, "even")) options.parity = 0;
     else {
         printf("Incorrect parity entered! Either 'even' or 'odd', default is 'even' (case sensitive)\n");
         exit(EXIT_FAILURE);
     }
 
-    const size_t len = dc_strlen(env, prefix) + 11;
-
-    char path[len];
-
-    nread = dc_read(env, err, STDIN_FILENO, chars, BUF_SIZE);
-    size_t size = (size_t) nread - 1;
-
-    uint8_t array_bit_0[size];
-    uint8_t array_bit_1[size];
-    uint8_t array_bit_2[size];
-    uint8_t array_bit_3[size];
-    uint8_t array_bit_4[size];
-    uint8_t array_bit_5[size];
-    uint8_t array_bit_6[size];
-    uint8_t array_bit_7[size];
-
-    uint8_t array_bit_8[size];
-    uint8_t array_bit_9[size];
-    uint8_t array_bit_10[size];
-    uint8_t array_bit_11[size];
-
-    for (size_t i = 0; i < size; i++) {
-        byte = (uint8_t) chars[i];
-        generate_array_of_bits_from_character(array_of_bits, BITS_PER_BYTE, byte);
-        generate_array_of_hamming_bits(array_hamming, array_of_bits, parity_int);
-
-        array_bit_0[i] = array_of_bits[0];
-        array_bit_1[i] = array_of_bits[1];
-        array_bit_2[i] = array_of_bits[2];
-        array_bit_3[i] = array_of_bits[3];
-        array_bit_4[i] = array_of_bits[4];
-        array_bit_5[i] = array_of_bits[5];
-        array_bit_6[i] = array_of_bits[6];
-        array_bit_7[i] = array_of_bits[7];
-
-        array_bit_8[i] = array_hamming[0];
-        array_bit_9[i] = array_hamming[1];
-        array_bit_10[i] = array_hamming[2];
-        array_bit_11[i] = array_hamming[3];
+    if (hamming_parse_size(dc_setting_string_get(env, app_settings->chunk_size), &options.chunk_size) == -1) {
+        printf("Incorrect chunk size entered! Use a number of characters such as 4096 or 64K\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_count(dc_setting_string_get(env, app_settings->threads), HAMMING_POOL_MAX_WORKERS,
+                            &threads) == -1) {
+        printf("Incorrect number of threads entered! Use 0 to %d\n", HAMMING_POOL_MAX_WORKERS);
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_stores(dc_setting_string_get(env, app_settings->stores), &stores) == -1) {
+        printf("Incorrect stores entered! Either 'auto', 'cached' or 'streaming'\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_size(dc_setting_string_get(env, app_settings->parallel_threshold), &parallel_threshold) == -1) {
+        printf("Incorrect parallel threshold entered! Use a number of characters such as 1M, 0 for none\n");
+        exit(EXIT_FAILURE);
+    }
+
+    hamming_set_store_kernel(stores);
+    options.binary = dc_setting_bool_get(env, app_settings->binary);
+    options.direct_io = dc_setting_bool_get(env, app_settings->direct_io);
+    options.elide_constant = dc_setting_bool_get(env, app_settings->elide_constant);
+    options.sparse = dc_setting_bool_get(env, app_settings->sparse);
+    options.huge_pages = dc_setting_bool_get(env, app_settings->huge_pages);
+
+    if (dc_setting_bool_get(env, app_settings->count_syscalls)) {
+        hamming_syscalls_start();
+        atexit(print_syscalls);
     }
 
-    size_t nbyte = (size_t)(((size - 1) / BITS_PER_BYTE) + 1);
-// length of write_file_value depends on number of letters if < mod 8
-    char write_file_value[MAX_FILE_LENGTH] = {0};
-
-    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
-        uint8_t writeValue = 0;
-        // positions of byte.
-        for (size_t pos = 0; pos < nbyte; pos++) {
-            writeValue = 0;
-            size_t upper_limit;
-            if (size < (BITS_PER_BYTE * (pos + 1))) {
-                upper_limit = size;
-            } else upper_limit = BITS_PER_BYTE * (pos + 1);
-            if (index == 0) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_0[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 1) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_1[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 2) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_2[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 3) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-
-                    if (array_bit_3[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 4) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_4[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 5) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-
-                    if (array_bit_5[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 6) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-
-                    if (array_bit_6[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 7) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-
-                    if (array_bit_7[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 8) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_8[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 9) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_9[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 10) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_10[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            } else if (index == 11) {
-                for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
-                    if (array_bit_11[j] == 1) {
-                        writeValue |= B00000001;
-                    }
-                    if (j != upper_limit - 1) { writeValue <<= 1; }
-                }
-            }
-            write_file_value[pos] = (char) writeValue;
+    if (dc_setting_string_get(env, app_settings->trace_file) != NULL) {
+        if (hamming_trace_start(err, dc_setting_string_get(env, app_settings->trace_file)) == -1) {
+            return EXIT_FAILURE;
         }
-        snprintf(path, len + 1, "%s_%zu.hamming", prefix, index); // puts string into buffer
-        fd = dc_open(env, err, path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, modes);
-        if (dc_error_has_no_error(err)) {
-            dc_write(env, err, fd, write_file_value, nbyte);
-            dc_dc_close(env, err, fd);
+
+        atexit(write_trace);
+    }
+
+    if (hamming_parse_limit(dc_setting_string_get(env, app_settings->max_read_mbps), &limits.read_mbps) == -1 ||
+        hamming_parse_limit(dc_setting_string_get(env, app_settings->max_write_mbps), &limits.write_mbps) == -1 ||
+        hamming_parse_limit(dc_setting_string_get(env, app_settings->max_iops), &limits.iops) == -1) {
+        printf("Incorrect I/O limit entered! Use a number such as 50 or 12.5, 0 for no limit\n");
+        exit(EXIT_FAILURE);
+    }
+
+    throttled = limits.read_mbps > 0 || limits.write_mbps > 0 || limits.iops > 0;
+
+    if (throttled) {
+        hamming_throttle_start(&limits);
+    }
+
+    // before any worker thread is started, they take the priority of the thread starting them
+    if (dc_setting_bool_get(env, app_settings->idle_io) && hamming_throttle_idle(err) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    if (hamming_durability_parse(env, dc_setting_string_get(env, app_settings->durability), &options.durability) ==
+        -1) {
+        printf("Incorrect durability entered! Either 'none', 'fdatasync', 'batched' or 'syncfs'\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_stripe_set(err, dc_setting_string_get(env, app_settings->plane_dirs)) == -1) {
+        printf("Incorrect plane directories entered! Use 1 to 12 directories separated by commas\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (dc_setting_bool_get(env, app_settings->tune)) {
+        return runTune(env, err, prefix, dc_setting_string_get(env, app_settings->tune_size),
+                       dc_setting_path_get(env, app_settings->opts.parent.config_path));
+    }
+
+    if (dc_setting_bool_get(env, app_settings->archive)) {
+        if (manifest == NULL) {
+            printf("An archive is built from a manifest, use --manifest\n");
+            exit(EXIT_FAILURE);
         }
+
+        return runArchive(env, err, manifest, prefix, &options);
     }
 
-    return EXIT_SUCCESS;
+    if (manifest != NULL) {
+        struct hamming_batch_config config;
+
+        config.mode = HAMMING_BATCH_ENCODE;
+        config.workers = threads;
+        config.encode = options;
+        hamming_decode_options_init(&config.decode);
+
+        return runBatch(env, err, manifest, &config);
+    }
+
+    if (threads > HAMMING_PIPELINE_MAX_WORKERS) {
+        printf("Incorrect number of threads entered! Use 0 to %d\n", HAMMING_PIPELINE_MAX_WORKERS);
+        exit(EXIT_FAILURE);
+    }
+
+    // a small message is encoded before the workers would have started
+    if (threads > 0 && fstat(STDIN_FILENO, &input) == 0 && S_ISREG(input.st_mode) &&
+        (uintmax_t) input.st_size < parallel_threshold) {
+        threads = 0;
+    }
+
+    options.threads = threads;
+
+    if (dc_setting_bool_get(env, app_settings->to_stdout)) {
+        if (hamming_encode_stream(env, err, &arena, STDIN_FILENO, STDOUT_FILENO, &options, &stats) == -1) {
+            ret_val = EXIT_FAILURE;
+        }
+    } else if (hamming_encode(env, err, &arena, STDIN_FILENO, prefix, &options, &stats) == -1) {
+        ret_val = EXIT_FAILURE;
+    } else if (options.durability != HAMMING_DURABILITY_NONE) {
+        fprintf(stderr, "flush: %ju barriers, %.3f s\n", (uintmax_t) stats.flush.barriers, stats.flush.seconds);
+    }
+
+    if (throttled) {
+        hamming_throttle_print(stderr);
+    }
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(env, &arena);
+    }
+
+    return ret_val;
 }
 
+static int runBatch(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *manifest,
+                    const struct hamming_batch_config *config) {
+    struct hamming_batch batch;
+    double start;
+    int failed;
+
+    if (hamming_batch_load(env, err, manifest, &batch) == -1) {
+        hamming_batch_destroy(env, &batch);
+        return EXIT_FAILURE;
+    }
+
+    start = hamming_clock_now();
+    failed = hamming_batch_run(env, err, &batch, config);
+
+    if (failed != -1) {
+        hamming_batch_report(&batch, hamming_clock_now() - start);
+    }
+
+    hamming_batch_destroy(env, &batch);
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int runArchive(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      const char *manifest,
+                      const char *prefix,
+                      const struct hamming_encode_options *options) {
+    struct hamming_batch batch;
+    struct hamming_arena arena = {0};
+    struct hamming_encode_stats stats = {0};
+    double start;
+    int ret_val;
+
+    if (hamming_batch_load(env, err, manifest, &batch) == -1) {
+        hamming_batch_destroy(env, &batch);
+        return EXIT_FAILURE;
+    }
+
+    start = hamming_clock_now();
+    ret_val = hamming_archive_encode(env, err, &arena, &batch, prefix, options, &stats);
+
+    if (ret_val == 0) {
+        printf("archived %zu members, %ju characters in %.3f s\n", batch.count, (uintmax_t) stats.characters,
+               hamming_clock_now() - start);
+    }
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(env, &arena);
+    }
+
+    hamming_batch_destroy(env, &batch);
+
+    return ret_val == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int runTune(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   const char *prefix,
+                   const char *tune_size,
+                   const char *config_path) {
+    struct hamming_tune_result result;
+    size_t size;
+
+    if (config_path == NULL) {
+        printf("The tuned settings are written to the config file, use --config\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_size(tune_size, &size) == -1 || size == 0) {
+        printf("Incorrect tune size entered! Use a number of characters such as 64M\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_tune(env, err, HAMMING_TUNE_ENCODE, prefix, size, stderr, &result) == -1 ||
+        hamming_tune_write_config(env, err, config_path, HAMMING_TUNE_ENCODE, &result) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    printf("chunk-size=%zu threads=%zu stores=%s direct-io=%s parallel-threshold=%zu: %.1f MB/s, written to %s\n",
+           result.chunk_size, result.threads, hamming_stores_name(result.stores), result.direct_io ? "true" : "false",
+           result.parallel_threshold, result.mbps, config_path);
+
+    return EXIT_SUCCESS;
+}
 
 static void error_reporter(const struct dc_error *err) {
     fprintf(stderr, "ERROR: %s : %s : @ %zu : %d\n", err->file_name, err->function_name, err->line_number, 0);
@@ -293,55 +632,18 @@ static void trace_reporter(__attribute__((unused)) const struct dc_posix_env *en
     fprintf(stdout, "TRACE: %s : %s : @ %zu\n", file_name, function_name, line_number);
 }
 
-
-static void
-generate_array_of_hamming_bits(uint8_t array_of_hamming_bits[4], uint8_t array_of_bits[BITS_PER_BYTE], int parity) {
-    int sum_of_8s_mod2 = (array_of_bits[4] + array_of_bits[5] + array_of_bits[6] + array_of_bits[7]) % 2;
-    int sum_of_4s_mod2 = (array_of_bits[1] + array_of_bits[2] + array_of_bits[3] + array_of_bits[7]) % 2;
-    int sum_of_2s_mod2 =
-            (array_of_bits[0] + array_of_bits[2] + array_of_bits[3] + array_of_bits[5] + array_of_bits[6]) % 2;
-    int sum_of_1s_mod2 =
-            (array_of_bits[0] + array_of_bits[1] + array_of_bits[3] + array_of_bits[4] + array_of_bits[6]) % 2;
-    // even
-    if (parity == 0) {
-        if (sum_of_1s_mod2 == 1) array_of_hamming_bits[0] = 1;
-        else array_of_hamming_bits[0] = 0;
-        if (sum_of_2s_mod2 == 1) array_of_hamming_bits[1] = 1;
-        else array_of_hamming_bits[1] = 0;
-        if (sum_of_4s_mod2 == 1) array_of_hamming_bits[2] = 1;
-        else array_of_hamming_bits[2] = 0;
-        if (sum_of_8s_mod2 == 1) array_of_hamming_bits[3] = 1;
-        else array_of_hamming_bits[3] = 0;
-    } else { // odd
-        if (sum_of_1s_mod2 == 1) array_of_hamming_bits[0] = 0;
-        else array_of_hamming_bits[0] = 1;
-        if (sum_of_2s_mod2 == 1) array_of_hamming_bits[1] = 0;
-        else array_of_hamming_bits[1] = 1;
-        if (sum_of_4s_mod2 == 1) array_of_hamming_bits[2] = 0;
-        else array_of_hamming_bits[2] = 1;
-        if (sum_of_8s_mod2 == 1) array_of_hamming_bits[3] = 0;
-        else array_of_hamming_bits[3] = 1;
-    }
+static void print_syscalls(void) {
+    hamming_syscalls_print(stderr);
 }
 
-static void
-generate_array_of_bits_from_character(uint8_t array_of_bits[BITS_PER_BYTE], size_t length, const uint8_t byte) {
-    unsigned char masked;
-    uint8_t mask;
-    for (size_t i = 0; i < length; i++) {
-        if (i == 7) mask = B00000001;
-        if (i == 6) mask = B00000010;
-        if (i == 5) mask = B00000100;
-        if (i == 4) mask = B00001000;
-        if (i == 3) mask = B00010000;
-        if (i == 2) mask = B00100000;
-        if (i == 1) mask = B01000000;
-        if (i == 0) mask = B10000000;
-        masked = byte & mask;
-        if (mask == masked) {
-            array_of_bits[i] = 1;
-        } else {
-            array_of_bits[i] = 0;
-        }
+static void write_trace(void) {
+    struct dc_error err;
+
+    dc_error_init(&err, NULL);
+
+    if (hamming_trace_finish(&err) == -1) {
+        fprintf(stderr, "ERROR: the trace file was not written: %s\n", err.message);
     }
+
+    dc_error_reset(&err);
 }
@@ -13,6 +13,21 @@
 #include <dc_posix/dc_string.h>
 #include <dc_posix/dc_fcntl.h>
 #include <dc_posix/dc_unistd.h>
+#include "hamming_arena.h"
+#include "hamming_archive.h"
+#include "hamming_batch.h"
+#include "hamming_clock.h"
+#include "hamming_durability.h"
+#include "hamming_encode.h"
+#include "hamming_options.h"
+#include "hamming_pipeline.h"
+#include "hamming_pool.h"
+#include "hamming_stream.h"
+#include "hamming_stripe.h"
+#include "hamming_syscalls.h"
+#include "hamming_throttle.h"
+#include "hamming_trace.h"
+#include "hamming_tune.h"
 #include <unistd.h>
 #include <sys/stat.h>
 #include <string.h>
@@ -24,25 +39,32 @@
 #include <ctype.h>
 #include <sys/stat.h>
 
-
-#define NUMBER_HAMMING_BITS 4
-#define BITS_PER_BYTE 8
-#define BITS_INC_HAMMING 12
-#define MAX_FILE_LENGTH 4196
-#define BUF_SIZE 1024
-const uint8_t B10000000 = UINT8_C(0x80);
-const uint8_t B01000000 = UINT8_C(0x40);
-const uint8_t B00100000 = UINT8_C(0x20);
-const uint8_t B00010000 = UINT8_C(0x10);
-const uint8_t B00001000 = UINT8_C(0x08);
-const uint8_t B00000100 = UINT8_C(0x04);
-const uint8_t B00000010 = UINT8_C(0x02);
-const uint8_t B00000001 = UINT8_C(0x01);
-
 struct application_settings {
     struct dc_opt_settings opts;
     struct dc_setting_string *parity;
-    struct dc_setting_string *prefix
+    struct dc_setting_string *prefix;
+    struct dc_setting_bool *binary;
+    struct dc_setting_string *chunk_size;
+    struct dc_setting_string *threads;
+    struct dc_setting_string *manifest;
+    struct dc_setting_bool *direct_io;
+    struct dc_setting_string *durability;
+    struct dc_setting_bool *elide_constant;
+    struct dc_setting_bool *sparse;
+    struct dc_setting_bool *count_syscalls;
+    struct dc_setting_bool *to_stdout;
+    struct dc_setting_bool *huge_pages;
+    struct dc_setting_string *max_read_mbps;
+    struct dc_setting_string *max_write_mbps;
+    struct dc_setting_string *max_iops;
+    struct dc_setting_bool *idle_io;
+    struct dc_setting_string *plane_dirs;
+    struct dc_setting_bool *archive;
+    struct dc_setting_bool *tune;
+    struct dc_setting_string *tune_size;
+    struct dc_setting_string *stores;
+    struct dc_setting_string *parallel_threshold;
+    struct dc_setting_string *trace_file
 };
 
 static struct dc_application_settings *create_settings(const struct dc_posix_env *env, struct dc_error *err);
@@ -60,77 +82,50 @@ static void trace_reporter(const struct dc_posix_env *env,
                            const char *function_name,
                            size_t line_number);
 
+static void print_syscalls(void);
 
-/**
- * Creates an array of size 8 from a single character that represents that character's
- * binary value.
- * @param array_of_bits the array that represents binary value of a character
- * @param length length bits per byte
- * @param byte the character to be "binarized"
- */
-static void generate_array_of_bits_from_character(uint8_t array_of_bits[BITS_PER_BYTE], size_t length, uint8_t byte);
-
-/**
- * Creates and add values to an array of size 4 that represents 4 parity bits of a character.
- * @param array_of_hamming_bits the array that represents 4 parity bits of a character
- * @param array_of_bits the array that represents binary value of a character
- * @param parity value, 0 for even, 1 for odd
- */
-static void
-generate_array_of_hamming_bits(uint8_t array_of_hamming_bits[NUMBER_HAMMING_BITS], uint8_t array_of_bits[BITS_PER_BYTE],
-                               int parity);
+static void write_trace(void);
 
 /**
- * Gets the hamming files' size in bytes.
+ * Encodes every job of a manifest and prints a summary.
  * @param env Current working environment
  * @param err Error tracking
- * @param prefix the prefix chosen
- * @param len the length of the files' names
- * @return
+ * @param manifest the path of the manifest
+ * @param config how to run the jobs
+ * @return EXIT_SUCCESS if every job succeeded, EXIT_FAILURE otherwise
  */
-static size_t getFileSizeInBytes(const struct dc_posix_env *env,
-                                 struct dc_error *err,
-                                 const char *prefix,
-                                 size_t len);
+static int runBatch(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *manifest,
+                    const struct hamming_batch_config *config);
 
 /**
- * Inserts items to arrays. At position messageIndex % 8 per nbytes byte (position 0->7)
- * from index file (0->11 files), extract the bit value of the current position and add it
- * to array_bits array of bits or add to hamming_bits array of parity bits.
- * Example, index file from 0 to 7, the bit will be inserted to an array of size 8 to represent a byte of
- * a letter, index file from 8 to 11, the current bit will be inserted to an array of size 4 to represent
- * 4 parity bits of the current letter.
- * @param messageIndex current message index
- * @param index current file index, from 0 to 11 (inclusive)
- * @param nbytes value of the current byte working on
- * @param numOfCharsInMessage is the value of 8 * nbytes
- * @param word the message taken from the file
- * @param array_bits array of 8 integers that represent a single byte in a file at position nbytes - 1
- * @param hamming_bit array of 4 integers that represent 4 parity bits of a letter
- */
-static void insertItemToArray(size_t messageIndex,
-                              size_t index,
-                              size_t nbytes,
-                              size_t numOfCharsInMessage,
-                              char word[MAX_FILE_LENGTH],
-                              uint8_t array_bits[],
-                              uint8_t hamming_bit[]);
-
-/**
- * Checks whether a bit is a 1 or a 0. Returns 1 if the bit is 1, 0 if
- * bit is 0.
- * @param byteToCheck uint8_t checks whether a bit is 1 or 0
- * @return 1 if the bit is 1, 0 if the bit is 0
+ * Encodes every job of a manifest as a member of one archive and prints a summary.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param manifest the path of the manifest, each line a message file and its member id
+ * @param prefix the prefix of the archive
+ * @param options how to encode
+ * @return EXIT_SUCCESS if every member was archived, EXIT_FAILURE otherwise
  */
-static uint8_t checkBit1Or0(uint8_t byteToCheck);
-
-static bool handleErrorDetectionAndPrint(const struct dc_posix_env *env, int parity_int, uint8_t array_bits[],
-                                         uint8_t hamming_bits[]);
+static int runArchive(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      const char *manifest,
+                      const char *prefix,
+                      const struct hamming_encode_options *options);
 
 /**
- * Flips the given bit to the opposite. If the given bit is 0, flip it to 1,
- * and vice versa.
- * @param bitToFlip uint8_t bit represented in type uint8_t to be flipped
- * @return uint8_t the bit after flipped
+ * Times encoding on this host with the settings --tune tries and writes the fastest into
+ * the config file.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix where the scratch plane set goes
+ * @param tune_size the characters of the message to time
+ * @param config_path the config file, NULL if none was given
+ * @return EXIT_SUCCESS if the settings were written, EXIT_FAILURE otherwise
  */
-static uint8_t flipBit(uint8_t bitToFlip);
\ No newline at end of file
+static int runTune(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   const char *prefix,
+                   const char *tune_size,
+                   const char *config_path);
@@ -1,4 +1,4 @@
-#include "ascii2hamming.h"
+#include "hamming2ascii.h"
 
 int main(int argc, char *argv[]) {
     dc_posix_tracer tracer;
@@ -10,7 +10,7 @@ int main(int argc, char *argv[]) {
 
     reporter = error_reporter;
     tracer = trace_reporter;
-    tracer = NULL;
+    tracer = hamming_syscalls_tracer; // counts nothing unless --count-syscalls is given
     dc_error_init(&err, reporter);
     dc_posix_env_init(&env, tracer);
     info = dc_application_info_create(&env, &err, "Hamming Code to ASCII Application");
@@ -23,6 +23,15 @@ int main(int argc, char *argv[]) {
 }
 
 static struct dc_application_settings *create_settings(const struct dc_posix_env *env, struct dc_error *err) {
+    static const bool default_binary = false;
+    static const bool default_direct_io = false;
+    static const bool default_no_verify = false;
+    static const bool default_repair = false;
+    static const bool default_count_syscalls = false;
+    static const bool default_from_stdin = false;
+    static const bool default_huge_pages = false;
+    static const bool default_idle_io = false;
+    static const bool default_tune = false;
     struct application_settings *settings;
 
     DC_TRACE(env);
@@ -35,6 +44,30 @@ static struct dc_application_settings *create_settings(const struct dc_posix_env
     settings->opts.parent.config_path = dc_setting_path_create(env, err);
     settings->parity = dc_setting_string_create(env, err);
     settings->prefix = dc_setting_string_create(env, err);
+    settings->binary = dc_setting_bool_create(env, err);
+    settings->chunk_size = dc_setting_string_create(env, err);
+    settings->threads = dc_setting_string_create(env, err);
+    settings->manifest = dc_setting_string_create(env, err);
+    settings->direct_io = dc_setting_bool_create(env, err);
+    settings->no_verify = dc_setting_bool_create(env, err);
+    settings->repair = dc_setting_bool_create(env, err);
+    settings->count_syscalls = dc_setting_bool_create(env, err);
+    settings->from_stdin = dc_setting_bool_create(env, err);
+    settings->huge_pages = dc_setting_bool_create(env, err);
+    settings->cache_dir = dc_setting_string_create(env, err);
+    settings->cache_size = dc_setting_string_create(env, err);
+    settings->max_read_mbps = dc_setting_string_create(env, err);
+    settings->max_write_mbps = dc_setting_string_create(env, err);
+    settings->max_iops = dc_setting_string_create(env, err);
+    settings->idle_io = dc_setting_bool_create(env, err);
+    settings->sample = dc_setting_string_create(env, err);
+    settings->seed = dc_setting_string_create(env, err);
+    settings->plane_dirs = dc_setting_string_create(env, err);
+    settings->member = dc_setting_string_create(env, err);
+    settings->tune = dc_setting_bool_create(env, err);
+    settings->tune_size = dc_setting_string_create(env, err);
+    settings->parallel_threshold = dc_setting_string_create(env, err);
+    settings->trace_file = dc_setting_string_create(env, err);
 
     struct options opts[] = {
             {(struct dc_setting *) settings->opts.parent.config_path,
@@ -67,13 +100,253 @@ static struct dc_application_settings *create_settings(const struct dc_posix_env
                     "prefix",
                     dc_string_from_config,
                     "file"},
+            {(struct dc_setting *) settings->binary,
+                    dc_options_set_bool,
+                    "binary",
+                    no_argument,
+                    'b',
+                    "BINARY",
+                    dc_flag_from_string,
+                    "binary",
+                    dc_flag_from_config,
+                    &default_binary},
+            {(struct dc_setting *) settings->chunk_size,
+                    dc_options_set_string,
+                    "chunk-size",
+                    required_argument,
+                    'k',
+                    "CHUNK_SIZE",
+                    dc_string_from_string,
+                    "chunk-size",
+                    dc_string_from_config,
+                    "64K"},
+            {(struct dc_setting *) settings->threads,
+                    dc_options_set_string,
+                    "threads",
+                    required_argument,
+                    't',
+                    "THREADS",
+                    dc_string_from_string,
+                    "threads",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->manifest,
+                    dc_options_set_string,
+                    "manifest",
+                    required_argument,
+                    'm',
+                    "MANIFEST",
+                    dc_string_from_string,
+                    "manifest",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->direct_io,
+                    dc_options_set_bool,
+                    "direct-io",
+                    no_argument,
+                    'd',
+                    "DIRECT_IO",
+                    dc_flag_from_string,
+                    "direct-io",
+                    dc_flag_from_config,
+                    &default_direct_io},
+            {(struct dc_setting *) settings->no_verify,
+                    dc_options_set_bool,
+                    "no-verify",
+                    no_argument,
+                    'n',
+                    "NO_VERIFY",
+                    dc_flag_from_string,
+                    "no-verify",
+                    dc_flag_from_config,
+                    &default_no_verify},
+            {(struct dc_setting *) settings->repair,
+                    dc_options_set_bool,
+                    "repair",
+                    no_argument,
+                    'r',
+                    "REPAIR",
+                    dc_flag_from_string,
+                    "repair",
+                    dc_flag_from_config,
+                    &default_repair},
+            {(struct dc_setting *) settings->count_syscalls,
+                    dc_options_set_bool,
+                    "count-syscalls",
+                    no_argument,
+                    'C',
+                    "COUNT_SYSCALLS",
+                    dc_flag_from_string,
+                    "count-syscalls",
+                    dc_flag_from_config,
+                    &default_count_syscalls},
+            {(struct dc_setting *) settings->from_stdin,
+                    dc_options_set_bool,
+                    "stdin",
+                    no_argument,
+                    'i',
+                    "STDIN",
+                    dc_flag_from_string,
+                    "stdin",
+                    dc_flag_from_config,
+                    &default_from_stdin},
+            {(struct dc_setting *) settings->huge_pages,
+                    dc_options_set_bool,
+                    "huge-pages",
+                    no_argument,
+                    'H',
+                    "HUGE_PAGES",
+                    dc_flag_from_string,
+                    "huge-pages",
+                    dc_flag_from_config,
+                    &default_huge_pages},
+            {(struct dc_setting *) settings->cache_dir,
+                    dc_options_set_string,
+                    "cache-dir",
+                    required_argument,
+                    'D',
+                    "CACHE_DIR",
+                    dc_string_from_string,
+                    "cache-dir",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->cache_size,
+                    dc_options_set_string,
+                    "cache-size",
+                    required_argument,
+                    'S',
+                    "CACHE_SIZE",
+                    dc_string_from_string,
+                    "cache-size",
+                    dc_string_from_config,
+                    "1G"},
+            {(struct dc_setting *) settings->max_read_mbps,
+                    dc_options_set_string,
+                    "max-read-mbps",
+                    required_argument,
+                    'R',
+                    "MAX_READ_MBPS",
+                    dc_string_from_string,
+                    "max-read-mbps",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->max_write_mbps,
+                    dc_options_set_string,
+                    "max-write-mbps",
+                    required_argument,
+                    'W',
+                    "MAX_WRITE_MBPS",
+                    dc_string_from_string,
+                    "max-write-mbps",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->max_iops,
+                    dc_options_set_string,
+                    "max-iops",
+                    required_argument,
+                    'I',
+                    "MAX_IOPS",
+                    dc_string_from_string,
+                    "max-iops",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->idle_io,
+                    dc_options_set_bool,
+                    "idle-io",
+                    no_argument,
+                    'L',
+                    "IDLE_IO",
+                    dc_flag_from_string,
+                    "idle-io",
+                    dc_flag_from_config,
+                    &default_idle_io},
+            {(struct dc_setting *) settings->sample,
+                    dc_options_set_string,
+                    "sample",
+                    required_argument,
+                    'a',
+                    "SAMPLE",
+                    dc_string_from_string,
+                    "sample",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->seed,
+                    dc_options_set_string,
+                    "seed",
+                    required_argument,
+                    'G',
+                    "SEED",
+                    dc_string_from_string,
+                    "seed",
+                    dc_string_from_config,
+                    "1"},
+            {(struct dc_setting *) settings->plane_dirs,
+                    dc_options_set_string,
+                    "plane-dirs",
+                    required_argument,
+                    'P',
+                    "PLANE_DIRS",
+                    dc_string_from_string,
+                    "plane-dirs",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->member,
+                    dc_options_set_string,
+                    "member",
+                    required_argument,
+                    'M',
+                    "MEMBER",
+                    dc_string_from_string,
+                    "member",
+                    dc_string_from_config,
+                    NULL},
+            {(struct dc_setting *) settings->tune,
+                    dc_options_set_bool,
+                    "tune",
+                    no_argument,
+                    'U',
+                    "TUNE",
+                    dc_flag_from_string,
+                    "tune",
+                    dc_flag_from_config,
+                    &default_tune},
+            {(struct dc_setting *) settings->tune_size,
+                    dc_options_set_string,
+                    "tune-size",
+                    required_argument,
+                    'Z',
+                    "TUNE_SIZE",
+                    dc_string_from_string,
+                    "tune-size",
+                    dc_string_from_config,
+                    "64M"},
+            {(struct dc_setting *) settings->parallel_threshold,
+                    dc_options_set_string,
+                    "parallel-threshold",
+                    required_argument,
+                    'Q',
+                    "PARALLEL_THRESHOLD",
+                    dc_string_from_string,
+                    "parallel-threshold",
+                    dc_string_from_config,
+                    "0"},
+            {(struct dc_setting *) settings->trace_file,
+                    dc_options_set_string,
+                    "trace-file",
+                    required_argument,
+                    'J',
+                    "TRACE_FILE",
+                    dc_string_from_string,
+                    "trace-file",
+                    dc_string_from_config,
+                    NULL},
     };
 
     settings->opts.opts_count = (sizeof(opts) / sizeof(struct options)) + 1;
     settings->opts.opts_size = sizeof(struct options);
     settings->opts.opts = dc_calloc(env, err, settings->opts.opts_count, settings->opts.opts_size);
     dc_memcpy(env, settings->opts.opts, opts, sizeof(opts));
-    settings->opts.flags = "p:e:";
+    settings->opts.flags = "p:e:bk:t:m:dnrCiHD:S:R:W:I:La:G:P:M:UZ:Q:J:";
     settings->opts.env_prefix = "ASCII_HAMMING_";
     return (struct dc_application_settings *) settings;
 }
@@ -87,6 +360,30 @@ static int destroy_settings(const struct dc_posix_env *env,
     app_settings = (struct application_settings *) *psettings;
     dc_setting_string_destroy(env, &app_settings->parity);
     dc_setting_string_destroy(env, &app_settings->prefix);
+    dc_setting_bool_destroy(env, &app_settings->binary);
+    dc_setting_string_destroy(env, &app_settings->chunk_size);
+    dc_setting_string_destroy(env, &app_settings->threads);
+    dc_setting_string_destroy(env, &app_settings->manifest);
+    dc_setting_bool_destroy(env, &app_settings->direct_io);
+    dc_setting_bool_destroy(env, &app_settings->no_verify);
+    dc_setting_bool_destroy(env, &app_settings->repair);
+    dc_setting_bool_destroy(env, &app_settings->count_syscalls);
+    dc_setting_bool_destroy(env, &app_settings->from_stdin);
+    dc_setting_bool_destroy(env, &app_settings->huge_pages);
+    dc_setting_string_destroy(env, &app_settings->cache_dir);
+    dc_setting_string_destroy(env, &app_settings->cache_size);
+    dc_setting_string_destroy(env, &app_settings->max_read_mbps);
+    dc_setting_string_destroy(env, &app_settings->max_write_mbps);
+    dc_setting_string_destroy(env, &app_settings->max_iops);
+    dc_setting_bool_destroy(env, &app_settings->idle_io);
+    dc_setting_string_destroy(env, &app_settings->sample);
+    dc_setting_string_destroy(env, &app_settings->seed);
+    dc_setting_string_destroy(env, &app_settings->plane_dirs);
+    dc_setting_string_destroy(env, &app_settings->member);
+    dc_setting_bool_destroy(env, &app_settings->tune);
+    dc_setting_string_destroy(env, &app_settings->tune_size);
+    dc_setting_string_destroy(env, &app_settings->parallel_threshold);
+    dc_setting_string_destroy(env, &app_settings->trace_file);
     dc_free(env, app_settings->opts.opts, app_settings->opts.opts_count);
     dc_free(env, *psettings, sizeof(struct application_settings));
 
@@ -100,235 +397,303 @@ static int run(const struct dc_posix_env *env, struct dc_error *err, struct dc_a
     struct application_settings *app_settings;
     const char *parity;
     const char *prefix;
-    bool error_in_message;
+    const char *manifest;
     DC_TRACE(env);
     int return_value = EXIT_SUCCESS;
-    // parity int 0 for even, 1 for odd.
-    int parity_int;
-    int fd;
+    size_t threads;
+    struct hamming_decode_options options;
+    struct hamming_arena arena = {0};
+    struct hamming_decode_stats stats = {0};
+    struct hamming_throttle_limits limits;
+    size_t parallel_threshold;
+    bool throttled;
 
     app_settings = (struct application_settings *) settings;
     parity = dc_setting_string_get(env, app_settings->parity);
     prefix = dc_setting_string_get(env, app_settings->prefix);
+    manifest = dc_setting_string_get(env, app_settings->manifest);
+    hamming_decode_options_init(&options);
+    options.binary = dc_setting_bool_get(env, app_settings->binary);
+    options.direct_io = dc_setting_bool_get(env, app_settings->direct_io);
+    options.verify = !dc_setting_bool_get(env, app_settings->no_verify);
+    options.repair = dc_setting_bool_get(env, app_settings->repair);
+    options.huge_pages = dc_setting_bool_get(env, app_settings->huge_pages);
+    options.cache_dir = dc_setting_string_get(env, app_settings->cache_dir);
+
+    if (dc_setting_bool_get(env, app_settings->count_syscalls)) {
+        hamming_syscalls_start();
+        atexit(print_syscalls);
+    }
 
-    const size_t len = dc_strlen(env, prefix) + 11;
-    char path[len];
+    if (dc_setting_string_get(env, app_settings->trace_file) != NULL) {
+        if (hamming_trace_start(err, dc_setting_string_get(env, app_settings->trace_file)) == -1) {
+            return EXIT_FAILURE;
+        }
 
-    if (!dc_strcmp(env, parity, "odd")) parity_int = 1;
-    else if (!dc_strcmp(env, parity, "even")) parity_int = 0;
-    else {
-        printf("Incorrect parity entered! Either 'even' or 'odd', default is 'even' (case sensitive)\n");
+        atexit(write_trace);
+    }
+
+    if (hamming_parse_limit(dc_setting_string_get(env, app_settings->max_read_mbps), &limits.read_mbps) == -1 ||
+        hamming_parse_limit(dc_setting_string_get(env, app_settings->max_write_mbps), &limits.write_mbps) == -1 ||
+        hamming_parse_limit(dc_setting_string_get(env, app_settings->max_iops), &limits.iops) == -1) {
+        printf("Incorrect I/O limit entered! Use a number such as 50 or 12.5, 0 for no limit\n");
         exit(EXIT_FAILURE);
     }
-    // get number of bytes in file
-    size_t size = getFileSizeInBytes(env, err, prefix, len);
-
-    uint8_t array_bits[BITS_PER_BYTE] = {0};
-    uint8_t hamming_bits[NUMBER_HAMMING_BITS] = {0};
-
-    for (size_t i = 0; i < BITS_PER_BYTE * size; i++) {
-        // Opens 12 files for reading
-        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
-            snprintf(path, len + 1, "%s_%zu.hamming", prefix, index); // puts string into buffer
-            fd = dc_open(env, err, path, DC_O_RDONLY, 0);
-
-            if (dc_error_has_no_error(err)) {
-                ssize_t nread;
-                char word[MAX_FILE_LENGTH];
-                // read the opened file
-                if ((nread = dc_read(env, err, fd, word, MAX_FILE_LENGTH)) > 0) {
-                    if (dc_error_has_error(err)) {
-                        return_value = 1;
-                        break;
-                    }
-                    insertItemToArray(i, index,
-                                      size,
-                                      BITS_PER_BYTE * size,
-                                      word,
-                                      array_bits,
-                                      hamming_bits);
-                }
-            }
-        }
 
-        // Error Detection Code
-        error_in_message = handleErrorDetectionAndPrint(env, parity_int, array_bits, hamming_bits);
+    throttled = limits.read_mbps > 0 || limits.write_mbps > 0 || limits.iops > 0;
+
+    if (throttled) {
+        hamming_throttle_start(&limits);
     }
-    if (error_in_message) {
-        printf("\nThis message might have been altered due to corrupted files.\n");
+
+    // before any worker thread is started, they take the priority of the thread starting them
+    if (dc_setting_bool_get(env, app_settings->idle_io) && hamming_throttle_idle(err) == -1) {
+        return EXIT_FAILURE;
     }
-    return return_value;
-}
 
-static bool handleErrorDetectionAndPrint(const struct dc_posix_env *env, int parity_int, uint8_t array_bits[],
-                                         uint8_t hamming_bits[]) {
-    bool error_in_message = false;
-    int sum_of_8s_mod2 = (array_bits[4] + array_bits[5] + array_bits[6] + array_bits[7]) % 2;
-    int sum_of_4s_mod2 = (array_bits[1] + array_bits[2] + array_bits[3] + array_bits[7]) % 2;
-    int sum_of_2s_mod2 =
-            (array_bits[0] + array_bits[2] + array_bits[3] + array_bits[5] + array_bits[6]) % 2;
-    int sum_of_1s_mod2 =
-            (array_bits[0] + array_bits[1] + array_bits[3] + array_bits[4] + array_bits[6]) % 2;
+    // parity 0 for even, 1 for odd.
+    if (!dc_strcmp(env, parity, "odd")) options.parity = 1;
+    else if (!dc_strcmp(env, parity, "even")) options.parity = 0;
+    else if (!dc_strcmp(env, parity, "auto")) options.parity = HAMMING_PARITY_AUTO;
+    else if (!dc_strcmp(env, parity, "check")) options.parity = HAMMING_PARITY_CHECK;
+    else {
+        printf("Incorrect parity entered! Either 'even', 'odd', 'auto' or 'check', default is 'even' (case "
+               "sensitive)\n");
+        exit(EXIT_FAILURE);
+    }
 
-    int errors = 0;
-    bool error_pos_8 = false;
-    bool error_pos_4 = false;
-    bool error_pos_2 = false;
-    bool error_pos_1 = false;
-    uint8_t value = 0;
-    uint8_t bit_mask = B00000001;
+    if (hamming_parse_size(dc_setting_string_get(env, app_settings->chunk_size), &options.chunk_size) == -1) {
+        printf("Incorrect chunk size entered! Use a number of characters such as 4096 or 64K\n");
+        exit(EXIT_FAILURE);
+    }
 
+    if (hamming_stripe_set(err, dc_setting_string_get(env, app_settings->plane_dirs)) == -1) {
+        printf("Incorrect plane directories entered! Use 1 to 12 directories separated by commas\n");
+        exit(EXIT_FAILURE);
+    }
 
-    if ((sum_of_8s_mod2 + hamming_bits[3]) % 2 == !parity_int) {
-        errors++;
-        error_pos_8 = true;
+    if (hamming_parse_size(dc_setting_string_get(env, app_settings->cache_size), &options.cache_size) == -1) {
+        printf("Incorrect cache size entered! Use a number of bytes such as 512M or 4G\n");
+        exit(EXIT_FAILURE);
     }
-    if ((sum_of_4s_mod2 + hamming_bits[2]) % 2 == !parity_int) {
-        error_pos_4 = true;
-        errors++;
+
+    if (hamming_parse_count(dc_setting_string_get(env, app_settings->threads), HAMMING_POOL_MAX_WORKERS,
+                            &threads) == -1) {
+        printf("Incorrect number of threads entered! Use 0 to %d\n", HAMMING_POOL_MAX_WORKERS);
+        exit(EXIT_FAILURE);
     }
-    if ((sum_of_2s_mod2 + hamming_bits[1]) % 2 == !parity_int) {
-        error_pos_2 = true;
-        errors++;
+
+    if (hamming_parse_size(dc_setting_string_get(env, app_settings->parallel_threshold), &parallel_threshold) == -1) {
+        printf("Incorrect parallel threshold entered! Use a number of characters such as 1M, 0 for none\n");
+        exit(EXIT_FAILURE);
     }
-    if ((sum_of_1s_mod2 + hamming_bits[0]) % 2 == !parity_int) {
-        error_pos_1 = true;
-        errors++;
+
+    if (dc_setting_bool_get(env, app_settings->tune)) {
+        return runTune(env, err, prefix, dc_setting_string_get(env, app_settings->tune_size),
+                       dc_setting_path_get(env, app_settings->opts.parent.config_path));
     }
 
-    if (errors == 2 || errors == 0) {
-        if (error_pos_1 && error_pos_2) {
+    if (dc_setting_string_get(env, app_settings->sample) != NULL) {
+        return runSample(env, err, prefix, options.parity, dc_setting_string_get(env, app_settings->sample),
+                         dc_setting_string_get(env, app_settings->seed));
+    }
 
-            array_bits[0] = flipBit(array_bits[0]);
+    if (manifest != NULL) {
+        struct hamming_batch_config config;
 
-        } else if (error_pos_1 && error_pos_4) {
+        config.mode = HAMMING_BATCH_DECODE;
+        config.workers = threads;
+        hamming_encode_options_init(&config.encode);
+        config.decode = options;
 
-            array_bits[1] = flipBit(array_bits[1]);
+        return runBatch(env, err, manifest, &config);
+    }
 
-        } else if (error_pos_1 && error_pos_8) {
+    if (threads > HAMMING_PIPELINE_MAX_WORKERS) {
+        printf("Incorrect number of threads entered! Use 0 to %d\n", HAMMING_PIPELINE_MAX_WORKERS);
+        exit(EXIT_FAILURE);
+    }
 
-            array_bits[4] = flipBit(array_bits[4]);
+    options.threads = threads;
 
-        } else if (error_pos_2 && error_pos_4) {
+    // a small message is decoded before the workers would have started
+    if (threads > 0 && parallel_threshold > 0 && dc_setting_string_get(env, app_settings->member) == NULL &&
+        !dc_setting_bool_get(env, app_settings->from_stdin)) {
+        struct dc_error meta_err;
+        struct hamming_meta meta;
 
-            array_bits[2] = flipBit(array_bits[2]);
+        dc_error_init(&meta_err, NULL);
 
-        } else if (error_pos_2 && error_pos_8) {
+        if (hamming_meta_read(env, &meta_err, prefix, &meta) == 0 && meta.length < parallel_threshold) {
+            options.threads = 0;
+        }
 
-            array_bits[5] = flipBit(array_bits[5]);
+        dc_error_reset(&meta_err);
+    }
 
-        } else if (error_pos_4 && error_pos_8) {
+    if (dc_setting_string_get(env, app_settings->member) != NULL) {
+        size_t member;
 
-            array_bits[7] = flipBit(array_bits[7]);
+        if (hamming_parse_count(dc_setting_string_get(env, app_settings->member), SIZE_MAX, &member) == -1) {
+            printf("Incorrect member entered! Use the decimal id the member was archived with\n");
+            exit(EXIT_FAILURE);
+        }
 
+        if (hamming_archive_decode(env, err, &arena, prefix, (uint64_t) member, STDOUT_FILENO, &options, &stats) ==
+            -1) {
+            return_value = EXIT_FAILURE;
         }
-    } else {
-        error_in_message = true;
-    }
-    for (size_t q = 0; q < BITS_PER_BYTE; q++) {
-        if (array_bits[q] == 1) {
-            value |= bit_mask;
+    } else if (dc_setting_bool_get(env, app_settings->from_stdin)) {
+        if (hamming_decode_stream(env, err, &arena, STDIN_FILENO, STDOUT_FILENO, &options, &stats) == -1) {
+            return_value = EXIT_FAILURE;
         }
-        if (q != 7) {
-            value <<= 1;
+    } else if (hamming_decode(env, err, &arena, prefix, STDOUT_FILENO, &options, &stats) == -1) {
+        return_value = EXIT_FAILURE;
+    }
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(env, &arena);
+    }
+
+    if (throttled) {
+        hamming_throttle_print(stderr);
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (stats.erased & HAMMING_PLANE_BIT(index)) {
+            fprintf(stderr, "Plane %zu was missing or short and has been rebuilt from the others%s.\n", index,
+                    options.repair && return_value == EXIT_SUCCESS ? " and written back" : "");
         }
     }
-    if (isprint(value)) {
-        printf("%c", (char) value);
+
+    if (stats.parity_detected) {
+        fprintf(stderr, "Parity %s was %s.\n", stats.parity ? "odd" : "even",
+                stats.parity_sampled ? "detected from the planes" : "read from the sidecar");
     }
-    return error_in_message;
-}
 
-static uint8_t flipBit(uint8_t bitToFlip) {
-    if (bitToFlip == 0) {
-        return 1;
+    if (stats.parity_mismatch) {
+        fprintf(stderr, "The sidecar records %s parity, but the planes were encoded with %s.\n",
+                stats.parity ? "even" : "odd", stats.parity ? "odd" : "even");
     }
-    return 0;
-}
 
-static void insertItemToArray(size_t messageIndex,
-                              size_t index,
-                              size_t nbytes,
-                              size_t numOfCharsInMessage,
-                              char word[MAX_FILE_LENGTH],
-                              uint8_t array_bits[],
-                              uint8_t hamming_bit[]) {
-    uint8_t byte = (uint8_t) word[messageIndex / BITS_PER_BYTE];
-
-    // if last byte of reading file
-    if ((messageIndex / BITS_PER_BYTE) + 1 == nbytes) {
-        messageIndex += (BITS_PER_BYTE - (numOfCharsInMessage - BITS_PER_BYTE * (nbytes - 1)));
-    }
-    uint8_t add;
-    if (messageIndex % BITS_PER_BYTE == 0) {
-        byte &= B10000000;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 1) {
-        byte &= B01000000;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 2) {
-        byte &= B00100000;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 3) {
-        byte &= B00010000;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 4) {
-        byte &= B00001000;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 5) {
-        byte &= B00000100;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 6) {
-        byte &= B00000010;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    } else if (messageIndex % BITS_PER_BYTE == 7) {
-        byte &= B00000001;
-        byte |= 0;
-        add = checkBit1Or0(byte);
-    }
-
-    if (index <= 7) {
-        array_bits[index] = add;
-    } else {
-        hamming_bit[index - BITS_PER_BYTE] = add;
+    if (stats.uncorrectable > 0) {
+        // keep binary output byte exact
+        fprintf(options.binary ? stderr : stdout, "\nThis message might have been altered due to corrupted files.\n");
     }
+
+    return return_value;
 }
 
-static uint8_t checkBit1Or0(uint8_t byteToCheck) {
-    if (byteToCheck == 0) {
-        return 0;
-    } else {
-        return 1;
+static int runBatch(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *manifest,
+                    const struct hamming_batch_config *config) {
+    struct hamming_batch batch;
+    double start;
+    int failed;
+
+    if (hamming_batch_load(env, err, manifest, &batch) == -1) {
+        hamming_batch_destroy(env, &batch);
+        return EXIT_FAILURE;
     }
+
+    start = hamming_clock_now();
+    failed = hamming_batch_run(env, err, &batch, config);
+
+    if (failed != -1) {
+        hamming_batch_report(&batch, hamming_clock_now() - start);
+    }
+
+    hamming_batch_destroy(env, &batch);
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
-static size_t getFileSizeInBytes(const struct dc_posix_env *env,
-                                 struct dc_error *err,
-                                 const char *prefix,
-                                 size_t len) {
-    int fd;
-    char path[len];
-    snprintf(path, len + 1, "%s_0.hamming", prefix); // puts string into buffer
-    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
-    if (dc_error_has_no_error(err)) {
-        ssize_t nread;
-        char word[MAX_FILE_LENGTH];
-        // read the opened file
-        if ((nread = dc_read(env, err, fd, word, MAX_FILE_LENGTH)) > 0) {
-            if (dc_error_has_error(err)) {
-                exit(1);
-            }
-            return (size_t) nread;
+static int runSample(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const char *prefix,
+                     int parity,
+                     const char *rate,
+                     const char *seed) {
+    struct hamming_sample_report report;
+    struct hamming_arena arena = {0};
+    double sample_rate;
+    size_t sample_seed;
+    int ret_val;
+
+    if (hamming_parse_rate(rate, &sample_rate) == -1 || sample_rate <= 0) {
+        printf("Incorrect sample rate entered! Use the fraction of the blocks to check, such as 0.01\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_count(seed, SIZE_MAX, &sample_seed) == -1) {
+        printf("Incorrect seed entered! Use a decimal number\n");
+        exit(EXIT_FAILURE);
+    }
+
+    ret_val = 0;
+
+    if (parity == HAMMING_PARITY_AUTO || parity == HAMMING_PARITY_CHECK) {
+        struct hamming_parity_guess guess;
+
+        ret_val = hamming_find_parity(env, err, &arena, prefix, parity == HAMMING_PARITY_CHECK, &guess);
+        parity = guess.parity;
+
+        if (ret_val == 0 && !guess.sampled) {
+            printf("parity: %s, recorded\n", parity ? "odd" : "even");
+        } else if (ret_val == 0 && guess.recorded != HAMMING_META_NO_PARITY && guess.recorded != parity) {
+            printf("parity: %s, detected, the sidecar records %s\n", parity ? "odd" : "even",
+                   guess.recorded ? "odd" : "even");
+        } else if (ret_val == 0) {
+            printf("parity: %s, detected\n", parity ? "odd" : "even");
         }
     }
-    exit(EXIT_FAILURE);
+
+    if (ret_val == 0) {
+        ret_val = hamming_sample(env, err, &arena, prefix, parity, sample_rate, (uint64_t) sample_seed, &report);
+    }
+
+    if (arena.base != NULL) {
+        hamming_arena_destroy(env, &arena);
+    }
+
+    if (ret_val == -1) {
+        return EXIT_FAILURE;
+    }
+
+    hamming_sample_print(stdout, &report);
+
+    return EXIT_SUCCESS;
+}
+
+static int runTune(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   const char *prefix,
+                   const char *tune_size,
+                   const char *config_path) {
+    struct hamming_tune_result result;
+    size_t size;
+
+    if (config_path == NULL) {
+        printf("The tuned settings are written to the config file, use --config\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_size(tune_size, &size) == -1 || size == 0) {
+        printf("Incorrect tune size entered! Use a number of characters such as 64M\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_tune(env, err, HAMMING_TUNE_DECODE, prefix, size, stderr, &result) == -1 ||
+        hamming_tune_write_config(env, err, config_path, HAMMING_TUNE_DECODE, &result) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    printf("chunk-size=%zu threads=%zu direct-io=%s parallel-threshold=%zu: %.1f MB/s, written to %s\n",
+           result.chunk_size, result.threads, result.direct_io ? "true" : "false", result.parallel_threshold,
+           result.mbps, config_path);
+
+    return EXIT_SUCCESS;
 }
 
 static void error_reporter(const struct dc_error *err) {
@@ -342,3 +707,19 @@ static void trace_reporter(__attribute__((unused)) const struct dc_posix_env *en
                            size_t line_number) {
     fprintf(stdout, "TRACE: %s : %s : @ %zu\n", file_name, function_name, line_number);
 }
+
+static void print_syscalls(void) {
+    hamming_syscalls_print(stderr);
+}
+
+static void write_trace(void) {
+    struct dc_error err;
+
+    dc_error_init(&err, NULL);
+
+    if (hamming_trace_finish(&err) == -1) {
+        fprintf(stderr, "ERROR: the trace file was not written: %s\n", err.message);
+    }
+
+    dc_error_reset(&err);
+}
@@ -13,6 +13,24 @@
 #include <dc_posix/dc_string.h>
 #include <dc_posix/dc_fcntl.h>
 #include <dc_posix/dc_unistd.h>
+#include "hamming_arena.h"
+#include "hamming_archive.h"
+#include "hamming_batch.h"
+#include "hamming_clock.h"
+#include "hamming_decode.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_options.h"
+#include "hamming_pipeline.h"
+#include "hamming_pool.h"
+#include "hamming_sample.h"
+#include "hamming_stream.h"
+#include "hamming_stripe.h"
+#include "hamming_syscalls.h"
+#include "hamming_throttle.h"
+#include "hamming_trace.h"
+#include "hamming_tune.h"
+#include <ctype.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,7 +39,31 @@
 struct application_settings {
     struct dc_opt_settings opts;
     struct dc_setting_string *parity;
-    struct dc_setting_string *prefix
+    struct dc_setting_string *prefix;
+    struct dc_setting_bool *binary;
+    struct dc_setting_string *chunk_size;
+    struct dc_setting_string *threads;
+    struct dc_setting_string *manifest;
+    struct dc_setting_bool *direct_io;
+    struct dc_setting_bool *no_verify;
+    struct dc_setting_bool *repair;
+    struct dc_setting_bool *count_syscalls;
+    struct dc_setting_bool *from_stdin;
+    struct dc_setting_bool *huge_pages;
+    struct dc_setting_string *cache_dir;
+    struct dc_setting_string *cache_size;
+    struct dc_setting_string *max_read_mbps;
+    struct dc_setting_string *max_write_mbps;
+    struct dc_setting_string *max_iops;
+    struct dc_setting_bool *idle_io;
+    struct dc_setting_string *sample;
+    struct dc_setting_string *seed;
+    struct dc_setting_string *plane_dirs;
+    struct dc_setting_string *member;
+    struct dc_setting_bool *tune;
+    struct dc_setting_string *tune_size;
+    struct dc_setting_string *parallel_threshold;
+    struct dc_setting_string *trace_file
 };
 
 
@@ -39,3 +81,53 @@ static void trace_reporter(const struct dc_posix_env *env,
                            const char *file_name,
                            const char *function_name,
                            size_t line_number);
+
+static void print_syscalls(void);
+
+static void write_trace(void);
+
+/**
+ * Decodes every job of a manifest and prints a summary.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param manifest the path of the manifest
+ * @param config how to run the jobs
+ * @return EXIT_SUCCESS if every job succeeded, EXIT_FAILURE otherwise
+ */
+static int runBatch(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *manifest,
+                    const struct hamming_batch_config *config);
+
+/**
+ * Checks a random sample of the blocks of a plane set and prints the estimated error rates.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix the prefix of the plane files
+ * @param parity 0 for even, 1 for odd, HAMMING_PARITY_AUTO to detect it
+ * @param rate the fraction of the blocks to check, as given
+ * @param seed the seed that picks the blocks, as given
+ * @return EXIT_SUCCESS if the sample was checked, EXIT_FAILURE otherwise
+ */
+static int runSample(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const char *prefix,
+                     int parity,
+                     const char *rate,
+                     const char *seed);
+
+/**
+ * Times decoding on this host with the settings --tune tries and writes the fastest into
+ * the config file.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param prefix where the scratch plane set goes
+ * @param tune_size the characters of the message to time
+ * @param config_path the config file, NULL if none was given
+ * @return EXIT_SUCCESS if the settings were written, EXIT_FAILURE otherwise
+ */
+static int runTune(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   const char *prefix,
+                   const char *tune_size,
+                   const char *config_path);
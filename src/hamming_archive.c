@@ -0,0 +1,588 @@
+#include "hamming_archive.h"
+#include "hamming_durability.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_options.h"
+#include "hamming_stripe.h"
+#include <ctype.h>
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Identifies an archive index, padded with zeros.
+ */
+#define INDEX_MAGIC "HAMIDX1"
+
+/**
+ * Appended to the prefix for the index.
+ */
+#define INDEX_SUFFIX ".index"
+
+/**
+ * The start of an index, followed by count entries sorted by id, in host byte order.
+ */
+struct index_header {
+    char magic[8];
+    uint64_t count;
+};
+
+/**
+ * One member of an archive.
+ */
+struct index_entry {
+    uint64_t id;
+    uint64_t start;  // first character, a multiple of 8 with the parity in bit 0
+    uint64_t length; // characters
+};
+
+/**
+ * The plane files being written and the plane bytes waiting to be written to them.
+ */
+struct archive_writer {
+    int fds[BITS_INC_HAMMING];
+    struct hamming_stripe stripe;
+    struct hamming_buffers buffers;
+    uint8_t *stage[BITS_INC_HAMMING];
+    size_t stage_size;
+    size_t staged;      // bytes waiting in each stage buffer
+    uint64_t position;  // characters in the plane files once the stage is written
+};
+
+static int index_path(struct dc_error *err, const char *prefix, char *path, size_t size);
+
+static int encode_member(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct archive_writer *writer,
+                         const char *input,
+                         int parity,
+                         bool binary,
+                         uint64_t *length);
+
+static int stage_chunk(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct archive_writer *writer,
+                       size_t count);
+
+static int flush_stage(const struct dc_posix_env *env, struct dc_error *err, struct archive_writer *writer);
+
+static int write_stage_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg);
+
+static int check_ids(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const struct index_entry *entries,
+                     size_t count);
+
+static int compare_ids(const void *left, const void *right);
+
+static int compare_entries(const void *left, const void *right);
+
+static int write_index(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       const struct index_entry *entries,
+                       size_t count,
+                       enum hamming_durability durability);
+
+static int find_member(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       uint64_t id,
+                       struct index_entry *entry);
+
+int hamming_archive_encode(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           struct hamming_arena *arena,
+                           const struct hamming_batch *batch,
+                           const char *prefix,
+                           const struct hamming_encode_options *options,
+                           struct hamming_encode_stats *stats) {
+    struct archive_writer writer;
+    struct index_entry *entries;
+    struct hamming_meta meta;
+    size_t chunk_size = hamming_chunk_size(options->chunk_size);
+    size_t entries_size = batch->count * sizeof(struct index_entry);
+    int ret_val = 0;
+
+    DC_TRACE(env);
+    writer.stage_size = chunk_size / BITS_PER_BYTE > HAMMING_ARCHIVE_STAGE_SIZE ? chunk_size / BITS_PER_BYTE
+                                                                                : HAMMING_ARCHIVE_STAGE_SIZE;
+    writer.staged = 0;
+    writer.position = 0;
+
+    if (hamming_arena_reserve(env, err, arena,
+                              hamming_buffers_arena_size(chunk_size) +
+                              BITS_INC_HAMMING * hamming_arena_align(writer.stage_size),
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1 ||
+        hamming_buffers_init(arena, &writer.buffers, chunk_size) == -1) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        writer.stage[index] = hamming_arena_alloc(arena, writer.stage_size);
+    }
+
+    entries = dc_malloc(env, err, entries_size);
+
+    if (entries == NULL) {
+        return -1;
+    }
+
+    // the ids are checked before anything is written
+    for (size_t i = 0; i < batch->count; i++) {
+        size_t id;
+
+        if (hamming_parse_count(batch->jobs[i].output, SIZE_MAX, &id) == -1) {
+            DC_ERROR_RAISE_USER(err, "an archive member id is not a decimal number", -1);
+            dc_free(env, entries, entries_size);
+            return -1;
+        }
+
+        entries[i].id = (uint64_t) id;
+    }
+
+    // truncating the planes destroys any archive already there
+    if (check_ids(env, err, entries, batch->count) == -1) {
+        dc_free(env, entries, entries_size);
+        return -1;
+    }
+
+    if (hamming_open_planes(env, err, prefix, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR, writer.fds) ==
+        -1) {
+        dc_free(env, entries, entries_size);
+        return -1;
+    }
+
+    if (hamming_stripe_start(env, err, &writer.stripe) == -1) {
+        hamming_close_planes(env, err, writer.fds);
+        dc_free(env, entries, entries_size);
+        return -1;
+    }
+
+    for (size_t i = 0; i < batch->count && ret_val == 0; i++) {
+        const struct hamming_batch_job *job = &batch->jobs[i];
+        int parity = job->parity == -1 ? options->parity : job->parity;
+
+        // every member starts on a plane byte, so the previous one ended on a whole byte
+        entries[i].start = (writer.position + writer.staged * BITS_PER_BYTE) | (uint64_t) parity;
+        ret_val = encode_member(env, err, &writer, job->input, parity, options->binary, &entries[i].length);
+        stats->characters += entries[i].length;
+    }
+
+    if (ret_val == 0) {
+        ret_val = flush_stage(env, err, &writer);
+    }
+
+    hamming_stripe_stop(&writer.stripe);
+
+    if (ret_val == 0) {
+        ret_val = hamming_durability_planes(env, err, writer.fds, options->durability, false, &stats->flush);
+    }
+
+    hamming_close_planes(env, err, writer.fds);
+    qsort(entries, batch->count, sizeof(struct index_entry), compare_entries);
+
+    if (ret_val == 0 && dc_error_has_no_error(err)) {
+        ret_val = write_index(env, err, prefix, entries, batch->count, options->durability);
+    }
+
+    dc_free(env, entries, entries_size);
+
+    if (ret_val == -1 || dc_error_has_error(err)) {
+        return -1;
+    }
+
+    // the sidecar covers the whole plane set, so a missing plane is found and rebuilt as usual;
+    // it records no parity, the index gives each member its own
+    hamming_meta_init(&meta);
+    meta.length = writer.position;
+
+    if (hamming_meta_write(env, err, prefix, &meta) == -1) {
+        return -1;
+    }
+
+    return hamming_durability_commit(env, err, prefix, options->durability, &stats->flush);
+}
+
+int hamming_archive_decode(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           struct hamming_arena *arena,
+                           const char *prefix,
+                           uint64_t id,
+                           int out_fd,
+                           const struct hamming_decode_options *options,
+                           struct hamming_decode_stats *stats) {
+    struct index_entry entry;
+    struct hamming_meta meta;
+    struct hamming_buffers buffers;
+    size_t chunk_size = hamming_chunk_size(options->chunk_size);
+    size_t erased = BITS_INC_HAMMING;
+    unsigned int erased_planes;
+    uint64_t done = 0;
+    int parity;
+    int fds[BITS_INC_HAMMING];
+
+    DC_TRACE(env);
+
+    if (find_member(env, err, prefix, id, &entry) == -1 || hamming_meta_read(env, err, prefix, &meta) == -1) {
+        return -1;
+    }
+
+    parity = (int) (entry.start & 1U);
+    entry.start &= ~(uint64_t) 1U;
+
+    if (hamming_find_erasures(prefix, HAMMING_ALL_PLANES, meta.length, &erased_planes) == -1) {
+        DC_ERROR_RAISE_USER(err, "no plane file found for the prefix", -1);
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (erased_planes == HAMMING_PLANE_BIT(index)) {
+            erased = index;
+        }
+    }
+
+    if (erased_planes != 0 && erased == BITS_INC_HAMMING) {
+        DC_ERROR_RAISE_USER(err, "more than one plane file is missing or short, the planes cannot be rebuilt", -1);
+        return -1;
+    }
+
+    if (hamming_arena_reserve(env, err, arena, hamming_buffers_arena_size(chunk_size),
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1 ||
+        hamming_buffers_init(arena, &buffers, chunk_size) == -1 ||
+        hamming_open_plane_set(env, err, prefix, HAMMING_ALL_PLANES & ~erased_planes, DC_O_RDONLY, 0, fds) == -1) {
+        return -1;
+    }
+
+    stats->erased |= erased_planes;
+
+    while (done < entry.length) {
+        size_t count = entry.length - done < chunk_size ? (size_t) (entry.length - done) : chunk_size;
+        size_t nbyte = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+        uint8_t *chars = buffers.chars;
+        size_t length = count;
+
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            ssize_t nread;
+
+            if (fds[index] == -1) {
+                continue;
+            }
+
+            nread = hamming_pread_fully(env, err, fds[index], buffers.planes[index], nbyte,
+                                        (entry.start + done) / BITS_PER_BYTE);
+
+            if (nread == -1) {
+                hamming_close_planes(env, err, fds);
+                return -1;
+            }
+
+            if ((size_t) nread != nbyte) {
+                DC_ERROR_RAISE_USER(err, "plane file is shorter than the archive member", -1);
+                hamming_close_planes(env, err, fds);
+                return -1;
+            }
+        }
+
+        if (erased != BITS_INC_HAMMING) {
+            hamming_rebuild_plane(&buffers, count, parity, erased);
+        }
+
+        if (options->verify) {
+            hamming_decode_chunk(&buffers, count, parity, stats);
+        } else {
+            hamming_extract_chunk(&buffers, count, stats);
+        }
+
+        if (!options->binary) {
+            length = 0;
+
+            for (size_t i = 0; i < count; i++) {
+                if (isprint(chars[i])) {
+                    chars[length++] = chars[i];
+                }
+            }
+        }
+
+        if (hamming_write_fully(env, err, out_fd, chars, length) == -1) {
+            hamming_close_planes(env, err, fds);
+            return -1;
+        }
+
+        done += count;
+    }
+
+    hamming_close_planes(env, err, fds);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int index_path(struct dc_error *err, const char *prefix, char *path, size_t size) {
+    int written = snprintf(path, size, "%s%s", prefix, INDEX_SUFFIX);
+
+    if (written < 0 || (size_t) written >= size) {
+        DC_ERROR_RAISE_USER(err, "archive index path is too long", -1);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int encode_member(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct archive_writer *writer,
+                         const char *input,
+                         int parity,
+                         bool binary,
+                         uint64_t *length) {
+    struct hamming_buffers *buffers = &writer->buffers;
+    bool has_carry = false;
+    uint8_t carry = 0;
+    bool final = false;
+    int fd;
+
+    *length = 0;
+    fd = dc_open(env, err, input, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    while (!final) {
+        size_t pending = has_carry ? 1 : 0;
+        size_t count;
+        ssize_t nread;
+
+        buffers->chars[0] = carry;
+
+        // read one byte past the chunk to know whether this is the last one
+        nread = hamming_read_fully(env, err, fd, buffers->chars + pending, buffers->chunk_size + 1 - pending);
+
+        if (nread == -1) {
+            dc_dc_close(env, err, fd);
+            return -1;
+        }
+
+        count = pending + (size_t) nread;
+        final = count <= buffers->chunk_size;
+
+        if (!final) {
+            count = buffers->chunk_size;
+            carry = buffers->chars[buffers->chunk_size];
+            has_carry = true;
+        } else if (!binary && count > 0 && buffers->chars[count - 1] == '\n') {
+            count--;
+        }
+
+        if (count > 0) {
+            hamming_encode_chunk(buffers, count, parity);
+
+            if (stage_chunk(env, err, writer, count) == -1) {
+                dc_dc_close(env, err, fd);
+                return -1;
+            }
+        }
+
+        *length += count;
+    }
+
+    dc_dc_close(env, err, fd);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int stage_chunk(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct archive_writer *writer,
+                       size_t count) {
+    size_t nbyte = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    if (writer->staged + nbyte > writer->stage_size && flush_stage(env, err, writer) == -1) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        memcpy(writer->stage[index] + writer->staged, writer->buffers.planes[index], nbyte);
+    }
+
+    writer->staged += nbyte;
+
+    return 0;
+}
+
+static int flush_stage(const struct dc_posix_env *env, struct dc_error *err, struct archive_writer *writer) {
+    if (writer->staged == 0) {
+        return 0;
+    }
+
+    if (hamming_stripe_run(env, err, &writer->stripe, HAMMING_ALL_PLANES, write_stage_plane, writer) == -1) {
+        return -1;
+    }
+
+    writer->position += writer->staged * BITS_PER_BYTE;
+    writer->staged = 0;
+
+    return 0;
+}
+
+static int write_stage_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg) {
+    const struct archive_writer *writer = arg;
+
+    return hamming_write_fully(env, err, writer->fds[index], writer->stage[index], writer->staged);
+}
+
+static int check_ids(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const struct index_entry *entries,
+                     size_t count) {
+    uint64_t *ids;
+    int ret_val = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    ids = dc_malloc(env, err, count * sizeof(uint64_t));
+
+    if (ids == NULL) {
+        return -1;
+    }
+
+    // the entries stay in input order, the members are written in that order
+    for (size_t i = 0; i < count; i++) {
+        ids[i] = entries[i].id;
+    }
+
+    qsort(ids, count, sizeof(uint64_t), compare_ids);
+
+    for (size_t i = 1; i < count && ret_val == 0; i++) {
+        if (ids[i] == ids[i - 1]) {
+            DC_ERROR_RAISE_USER(err, "an archive member id appears twice", -1);
+            ret_val = -1;
+        }
+    }
+
+    dc_free(env, ids, count * sizeof(uint64_t));
+
+    return ret_val;
+}
+
+static int compare_ids(const void *left, const void *right) {
+    uint64_t a = *(const uint64_t *) left;
+    uint64_t b = *(const uint64_t *) right;
+
+    return (a > b) - (a < b);
+}
+
+static int compare_entries(const void *left, const void *right) {
+    const struct index_entry *a = left;
+    const struct index_entry *b = right;
+
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+static int write_index(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       const struct index_entry *entries,
+                       size_t count,
+                       enum hamming_durability durability) {
+    struct index_header header;
+    char path[PATH_MAX];
+    int fd;
+
+    if (index_path(err, prefix, path, sizeof(path)) == -1) {
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.count = count;
+    fd = dc_open(env, err, path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    if (hamming_write_fully(env, err, fd, &header, sizeof(header)) == 0 &&
+        hamming_write_fully(env, err, fd, entries, count * sizeof(struct index_entry)) == 0 &&
+        durability != HAMMING_DURABILITY_NONE) {
+        dc_fdatasync(env, err, fd);
+    }
+
+    dc_dc_close(env, err, fd);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int find_member(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       uint64_t id,
+                       struct index_entry *entry) {
+    struct index_header header;
+    struct stat status;
+    char path[PATH_MAX];
+    uint64_t low = 0;
+    uint64_t high;
+    int fd;
+
+    if (index_path(err, prefix, path, sizeof(path)) == -1) {
+        return -1;
+    }
+
+    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    if (hamming_pread_fully(env, err, fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header) ||
+        fstat(fd, &status) == -1 || memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+        (uint64_t) status.st_size != sizeof(header) + header.count * sizeof(struct index_entry)) {
+        if (dc_error_has_no_error(err)) {
+            DC_ERROR_RAISE_USER(err, "not an archive index", -1);
+        }
+
+        dc_dc_close(env, err, fd);
+        return -1;
+    }
+
+    high = header.count;
+
+    // one read per probe, the index is never loaded whole
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+
+        if (hamming_pread_fully(env, err, fd, entry, sizeof(*entry),
+                                sizeof(header) + middle * sizeof(struct index_entry)) != (ssize_t) sizeof(*entry)) {
+            if (dc_error_has_no_error(err)) {
+                DC_ERROR_RAISE_USER(err, "archive index is truncated", -1);
+            }
+
+            dc_dc_close(env, err, fd);
+            return -1;
+        }
+
+        if (entry->id == id) {
+            dc_dc_close(env, err, fd);
+            return dc_error_has_error(err) ? -1 : 0;
+        }
+
+        if (entry->id < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    dc_dc_close(env, err, fd);
+    DC_ERROR_RAISE_USER(err, "the archive has no member with that id", -1);
+
+    return -1;
+}
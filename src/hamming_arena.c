@@ -0,0 +1,135 @@
+#include "hamming_arena.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+int hamming_arena_init(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       size_t size,
+                       unsigned int flags) {
+    void *base = NULL;
+    int result;
+
+    DC_TRACE(env);
+    arena->base = NULL;
+    arena->size = hamming_arena_align(size);
+    arena->used = 0;
+    arena->mapped = false;
+
+#ifdef MAP_HUGETLB
+    if (flags & HAMMING_ARENA_HUGE_PAGES) {
+        size_t mapped_size = (arena->size + HAMMING_HUGE_PAGE_SIZE - 1) & ~(HAMMING_HUGE_PAGE_SIZE - 1);
+
+        // fails when no huge pages are reserved, which is not an error
+        base = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (base != MAP_FAILED) {
+            arena->base = base;
+            arena->size = mapped_size;
+            arena->mapped = true;
+
+            return 0;
+        }
+    }
+#endif
+
+#ifdef MADV_HUGEPAGE
+    // without reserved huge pages, transparent huge pages can still back whole aligned 2 MiB runs
+    if (flags & HAMMING_ARENA_HUGE_PAGES) {
+        size_t advised_size = (arena->size + HAMMING_HUGE_PAGE_SIZE - 1) & ~(HAMMING_HUGE_PAGE_SIZE - 1);
+
+        result = posix_memalign(&base, HAMMING_HUGE_PAGE_SIZE, advised_size);
+
+        if (result == 0) {
+            // only a hint, the memory works the same if the kernel ignores it
+            madvise(base, advised_size, MADV_HUGEPAGE);
+            arena->base = base;
+            arena->size = advised_size;
+
+            return 0;
+        }
+    }
+#endif
+
+    (void) flags;
+    result = posix_memalign(&base, HAMMING_ARENA_BASE_ALIGNMENT, arena->size > 0 ? arena->size : HAMMING_ARENA_ALIGNMENT);
+
+    if (result != 0) {
+        DC_ERROR_RAISE_ERRNO(err, result);
+        arena->size = 0;
+
+        return -1;
+    }
+
+    arena->base = base;
+
+    return 0;
+}
+
+int hamming_arena_reserve(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          size_t size,
+                          unsigned int flags) {
+    if (arena->base != NULL && arena->size >= size) {
+        hamming_arena_reset(arena);
+        return 0;
+    }
+
+    if (arena->base != NULL) {
+        hamming_arena_destroy(env, arena);
+    }
+
+    return hamming_arena_init(env, err, arena, size, flags);
+}
+
+void *hamming_arena_alloc(struct hamming_arena *arena, size_t size) {
+    size_t aligned = hamming_arena_align(size);
+    void *memory;
+
+    if (aligned < size || arena->size - arena->used < aligned) {
+        return NULL;
+    }
+
+    memory = arena->base + arena->used;
+    arena->used += aligned;
+
+    return memory;
+}
+
+void *hamming_arena_alloc_aligned(struct hamming_arena *arena, size_t size, size_t alignment) {
+    // the base is page aligned, so aligning the offset aligns the address
+    size_t used = (arena->used + alignment - 1) & ~(alignment - 1);
+
+    if (used > arena->size) {
+        return NULL;
+    }
+
+    arena->used = used;
+
+    return hamming_arena_alloc(arena, size);
+}
+
+void hamming_arena_reset(struct hamming_arena *arena) {
+    arena->used = 0;
+}
+
+void hamming_arena_destroy(const struct dc_posix_env *env, struct hamming_arena *arena) {
+    DC_TRACE(env);
+
+    if (arena->mapped) {
+        munmap(arena->base, arena->size);
+    } else {
+        free(arena->base);
+    }
+
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+    arena->mapped = false;
+}
+
+size_t hamming_arena_align(size_t size) {
+    return (size + HAMMING_ARENA_ALIGNMENT - 1) & ~((size_t) HAMMING_ARENA_ALIGNMENT - 1);
+}
@@ -0,0 +1,520 @@
+#include "hamming_batch.h"
+#include "hamming_arena.h"
+#include "hamming_clock.h"
+#include "hamming_io.h"
+#include "hamming_pool.h"
+#include "hamming_syscalls.h"
+#include "hamming_throttle.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Bytes the manifest buffer grows by.
+ */
+#define MANIFEST_READ_SIZE 4096
+
+/**
+ * Most whitespace separated fields on a manifest line.
+ */
+#define MANIFEST_FIELDS 3
+
+/**
+ * What the pool tasks share. Every worker keeps its own arena so the chunk buffers are
+ * allocated once per worker rather than once per job.
+ */
+struct batch_run {
+    struct hamming_batch *batch;
+    const struct hamming_batch_config *config;
+    struct hamming_arena *arenas;
+};
+
+static int read_manifest(const struct dc_posix_env *env, struct dc_error *err, const char *path, struct hamming_batch *batch);
+
+static int parse_line(const struct dc_posix_env *env, struct dc_error *err, char *line, struct hamming_batch *batch);
+
+static void commit_jobs(const struct dc_posix_env *env, struct dc_error *err, struct hamming_batch *batch);
+
+static int job_device(const struct hamming_batch_job *job, dev_t *device);
+
+static void run_job(const struct dc_posix_env *env, struct dc_error *err, size_t worker, size_t task, void *arg);
+
+static int encode_job(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_arena *arena,
+                      const struct hamming_batch_config *config,
+                      struct hamming_batch_job *job);
+
+static int decode_job(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_arena *arena,
+                      const struct hamming_batch_config *config,
+                      struct hamming_batch_job *job);
+
+int hamming_batch_load(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *path,
+                       struct hamming_batch *batch) {
+    char *line;
+
+    DC_TRACE(env);
+    batch->text = NULL;
+    batch->text_size = 0;
+    batch->jobs = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+    batch->flush.barriers = 0;
+    batch->flush.seconds = 0;
+
+    if (read_manifest(env, err, path, batch) == -1) {
+        return -1;
+    }
+
+    line = batch->text;
+
+    while (line != NULL) {
+        char *end = strchr(line, '\n');
+
+        if (end != NULL) {
+            *end = '\0';
+            end++;
+        }
+
+        if (parse_line(env, err, line, batch) == -1) {
+            return -1;
+        }
+
+        line = end;
+    }
+
+    if (batch->count == 0) {
+        DC_ERROR_RAISE_USER(err, "the manifest has no jobs", -1);
+        return -1;
+    }
+
+    return 0;
+}
+
+int hamming_batch_run(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_batch *batch,
+                      const struct hamming_batch_config *config) {
+    struct batch_run run;
+    size_t workers = config->workers;
+    int failed = 0;
+
+    DC_TRACE(env);
+
+    if (workers == 0) {
+        workers = hamming_pool_default_workers();
+    }
+
+    if (workers > HAMMING_POOL_MAX_WORKERS) {
+        workers = HAMMING_POOL_MAX_WORKERS;
+    }
+
+    if (workers > batch->count) {
+        workers = batch->count;
+    }
+
+    run.batch = batch;
+    run.config = config;
+    run.arenas = hamming_calloc(env, err, workers, sizeof(struct hamming_arena));
+
+    if (run.arenas == NULL) {
+        return -1;
+    }
+
+    if (hamming_pool_run(env, err, workers, batch->count, run_job, &run) == -1) {
+        failed = -1;
+    }
+
+    for (size_t i = 0; i < workers; i++) {
+        if (run.arenas[i].base != NULL) {
+            hamming_arena_destroy(env, &run.arenas[i]);
+        }
+    }
+
+    dc_free(env, run.arenas, workers * sizeof(struct hamming_arena));
+
+    if (failed == -1) {
+        return -1;
+    }
+
+    if (config->mode == HAMMING_BATCH_ENCODE && (config->encode.durability == HAMMING_DURABILITY_BATCHED ||
+                                                 config->encode.durability == HAMMING_DURABILITY_SYNCFS)) {
+        commit_jobs(env, err, batch);
+    }
+
+    for (size_t i = 0; i < batch->count; i++) {
+        if (!batch->jobs[i].ok) {
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+void hamming_batch_report(const struct hamming_batch *batch, double seconds) {
+    uint64_t characters = 0;
+    uint64_t corrected = 0;
+    uint64_t uncorrectable = 0;
+    struct hamming_flush_stats flush = batch->flush;
+    struct hamming_throttle_stats throttle;
+    size_t failed = 0;
+
+    for (size_t i = 0; i < batch->count; i++) {
+        const struct hamming_batch_job *job = &batch->jobs[i];
+
+        if (!job->ok) {
+            printf("FAIL %s -> %s: %s\n", job->input, job->output, job->message);
+            failed++;
+            continue;
+        }
+
+        printf("ok   %s -> %s: %ju characters in %.3f s", job->input, job->output, (uintmax_t) job->characters,
+               job->seconds);
+
+        if (job->stats.corrected > 0 || job->stats.uncorrectable > 0) {
+            printf(", %ju corrected, %ju uncorrectable", (uintmax_t) job->stats.corrected,
+                   (uintmax_t) job->stats.uncorrectable);
+        }
+
+        if (job->stats.parity_detected) {
+            printf(", %s parity %s", job->stats.parity ? "odd" : "even",
+                   job->stats.parity_sampled ? "detected" : "recorded");
+        }
+
+        if (job->stats.parity_mismatch) {
+            printf(", the sidecar records %s", job->stats.parity ? "even" : "odd");
+        }
+
+        if (job->flush.seconds > 0) {
+            printf(", %.3f s flushing", job->flush.seconds);
+        }
+
+        printf("\n");
+        flush.barriers += job->flush.barriers;
+        flush.seconds += job->flush.seconds;
+        characters += job->characters;
+        corrected += job->stats.corrected;
+        uncorrectable += job->stats.uncorrectable;
+    }
+
+    printf("%zu jobs, %zu failed, %ju characters in %.3f s", batch->count, failed, (uintmax_t) characters, seconds);
+
+    if (seconds > 0) {
+        printf(" (%.1f MB/s)", (double) characters / seconds / 1e6);
+    }
+
+    if (corrected > 0 || uncorrectable > 0) {
+        printf(", %ju corrected, %ju uncorrectable", (uintmax_t) corrected, (uintmax_t) uncorrectable);
+    }
+
+    printf("\n");
+
+    if (flush.barriers > 0 || flush.seconds > 0) {
+        printf("flush: %ju barriers, %.3f s\n", (uintmax_t) flush.barriers, flush.seconds);
+    }
+
+    // nothing is counted unless an I/O limit was set
+    hamming_throttle_get(&throttle);
+
+    if (throttle.operations > 0) {
+        printf("throttled: %ju of %ju reads and writes held back for %.3f s\n", (uintmax_t) throttle.waits,
+               (uintmax_t) throttle.operations, throttle.seconds);
+    }
+}
+
+void hamming_batch_destroy(const struct dc_posix_env *env, struct hamming_batch *batch) {
+    if (batch->jobs != NULL) {
+        dc_free(env, batch->jobs, batch->capacity * sizeof(struct hamming_batch_job));
+    }
+
+    if (batch->text != NULL) {
+        dc_free(env, batch->text, batch->text_size);
+    }
+
+    batch->text = NULL;
+    batch->text_size = 0;
+    batch->jobs = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+}
+
+static int read_manifest(const struct dc_posix_env *env, struct dc_error *err, const char *path, struct hamming_batch *batch) {
+    size_t length = 0;
+    int fd;
+
+    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    for (;;) {
+        ssize_t nread;
+
+        // keep room for the terminating null
+        if (batch->text_size - length < MANIFEST_READ_SIZE + 1) {
+            char *text = dc_realloc(env, err, batch->text, batch->text_size + MANIFEST_READ_SIZE + 1);
+
+            if (text == NULL) {
+                dc_dc_close(env, err, fd);
+                return -1;
+            }
+
+            batch->text = text;
+            batch->text_size += MANIFEST_READ_SIZE + 1;
+        }
+
+        nread = hamming_read_fully(env, err, fd, batch->text + length, MANIFEST_READ_SIZE);
+
+        if (nread == -1) {
+            dc_dc_close(env, err, fd);
+            return -1;
+        }
+
+        length += (size_t) nread;
+
+        if (nread < MANIFEST_READ_SIZE) {
+            break;
+        }
+    }
+
+    batch->text[length] = '\0';
+    dc_dc_close(env, err, fd);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int parse_line(const struct dc_posix_env *env, struct dc_error *err, char *line, struct hamming_batch *batch) {
+    char *fields[MANIFEST_FIELDS];
+    size_t count = 0;
+    char *comment = strchr(line, '#');
+    struct hamming_batch_job *job;
+
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+
+    while (*line != '\0') {
+        while (isspace((unsigned char) *line)) {
+            *line++ = '\0';
+        }
+
+        if (*line == '\0') {
+            break;
+        }
+
+        if (count == MANIFEST_FIELDS) {
+            DC_ERROR_RAISE_USER(err, "manifest line has more than an input, an output and a parity", -1);
+            return -1;
+        }
+
+        fields[count++] = line;
+
+        while (*line != '\0' && !isspace((unsigned char) *line)) {
+            line++;
+        }
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (count == 1) {
+        DC_ERROR_RAISE_USER(err, "manifest line needs an input and an output", -1);
+        return -1;
+    }
+
+    if (batch->count == batch->capacity) {
+        size_t capacity = batch->capacity == 0 ? 16 : batch->capacity * 2;
+        struct hamming_batch_job *jobs = dc_realloc(env, err, batch->jobs, capacity * sizeof(struct hamming_batch_job));
+
+        if (jobs == NULL) {
+            return -1;
+        }
+
+        batch->jobs = jobs;
+        batch->capacity = capacity;
+    }
+
+    job = &batch->jobs[batch->count];
+    dc_memset(env, job, 0, sizeof(struct hamming_batch_job));
+    job->input = fields[0];
+    job->output = fields[1];
+    job->parity = -1;
+
+    if (count == MANIFEST_FIELDS) {
+        if (!dc_strcmp(env, fields[2], "odd")) {
+            job->parity = 1;
+        } else if (!dc_strcmp(env, fields[2], "even")) {
+            job->parity = 0;
+        } else {
+            DC_ERROR_RAISE_USER(err, "manifest parity must be 'even' or 'odd'", -1);
+            return -1;
+        }
+    }
+
+    batch->count++;
+
+    return 0;
+}
+
+static void run_job(const struct dc_posix_env *env, struct dc_error *err, size_t worker, size_t task, void *arg) {
+    struct batch_run *run = arg;
+    struct hamming_batch_job *job = &run->batch->jobs[task];
+    double start = hamming_clock_now();
+    int result;
+
+    if (run->config->mode == HAMMING_BATCH_ENCODE) {
+        result = encode_job(env, err, &run->arenas[worker], run->config, job);
+    } else {
+        result = decode_job(env, err, &run->arenas[worker], run->config, job);
+    }
+
+    job->seconds = hamming_clock_now() - start;
+    job->ok = result == 0 && dc_error_has_no_error(err);
+
+    if (!job->ok) {
+        snprintf(job->message, sizeof(job->message), "%s",
+                 err->message != NULL ? err->message : "unknown error");
+    }
+}
+
+static int encode_job(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_arena *arena,
+                      const struct hamming_batch_config *config,
+                      struct hamming_batch_job *job) {
+    struct hamming_encode_options options = config->encode;
+    struct hamming_encode_stats stats = {0};
+    int fd;
+    int result;
+
+    // the pool already keeps every processor busy, so each job runs on its worker alone
+    options.threads = 0;
+    options.defer_commit = options.durability == HAMMING_DURABILITY_BATCHED ||
+                           options.durability == HAMMING_DURABILITY_SYNCFS;
+
+    if (job->parity != -1) {
+        options.parity = job->parity;
+    }
+
+    fd = dc_open(env, err, job->input, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    result = hamming_encode(env, err, arena, fd, job->output, &options, &stats);
+    dc_dc_close(env, err, fd);
+    job->characters = stats.characters;
+    job->flush = stats.flush;
+
+    return result;
+}
+
+static int decode_job(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct hamming_arena *arena,
+                      const struct hamming_batch_config *config,
+                      struct hamming_batch_job *job) {
+    struct hamming_decode_options options = config->decode;
+    int fd;
+    int result;
+
+    options.threads = 0;
+
+    if (job->parity != -1) {
+        options.parity = job->parity;
+    }
+
+    fd = dc_open(env, err, job->output, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    result = hamming_decode(env, err, arena, job->input, fd, &options, &job->stats);
+    dc_dc_close(env, err, fd);
+    job->characters = job->stats.characters;
+
+    return result;
+}
+
+static void commit_jobs(const struct dc_posix_env *env, struct dc_error *err, struct hamming_batch *batch) {
+    dev_t *devices;
+    size_t count = 0;
+
+    devices = hamming_calloc(env, err, batch->count, sizeof(dev_t));
+
+    if (devices == NULL) {
+        return;
+    }
+
+    // one syncfs per file system makes every plane set on it durable
+    for (size_t i = 0; i < batch->count; i++) {
+        struct hamming_batch_job *job = &batch->jobs[i];
+        bool seen = false;
+
+        if (!job->ok) {
+            continue;
+        }
+
+        if (job_device(job, &devices[count]) == -1) {
+            snprintf(job->message, sizeof(job->message), "%s", strerror(errno));
+            job->ok = false;
+            continue;
+        }
+
+        for (size_t d = 0; d < count && !seen; d++) {
+            seen = devices[d] == devices[count];
+        }
+
+        if (seen) {
+            continue;
+        }
+
+        if (hamming_durability_commit(env, err, job->output, HAMMING_DURABILITY_SYNCFS, &batch->flush) == -1) {
+            // nothing on this file system is known to be durable
+            for (size_t j = i; j < batch->count; j++) {
+                dev_t device;
+
+                if (batch->jobs[j].ok && job_device(&batch->jobs[j], &device) == 0 && device == devices[count]) {
+                    snprintf(batch->jobs[j].message, sizeof(batch->jobs[j].message), "%s", err->message);
+                    batch->jobs[j].ok = false;
+                }
+            }
+
+            dc_error_reset(err);
+        }
+
+        count++;
+    }
+
+    dc_free(env, devices, batch->count * sizeof(dev_t));
+}
+
+static int job_device(const struct hamming_batch_job *job, dev_t *device) {
+    struct stat status;
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s.meta", job->output);
+
+    if (stat(path, &status) == -1) {
+        return -1;
+    }
+
+    *device = status.st_dev;
+
+    return 0;
+}
@@ -0,0 +1,471 @@
+#include "hamming_cache.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Bytes copied from an entry to the output at a time.
+ */
+#define COPY_SIZE ((size_t) 1024 * 1024)
+
+/**
+ * Files an entry is keyed on: the twelve planes and the sidecar.
+ */
+#define KEY_FILES (BITS_INC_HAMMING + 1)
+
+/**
+ * What identifies the contents of a file without reading it. A file that does not exist
+ * is all zeros, so a plane that appears or disappears also invalidates the entry.
+ */
+struct file_identity {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    uint64_t modified_sec;
+    uint64_t modified_nsec;
+};
+
+/**
+ * Starts every entry, followed by the prefix and the decoded output. Only 64-bit fields so
+ * there is no padding to compare; entries are only read on the machine that wrote them.
+ */
+struct entry_header {
+    char magic[8];          // HAMMING_CACHE_MAGIC, padded with zeros
+    uint64_t options;       // the parity, then binary and verify as bits 1 and 2
+    uint64_t prefix_length;
+    uint64_t length;        // bytes of decoded output
+    uint64_t characters;    // the decode stats to report on a hit
+    uint64_t corrected;
+    uint64_t uncorrectable;
+    uint64_t erased;
+    struct file_identity files[KEY_FILES];
+};
+
+/**
+ * An entry found while evicting.
+ */
+struct cache_entry {
+    char name[NAME_MAX + 1];
+    uint64_t used; // modification time in nanoseconds, refreshed on every hit
+    uint64_t size;
+};
+
+static int identify(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *prefix,
+                    struct file_identity files[KEY_FILES]);
+
+static int entry_path(const char *dir, const char *prefix, uint64_t options, char *path, size_t size);
+
+static bool read_entry(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       int fd,
+                       const struct entry_header *expected,
+                       const char *prefix,
+                       struct entry_header *header);
+
+static int decode_entry(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct hamming_arena *arena,
+                        const char *prefix,
+                        int out_fd,
+                        const struct hamming_decode_options *options,
+                        struct entry_header *header,
+                        const char *dir,
+                        const char *path,
+                        struct hamming_decode_stats *stats);
+
+static int copy_output(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       int fd,
+                       int out_fd,
+                       uint64_t length);
+
+static void add_stats(struct hamming_decode_stats *stats, const struct entry_header *header);
+
+static int compare_used(const void *a, const void *b);
+
+int hamming_cache_decode(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         const char *prefix,
+                         int out_fd,
+                         const struct hamming_decode_options *options,
+                         struct hamming_decode_stats *stats) {
+    struct hamming_decode_options uncached = *options;
+    struct entry_header expected;
+    struct entry_header header;
+    char path[PATH_MAX];
+    int fd;
+
+    DC_TRACE(env);
+    uncached.cache_dir = NULL;
+
+    if (options->repair) {
+        return hamming_decode(env, err, arena, prefix, out_fd, &uncached, stats);
+    }
+
+    memset(&expected, 0, sizeof(expected));
+    memcpy(expected.magic, HAMMING_CACHE_MAGIC, sizeof(HAMMING_CACHE_MAGIC) - 1);
+    expected.options = (uint64_t) options->parity | (uint64_t) options->binary << 1U | (uint64_t) options->verify << 2U;
+    expected.prefix_length = strlen(prefix);
+
+    if (entry_path(options->cache_dir, prefix, expected.options, path, sizeof(path)) == -1) {
+        DC_ERROR_RAISE_USER(err, "cache entry path is too long", -1);
+        return -1;
+    }
+
+    // one stat per file, and the entry if they all still match
+    if (identify(env, err, prefix, expected.files) == -1) {
+        return -1;
+    }
+
+    // a missing entry is only a miss, which dc_open would report as an error
+    fd = open(path, O_RDONLY);
+
+    if (fd != -1) {
+        if (read_entry(env, err, fd, &expected, prefix, &header)) {
+            int ret_val = copy_output(env, err, arena, fd, out_fd, header.length);
+
+            // the modification time orders the entries for eviction
+            futimens(fd, NULL);
+            dc_dc_close(env, err, fd);
+
+            if (ret_val == -1 || dc_error_has_error(err)) {
+                return -1;
+            }
+
+            add_stats(stats, &header);
+
+            return 0;
+        }
+
+        dc_dc_close(env, err, fd);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+    }
+
+    // a stale entry is replaced by the new one, decoded without the cache
+    if (decode_entry(env, err, arena, prefix, out_fd, &uncached, &expected, options->cache_dir, path, stats) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int hamming_cache_evict(const struct dc_posix_env *env, struct dc_error *err, const char *dir, size_t size) {
+    struct cache_entry *entries = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    uint64_t total = 0;
+    struct dirent *dirent;
+    DIR *stream;
+
+    DC_TRACE(env);
+    stream = opendir(dir);
+
+    if (stream == NULL) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    while ((dirent = readdir(stream)) != NULL) {
+        size_t name_length = strlen(dirent->d_name);
+        char path[PATH_MAX];
+        struct stat status;
+        int written;
+
+        if (name_length <= sizeof(HAMMING_CACHE_SUFFIX) - 1 ||
+            strcmp(dirent->d_name + name_length - (sizeof(HAMMING_CACHE_SUFFIX) - 1), HAMMING_CACHE_SUFFIX) != 0) {
+            continue;
+        }
+
+        written = snprintf(path, sizeof(path), "%s/%s", dir, dirent->d_name);
+
+        // another process may have evicted it already
+        if (written < 0 || (size_t) written >= sizeof(path) || stat(path, &status) == -1) {
+            continue;
+        }
+
+        if (count == capacity) {
+            size_t grown_capacity = capacity == 0 ? 64 : capacity * 2;
+            struct cache_entry *grown = dc_realloc(env, err, entries, grown_capacity * sizeof(struct cache_entry));
+
+            if (grown == NULL) {
+                if (entries != NULL) {
+                    dc_free(env, entries, capacity * sizeof(struct cache_entry));
+                }
+
+                closedir(stream);
+                return -1;
+            }
+
+            entries = grown;
+            capacity = grown_capacity;
+        }
+
+        memcpy(entries[count].name, dirent->d_name, name_length + 1);
+        entries[count].used =
+                (uint64_t) status.st_mtim.tv_sec * UINT64_C(1000000000) + (uint64_t) status.st_mtim.tv_nsec;
+        entries[count].size = (uint64_t) status.st_size;
+        total += entries[count].size;
+        count++;
+    }
+
+    closedir(stream);
+
+    if (total > size) {
+        qsort(entries, count, sizeof(struct cache_entry), compare_used);
+
+        for (size_t i = 0; i < count && total > size; i++) {
+            char path[PATH_MAX];
+
+            snprintf(path, sizeof(path), "%s/%s", dir, entries[i].name);
+            unlink(path);
+            total -= entries[i].size;
+        }
+    }
+
+    if (entries != NULL) {
+        dc_free(env, entries, capacity * sizeof(struct cache_entry));
+    }
+
+    return 0;
+}
+
+static int identify(const struct dc_posix_env *env,
+                    struct dc_error *err,
+                    const char *prefix,
+                    struct file_identity files[KEY_FILES]) {
+    char path[PATH_MAX];
+    char *meta_path;
+    size_t meta_path_size;
+
+    meta_path = hamming_meta_path(env, err, prefix, &meta_path_size);
+
+    if (meta_path == NULL) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < KEY_FILES; index++) {
+        struct stat status;
+        bool found;
+
+        // the sidecar follows the planes
+        if (index < BITS_INC_HAMMING) {
+            found = hamming_plane_path(prefix, index, path, sizeof(path)) == 0 && stat(path, &status) == 0;
+        } else {
+            found = stat(meta_path, &status) == 0;
+        }
+
+        memset(&files[index], 0, sizeof(files[index]));
+
+        if (found) {
+            files[index].device = (uint64_t) status.st_dev;
+            files[index].inode = (uint64_t) status.st_ino;
+            files[index].size = (uint64_t) status.st_size;
+            files[index].modified_sec = (uint64_t) status.st_mtim.tv_sec;
+            files[index].modified_nsec = (uint64_t) status.st_mtim.tv_nsec;
+        }
+    }
+
+    dc_free(env, meta_path, meta_path_size);
+
+    return 0;
+}
+
+static int entry_path(const char *dir, const char *prefix, uint64_t options, char *path, size_t size) {
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    int written;
+
+    // FNV-1a of the prefix and the options, the identities are checked inside the entry
+    for (const char *c = prefix; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t) *c) * UINT64_C(0x100000001b3);
+    }
+
+    hash = (hash ^ options) * UINT64_C(0x100000001b3);
+    written = snprintf(path, size, "%s/%016jx%s", dir, (uintmax_t) hash, HAMMING_CACHE_SUFFIX);
+
+    return written < 0 || (size_t) written >= size ? -1 : 0;
+}
+
+static bool read_entry(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       int fd,
+                       const struct entry_header *expected,
+                       const char *prefix,
+                       struct entry_header *header) {
+    char stored[PATH_MAX];
+    struct stat status;
+
+    if (hamming_read_fully(env, err, fd, header, sizeof(*header)) != (ssize_t) sizeof(*header) ||
+        header->prefix_length != expected->prefix_length || header->prefix_length >= sizeof(stored) ||
+        memcmp(header->magic, expected->magic, sizeof(header->magic)) != 0 || header->options != expected->options ||
+        memcmp(header->files, expected->files, sizeof(header->files)) != 0) {
+        return false;
+    }
+
+    // the hash of two prefixes can collide, and an entry cut short is never copied out
+    if (hamming_read_fully(env, err, fd, stored, header->prefix_length) != (ssize_t) header->prefix_length ||
+        memcmp(stored, prefix, header->prefix_length) != 0 || fstat(fd, &status) == -1 ||
+        (uint64_t) status.st_size != sizeof(*header) + header->prefix_length + header->length) {
+        return false;
+    }
+
+    return dc_error_has_no_error(err);
+}
+
+static int decode_entry(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct hamming_arena *arena,
+                        const char *prefix,
+                        int out_fd,
+                        const struct hamming_decode_options *options,
+                        struct entry_header *header,
+                        const char *dir,
+                        const char *path,
+                        struct hamming_decode_stats *stats) {
+    struct file_identity decoded[KEY_FILES];
+    struct hamming_decode_stats entry_stats = {0};
+    char temp_path[PATH_MAX];
+    off_t end;
+    int fd;
+    int ret_val;
+
+    if (mkdir(dir, S_IRWXU) == -1 && errno != EEXIST) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    // the entry only gets its name once it is complete, so a reader never sees half of one
+    if (snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path) >= (int) sizeof(temp_path)) {
+        DC_ERROR_RAISE_USER(err, "cache entry path is too long", -1);
+        return -1;
+    }
+
+    fd = mkstemp(temp_path);
+
+    if (fd == -1) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    ret_val = hamming_write_fully(env, err, fd, header, sizeof(*header));
+
+    if (ret_val == 0) {
+        ret_val = hamming_write_fully(env, err, fd, prefix, header->prefix_length);
+    }
+
+    if (ret_val == 0) {
+        ret_val = hamming_decode(env, err, arena, prefix, fd, options, &entry_stats);
+    }
+
+    end = ret_val == 0 ? dc_lseek(env, err, fd, 0, SEEK_CUR) : -1;
+
+    if (end == -1 || dc_error_has_error(err)) {
+        dc_dc_close(env, err, fd);
+        unlink(temp_path);
+        return -1;
+    }
+
+    header->length = (uint64_t) end - sizeof(*header) - header->prefix_length;
+    header->characters = entry_stats.characters;
+    header->corrected = entry_stats.corrected;
+    header->uncorrectable = entry_stats.uncorrectable;
+    header->erased = entry_stats.erased;
+    dc_lseek(env, err, fd, 0, SEEK_SET);
+    hamming_write_fully(env, err, fd, header, sizeof(*header));
+    dc_lseek(env, err, fd, (off_t) (sizeof(*header) + header->prefix_length), SEEK_SET);
+    ret_val = dc_error_has_error(err) ? -1 : copy_output(env, err, arena, fd, out_fd, header->length);
+    dc_dc_close(env, err, fd);
+
+    if (ret_val == -1 || dc_error_has_error(err)) {
+        unlink(temp_path);
+        return -1;
+    }
+
+    add_stats(stats, header);
+
+    // a plane that changed while it was read would make an entry for neither version
+    if (identify(env, err, prefix, decoded) == -1) {
+        unlink(temp_path);
+        return -1;
+    }
+
+    if (memcmp(decoded, header->files, sizeof(decoded)) != 0 || (uint64_t) end > options->cache_size) {
+        unlink(temp_path);
+        return 0;
+    }
+
+    if (rename(temp_path, path) == -1) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        unlink(temp_path);
+        return -1;
+    }
+
+    return hamming_cache_evict(env, err, dir, options->cache_size);
+}
+
+static int copy_output(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       int fd,
+                       int out_fd,
+                       uint64_t length) {
+    uint8_t *buf;
+
+    if (hamming_arena_reserve(env, err, arena, COPY_SIZE, 0) == -1) {
+        return -1;
+    }
+
+    buf = hamming_arena_alloc(arena, COPY_SIZE);
+
+    while (length > 0) {
+        size_t size = length < COPY_SIZE ? (size_t) length : COPY_SIZE;
+        ssize_t nread = hamming_read_fully(env, err, fd, buf, size);
+
+        if (nread == -1) {
+            return -1;
+        }
+
+        if ((size_t) nread != size) {
+            DC_ERROR_RAISE_USER(err, "cache entry is shorter than its header says", -1);
+            return -1;
+        }
+
+        if (hamming_write_fully(env, err, out_fd, buf, size) == -1) {
+            return -1;
+        }
+
+        length -= size;
+    }
+
+    return 0;
+}
+
+static void add_stats(struct hamming_decode_stats *stats, const struct entry_header *header) {
+    stats->characters += header->characters;
+    stats->corrected += header->corrected;
+    stats->uncorrectable += header->uncorrectable;
+    stats->erased |= (unsigned int) header->erased;
+}
+
+static int compare_used(const void *a, const void *b) {
+    uint64_t x = ((const struct cache_entry *) a)->used;
+    uint64_t y = ((const struct cache_entry *) b)->used;
+
+    return (x > y) - (x < y);
+}
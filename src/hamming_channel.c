@@ -0,0 +1,262 @@
+#include "hamming_channel.h"
+#include "hamming_io.h"
+#include "hamming_syscalls.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t rotate_left(uint64_t value, unsigned int shift);
+
+static uint64_t split_mix(uint64_t *state);
+
+static void next_gap(struct hamming_channel *channel);
+
+static int damage_plane(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *path,
+                        struct hamming_channel *channel,
+                        uint8_t *buf);
+
+int hamming_channel_parse(const struct dc_posix_env *env, const char *str, enum hamming_channel_mode *mode) {
+    if (str == NULL) {
+        return -1;
+    }
+
+    if (!dc_strcmp(env, str, "uniform")) {
+        *mode = HAMMING_CHANNEL_UNIFORM;
+    } else if (!dc_strcmp(env, str, "burst")) {
+        *mode = HAMMING_CHANNEL_BURST;
+    } else if (!dc_strcmp(env, str, "plane")) {
+        *mode = HAMMING_CHANNEL_PLANE;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+void hamming_channel_init(struct hamming_channel *channel,
+                          enum hamming_channel_mode mode,
+                          double rate,
+                          size_t burst_length,
+                          uint64_t seed) {
+    channel->mode = mode;
+    channel->rate = rate;
+    channel->burst_length = burst_length > 0 ? burst_length : HAMMING_CHANNEL_DEFAULT_BURST;
+    channel->burst_left = 0;
+    channel->flipped = 0;
+
+    // xoshiro256** must not start from all zeros, splitmix64 spreads any seed over the state
+    for (size_t i = 0; i < 4; i++) {
+        channel->rng[i] = split_mix(&seed);
+    }
+
+    next_gap(channel);
+}
+
+uint64_t hamming_channel_random(struct hamming_channel *channel) {
+    uint64_t *s = channel->rng;
+    uint64_t result = rotate_left(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotate_left(s[3], 45);
+
+    return result;
+}
+
+void hamming_channel_apply(struct hamming_channel *channel, uint8_t *buf, size_t size) {
+    uint64_t bits = (uint64_t) size * BITS_PER_BYTE;
+    uint64_t pos = 0;
+
+    if (channel->mode == HAMMING_CHANNEL_PLANE) {
+        return;
+    }
+
+    while (pos < bits) {
+        // a burst can run on from the previous buffer
+        if (channel->burst_left > 0) {
+            buf[pos / BITS_PER_BYTE] ^= (uint8_t) (0x80U >> (pos % BITS_PER_BYTE));
+            channel->flipped++;
+            channel->burst_left--;
+            pos++;
+
+            if (channel->burst_left == 0) {
+                next_gap(channel);
+            }
+
+            continue;
+        }
+
+        if (channel->gap >= bits - pos) {
+            if (channel->gap != UINT64_MAX) {
+                channel->gap -= bits - pos;
+            }
+
+            break;
+        }
+
+        pos += channel->gap;
+
+        if (channel->mode == HAMMING_CHANNEL_BURST) {
+            channel->burst_left = channel->burst_length;
+        } else {
+            buf[pos / BITS_PER_BYTE] ^= (uint8_t) (0x80U >> (pos % BITS_PER_BYTE));
+            channel->flipped++;
+            pos++;
+            next_gap(channel);
+        }
+    }
+}
+
+size_t hamming_channel_lose_plane(struct hamming_channel *channel, unsigned int planes) {
+    size_t candidates = 0;
+    size_t pick;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (planes & HAMMING_PLANE_BIT(index)) {
+            candidates++;
+        }
+    }
+
+    pick = (size_t) (hamming_channel_random(channel) % candidates);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if ((planes & HAMMING_PLANE_BIT(index)) && pick-- == 0) {
+            return index;
+        }
+    }
+
+    return BITS_INC_HAMMING;
+}
+
+int hamming_channel_planes(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *prefix,
+                           struct hamming_channel *channel,
+                           size_t *lost) {
+    char path[PATH_MAX];
+    unsigned int planes = 0;
+    uint8_t *buf;
+    int ret_val = 0;
+
+    DC_TRACE(env);
+    *lost = BITS_INC_HAMMING;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        struct stat status;
+
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == -1) {
+            DC_ERROR_RAISE_USER(err, "plane file path is too long", -1);
+            return -1;
+        }
+
+        // constant planes have no file to damage
+        if (stat(path, &status) == 0) {
+            planes |= HAMMING_PLANE_BIT(index);
+        }
+    }
+
+    if (planes == 0) {
+        DC_ERROR_RAISE_USER(err, "no plane file found for the prefix", -1);
+        return -1;
+    }
+
+    if (channel->mode == HAMMING_CHANNEL_PLANE) {
+        *lost = hamming_channel_lose_plane(channel, planes);
+        hamming_plane_path(prefix, *lost, path, sizeof(path));
+        unlink(path);
+
+        return 0;
+    }
+
+    buf = hamming_malloc(env, err, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    if (buf == NULL) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING && ret_val == 0; index++) {
+        if (planes & HAMMING_PLANE_BIT(index)) {
+            hamming_plane_path(prefix, index, path, sizeof(path));
+            ret_val = damage_plane(env, err, path, channel, buf);
+        }
+    }
+
+    dc_free(env, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    return ret_val;
+}
+
+static uint64_t rotate_left(uint64_t value, unsigned int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static uint64_t split_mix(uint64_t *state) {
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+
+    return z ^ (z >> 31);
+}
+
+static void next_gap(struct hamming_channel *channel) {
+    // a burst flips burst_length bits, so bursts start that much less often than single errors
+    double rate = channel->mode == HAMMING_CHANNEL_BURST ? channel->rate / (double) channel->burst_length
+                                                         : channel->rate;
+    double uniform;
+    double gap;
+
+    if (channel->mode == HAMMING_CHANNEL_PLANE || rate <= 0.0) {
+        channel->gap = UINT64_MAX;
+        return;
+    }
+
+    if (rate >= 1.0) {
+        channel->gap = 0;
+        return;
+    }
+
+    // the top 53 bits give a uniform number in (0, 1], which the log turns into a geometric gap
+    uniform = (double) ((hamming_channel_random(channel) >> 11) + 1) * 0x1.0p-53;
+    gap = floor(log(uniform) / log1p(-rate));
+    channel->gap = gap >= 0x1.0p64 ? UINT64_MAX : (uint64_t) gap;
+}
+
+static int damage_plane(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *path,
+                        struct hamming_channel *channel,
+                        uint8_t *buf) {
+    int fd = dc_open(env, err, path, DC_O_RDWR, 0);
+    ssize_t nread;
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    while ((nread = hamming_read_fully(env, err, fd, buf, HAMMING_DEFAULT_CHUNK_SIZE)) > 0) {
+        hamming_channel_apply(channel, buf, (size_t) nread);
+
+        // write the damaged bytes back over the ones just read
+        dc_lseek(env, err, fd, -(off_t) nread, SEEK_CUR);
+
+        if (dc_error_has_error(err) || hamming_write_fully(env, err, fd, buf, (size_t) nread) == -1) {
+            break;
+        }
+    }
+
+    dc_dc_close(env, err, fd);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
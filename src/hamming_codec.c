@@ -0,0 +1,765 @@
+#include "hamming_codec.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define HAMMING_STREAMING_STORES
+#endif
+
+/**
+ * Characters encoded into one 64-bit word of every plane.
+ */
+#define CHARS_PER_WORD (BITS_PER_BYTE * sizeof(uint64_t))
+
+/**
+ * Bytes the cache reads and writes at a time, which the planes are aligned to.
+ */
+#define CACHE_LINE_SIZE ((size_t) 64)
+
+#define WORDS_PER_LINE (CACHE_LINE_SIZE / sizeof(uint64_t))
+
+#define CHARS_PER_LINE (WORDS_PER_LINE * CHARS_PER_WORD)
+
+/**
+ * The enum hamming_store_kernel hamming_encode_chunk uses.
+ */
+static atomic_int store_kernel = HAMMING_STORES_AUTO;
+
+/**
+ * For every plane, the other planes of the first parity check it belongs to. Planes 8 to 11
+ * are p1, p2, p4 and p8, checking data bits {0,1,3,4,6}, {0,2,3,5,6}, {1,2,3,7} and {4,5,6,7}.
+ */
+static const unsigned int rebuild_sources[BITS_INC_HAMMING] = {
+        0x15AU, // d0 from p1 d1 d3 d4 d6
+        0x159U, // d1 from p1 d0 d3 d4 d6
+        0x269U, // d2 from p2 d0 d3 d5 d6
+        0x153U, // d3 from p1 d0 d1 d4 d6
+        0x14BU, // d4 from p1 d0 d1 d3 d6
+        0x24DU, // d5 from p2 d0 d2 d3 d6
+        0x11BU, // d6 from p1 d0 d1 d3 d4
+        0x40EU, // d7 from p4 d1 d2 d3
+        0x05BU, // p1 from d0 d1 d3 d4 d6
+        0x06DU, // p2 from d0 d2 d3 d5 d6
+        0x08EU, // p4 from d1 d2 d3 d7
+        0x0F0U  // p8 from d4 d5 d6 d7
+};
+
+static size_t plane_size(size_t chunk_size);
+
+static uint64_t transpose_bytes(uint64_t matrix);
+
+static void transpose_word(const uint8_t chars[], uint64_t d[]);
+
+static uint64_t load_word(const uint8_t plane[], size_t word);
+
+static void store_word(uint8_t plane[], size_t word, uint64_t value);
+
+static void stream_word(uint8_t plane[], size_t word, uint64_t value);
+
+static uint64_t valid_bits(size_t word, size_t count);
+
+size_t hamming_chunk_size(size_t chunk_size) {
+    if (chunk_size == 0) {
+        return HAMMING_DEFAULT_CHUNK_SIZE;
+    }
+
+    return ((chunk_size + BITS_PER_BYTE - 1) / BITS_PER_BYTE) * BITS_PER_BYTE;
+}
+
+size_t hamming_buffers_arena_size(size_t chunk_size) {
+    return hamming_arena_align(chunk_size + 1) +
+           BITS_INC_HAMMING * hamming_arena_align(chunk_size) +
+           BITS_INC_HAMMING * plane_size(chunk_size) + HAMMING_PLANE_ALIGNMENT;
+}
+
+int hamming_buffers_init(struct hamming_arena *arena, struct hamming_buffers *buffers, size_t chunk_size) {
+    buffers->chunk_size = chunk_size;
+    buffers->chars = hamming_arena_alloc(arena, chunk_size + 1);
+
+    if (buffers->chars == NULL) {
+        return -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        buffers->bits[index] = hamming_arena_alloc(arena, chunk_size);
+
+        if (buffers->bits[index] == NULL) {
+            return -1;
+        }
+    }
+
+    // the planes are whole blocks back to back, so only the first one needs padding to align it
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        buffers->planes[index] = hamming_arena_alloc_aligned(arena, plane_size(chunk_size), HAMMING_PLANE_ALIGNMENT);
+
+        if (buffers->planes[index] == NULL) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static uint64_t transpose_bytes(uint64_t matrix) {
+    // swaps ever larger blocks across the diagonal of the 8x8 bit matrix, one row per byte
+    matrix = (matrix & UINT64_C(0xAA55AA55AA55AA55)) | ((matrix & UINT64_C(0x00AA00AA00AA00AA)) << 7) |
+             ((matrix >> 7) & UINT64_C(0x00AA00AA00AA00AA));
+    matrix = (matrix & UINT64_C(0xCCCC3333CCCC3333)) | ((matrix & UINT64_C(0x0000CCCC0000CCCC)) << 14) |
+             ((matrix >> 14) & UINT64_C(0x0000CCCC0000CCCC));
+    matrix = (matrix & UINT64_C(0xF0F0F0F00F0F0F0F)) | ((matrix & UINT64_C(0x00000000F0F0F0F0)) << 28) |
+             ((matrix >> 28) & UINT64_C(0x00000000F0F0F0F0));
+
+    return matrix;
+}
+
+static void transpose_word(const uint8_t chars[], uint64_t d[]) {
+    uint8_t bytes[BITS_PER_BYTE][sizeof(uint64_t)];
+
+    // eight transposes fill one word of every data plane, a byte at a time
+    for (size_t pos = 0; pos < sizeof(uint64_t); pos++) {
+        const uint8_t *group = chars + BITS_PER_BYTE * pos;
+        uint64_t matrix = 0;
+
+        for (size_t j = 0; j < BITS_PER_BYTE; j++) {
+            matrix |= (uint64_t) group[j] << (56 - BITS_PER_BYTE * j);
+        }
+
+        matrix = transpose_bytes(matrix);
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            bytes[index][pos] = (uint8_t) (matrix >> (56 - BITS_PER_BYTE * index));
+        }
+    }
+
+    for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+        d[index] = load_word(bytes[index], 0);
+    }
+}
+
+static uint64_t load_word(const uint8_t plane[], size_t word) {
+    uint64_t value;
+
+    memcpy(&value, plane + word * sizeof(uint64_t), sizeof(value));
+
+    return value;
+}
+
+static void store_word(uint8_t plane[], size_t word, uint64_t value) {
+    memcpy(plane + word * sizeof(uint64_t), &value, sizeof(value));
+}
+
+static void stream_word(uint8_t plane[], size_t word, uint64_t value) {
+#ifdef HAMMING_STREAMING_STORES
+    _mm_stream_si64((void *) (plane + word * sizeof(uint64_t)), (int64_t) value);
+#else
+    store_word(plane, word, value);
+#endif
+}
+
+static uint64_t valid_bits(size_t word, size_t count) {
+    uint8_t bytes[sizeof(uint64_t)];
+    size_t full = count / BITS_PER_BYTE;
+    uint64_t value;
+
+    if ((word + 1) * sizeof(uint64_t) <= full) {
+        return UINT64_MAX;
+    }
+
+    // only the characters of the chunk count, not the padding of the last byte or word
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        size_t pos = word * sizeof(uint64_t) + i;
+
+        if (pos < full) {
+            bytes[i] = 0xFF;
+        } else if (pos == full) {
+            bytes[i] = (uint8_t) ((1U << (count % BITS_PER_BYTE)) - 1U);
+        } else {
+            bytes[i] = 0;
+        }
+    }
+
+    memcpy(&value, bytes, sizeof(value));
+
+    return value;
+}
+
+static size_t plane_size(size_t chunk_size) {
+    return ((chunk_size / BITS_PER_BYTE + HAMMING_PLANE_ALIGNMENT - 1) / HAMMING_PLANE_ALIGNMENT) *
+           HAMMING_PLANE_ALIGNMENT;
+}
+
+void hamming_encode_chunk(struct hamming_buffers *buffers, size_t count, int parity) {
+    enum hamming_store_kernel kernel = (enum hamming_store_kernel) atomic_load_explicit(&store_kernel,
+                                                                                        memory_order_relaxed);
+
+    // planes larger than the cache would only be written back to memory after evicting the input
+    if (kernel == HAMMING_STORES_STREAMING ||
+        (kernel == HAMMING_STORES_AUTO && count + count / BITS_PER_BYTE * BITS_INC_HAMMING > hamming_llc_size())) {
+        hamming_encode_chunk_streaming(buffers, count, parity);
+        return;
+    }
+
+    hamming_transpose_chars(buffers->chars, count, buffers->planes);
+    hamming_parity_planes(buffers->planes, count, parity);
+}
+
+void hamming_encode_chunk_streaming(struct hamming_buffers *buffers, size_t count, int parity) {
+    size_t nlines = count / CHARS_PER_LINE;
+    size_t done = nlines * CHARS_PER_LINE;
+    uint64_t initial = parity ? UINT64_MAX : 0;
+    uint8_t *tail[BITS_INC_HAMMING];
+
+    for (size_t line = 0; line < nlines; line++) {
+        uint64_t words[BITS_INC_HAMMING][WORDS_PER_LINE];
+
+        for (size_t word = 0; word < WORDS_PER_LINE; word++) {
+            uint64_t d[BITS_PER_BYTE];
+
+            transpose_word(buffers->chars + line * CHARS_PER_LINE + word * CHARS_PER_WORD, d);
+
+            for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+                words[index][word] = d[index];
+            }
+
+            words[8][word] = initial ^ d[0] ^ d[1] ^ d[3] ^ d[4] ^ d[6];
+            words[9][word] = initial ^ d[0] ^ d[2] ^ d[3] ^ d[5] ^ d[6];
+            words[10][word] = initial ^ d[1] ^ d[2] ^ d[3] ^ d[7];
+            words[11][word] = initial ^ d[4] ^ d[5] ^ d[6] ^ d[7];
+        }
+
+        // a whole line of one plane at a time, so each line is written to memory in one go
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            for (size_t word = 0; word < WORDS_PER_LINE; word++) {
+                stream_word(buffers->planes[index], line * WORDS_PER_LINE + word, words[index][word]);
+            }
+        }
+    }
+
+#ifdef HAMMING_STREAMING_STORES
+    // non-temporal stores are weakly ordered, the thread writing the planes out must see them
+    _mm_sfence();
+#endif
+
+    if (done == count) {
+        return;
+    }
+
+    // the last partial line goes through the cache like any small chunk
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        tail[index] = buffers->planes[index] + nlines * CACHE_LINE_SIZE;
+    }
+
+    hamming_transpose_chars(buffers->chars + done, count - done, tail);
+    hamming_parity_planes(tail, count - done, parity);
+}
+
+size_t hamming_llc_size(void) {
+    static atomic_size_t llc_size;
+    size_t size = atomic_load_explicit(&llc_size, memory_order_relaxed);
+    long reported = -1;
+
+    if (size != 0) {
+        return size;
+    }
+
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    reported = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    // without a third level the second one is the last
+    if (reported <= 0) {
+        reported = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+#endif
+
+    size = reported > 0 ? (size_t) reported : HAMMING_DEFAULT_LLC_SIZE;
+    atomic_store_explicit(&llc_size, size, memory_order_relaxed);
+
+    return size;
+}
+
+void hamming_set_store_kernel(enum hamming_store_kernel kernel) {
+    atomic_store_explicit(&store_kernel, (int) kernel, memory_order_relaxed);
+}
+
+void hamming_encode_chunk_reference(struct hamming_buffers *buffers, size_t count, int parity) {
+    uint8_t array_of_bits[BITS_PER_BYTE];
+    uint8_t array_hamming[NUMBER_HAMMING_BITS];
+
+    for (size_t i = 0; i < count; i++) {
+        generate_array_of_bits_from_character(array_of_bits, BITS_PER_BYTE, buffers->chars[i]);
+        generate_array_of_hamming_bits(array_hamming, array_of_bits, parity);
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            buffers->bits[index][i] = array_of_bits[index];
+        }
+
+        for (size_t index = 0; index < NUMBER_HAMMING_BITS; index++) {
+            buffers->bits[BITS_PER_BYTE + index][i] = array_hamming[index];
+        }
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        pack_plane(buffers->bits[index], count, buffers->planes[index]);
+    }
+}
+
+void hamming_decode_chunk(struct hamming_buffers *buffers,
+                          size_t count,
+                          int parity,
+                          struct hamming_decode_stats *stats) {
+    hamming_correct_planes(buffers->planes, count, parity, stats);
+    hamming_transpose_planes((const uint8_t *const *) buffers->planes, count, buffers->chars);
+    stats->characters += count;
+}
+
+void hamming_decode_chunk_reference(struct hamming_buffers *buffers,
+                                    size_t count,
+                                    int parity,
+                                    struct hamming_decode_stats *stats) {
+    uint8_t array_bits[BITS_PER_BYTE] = {0};
+    uint8_t hamming_bits[NUMBER_HAMMING_BITS] = {0};
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            insertItemToArray(i, index, nbytes, count, buffers->planes[index], array_bits, hamming_bits);
+        }
+
+        switch (handleErrorDetection(parity, array_bits, hamming_bits, &buffers->chars[i])) {
+            case HAMMING_CLEAN:
+                break;
+            case HAMMING_CORRECTED:
+                stats->corrected++;
+                break;
+            case HAMMING_UNCORRECTABLE:
+                stats->uncorrectable++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    stats->characters += count;
+}
+
+void hamming_extract_chunk(struct hamming_buffers *buffers, size_t count, struct hamming_decode_stats *stats) {
+    hamming_transpose_planes((const uint8_t *const *) buffers->planes, count, buffers->chars);
+    stats->characters += count;
+}
+
+void hamming_transpose_chars(const uint8_t chars[], size_t count, uint8_t *const planes[]) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    for (size_t pos = 0; pos < nbytes; pos++) {
+        const uint8_t *group = chars + BITS_PER_BYTE * pos;
+        // a partial last byte holds its characters in the low bits
+        size_t in_byte = count - BITS_PER_BYTE * pos < BITS_PER_BYTE ? count - BITS_PER_BYTE * pos : BITS_PER_BYTE;
+        unsigned int shift = (unsigned int) (BITS_PER_BYTE - in_byte);
+        uint64_t matrix = 0;
+
+        // one character per row, the first one in the high byte
+        for (size_t j = 0; j < in_byte; j++) {
+            matrix |= (uint64_t) group[j] << (56 - BITS_PER_BYTE * j);
+        }
+
+        matrix = transpose_bytes(matrix);
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            planes[index][pos] = (uint8_t) ((uint8_t) (matrix >> (56 - BITS_PER_BYTE * index)) >> shift);
+        }
+    }
+}
+
+void hamming_transpose_planes(const uint8_t *const planes[], size_t count, uint8_t chars[]) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    for (size_t pos = 0; pos < nbytes; pos++) {
+        uint8_t *group = chars + BITS_PER_BYTE * pos;
+        size_t in_byte = count - BITS_PER_BYTE * pos < BITS_PER_BYTE ? count - BITS_PER_BYTE * pos : BITS_PER_BYTE;
+        unsigned int shift = (unsigned int) (BITS_PER_BYTE - in_byte);
+        uint64_t matrix = 0;
+
+        // one plane per row, the characters of a partial byte moved up to the high bits
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            matrix |= (uint64_t) (uint8_t) (planes[index][pos] << shift) << (56 - BITS_PER_BYTE * index);
+        }
+
+        matrix = transpose_bytes(matrix);
+
+        for (size_t j = 0; j < in_byte; j++) {
+            group[j] = (uint8_t) (matrix >> (56 - BITS_PER_BYTE * j));
+        }
+    }
+}
+
+void hamming_parity_planes(uint8_t *const planes[], size_t count, int parity) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    size_t nwords = (nbytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    uint64_t initial = parity ? UINT64_MAX : 0;
+
+    // the plane buffers are whole blocks, so the last word never runs past them
+    for (size_t word = 0; word < nwords; word++) {
+        uint64_t d[BITS_PER_BYTE];
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            d[index] = load_word(planes[index], word);
+        }
+
+        store_word(planes[8], word, initial ^ d[0] ^ d[1] ^ d[3] ^ d[4] ^ d[6]);
+        store_word(planes[9], word, initial ^ d[0] ^ d[2] ^ d[3] ^ d[5] ^ d[6]);
+        store_word(planes[10], word, initial ^ d[1] ^ d[2] ^ d[3] ^ d[7]);
+        store_word(planes[11], word, initial ^ d[4] ^ d[5] ^ d[6] ^ d[7]);
+    }
+
+    // the unused high bits of a partial last byte are always 0
+    if (parity && count % BITS_PER_BYTE != 0) {
+        for (size_t index = BITS_PER_BYTE; index < BITS_INC_HAMMING; index++) {
+            planes[index][nbytes - 1] &= (uint8_t) ((1U << (count % BITS_PER_BYTE)) - 1U);
+        }
+    }
+}
+
+void hamming_correct_planes(uint8_t *const planes[], size_t count, int parity, struct hamming_decode_stats *stats) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    size_t nwords = (nbytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    uint64_t initial = parity ? UINT64_MAX : 0;
+
+    for (size_t word = 0; word < nwords; word++) {
+        uint64_t valid = valid_bits(word, count);
+        uint64_t d[BITS_PER_BYTE];
+        uint64_t s1;
+        uint64_t s2;
+        uint64_t s4;
+        uint64_t s8;
+        uint64_t pairs;
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            d[index] = load_word(planes[index], word);
+        }
+
+        // a syndrome bit is set where a check fails
+        s1 = valid & (initial ^ load_word(planes[8], word) ^ d[0] ^ d[1] ^ d[3] ^ d[4] ^ d[6]);
+        s2 = valid & (initial ^ load_word(planes[9], word) ^ d[0] ^ d[2] ^ d[3] ^ d[5] ^ d[6]);
+        s4 = valid & (initial ^ load_word(planes[10], word) ^ d[1] ^ d[2] ^ d[3] ^ d[7]);
+        s8 = valid & (initial ^ load_word(planes[11], word) ^ d[4] ^ d[5] ^ d[6] ^ d[7]);
+
+        if ((s1 | s2 | s4 | s8) == 0) {
+            continue;
+        }
+
+        // the data bit checked by exactly the two failing checks, as handleErrorDetection pairs them
+        d[0] ^= s1 & s2 & ~s4 & ~s8;
+        d[1] ^= s1 & ~s2 & s4 & ~s8;
+        d[4] ^= s1 & ~s2 & ~s4 & s8;
+        d[2] ^= ~s1 & s2 & s4 & ~s8;
+        d[5] ^= ~s1 & s2 & ~s4 & s8;
+        d[7] ^= ~s1 & ~s2 & s4 & s8;
+
+        pairs = (s1 & s2 & ~s4 & ~s8) | (s1 & ~s2 & s4 & ~s8) | (s1 & ~s2 & ~s4 & s8) | (~s1 & s2 & s4 & ~s8) |
+                (~s1 & s2 & ~s4 & s8) | (~s1 & ~s2 & s4 & s8);
+        stats->corrected += (uint64_t) __builtin_popcountll(pairs);
+        stats->uncorrectable += (uint64_t) __builtin_popcountll((s1 | s2 | s4 | s8) & ~pairs);
+
+        for (size_t index = 0; index < BITS_PER_BYTE; index++) {
+            store_word(planes[index], word, d[index]);
+        }
+    }
+}
+
+void hamming_rebuild_plane(struct hamming_buffers *buffers, size_t count, int parity, size_t erased) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    size_t nwords = (nbytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    uint64_t initial = parity ? UINT64_MAX : 0;
+    unsigned int sources = rebuild_sources[erased];
+
+    // the plane buffers are whole blocks, so the last word never runs past them
+    for (size_t word = 0; word < nwords; word++) {
+        uint64_t value = initial;
+
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            if (sources & (1U << index)) {
+                uint64_t source;
+
+                memcpy(&source, buffers->planes[index] + word * sizeof(uint64_t), sizeof(source));
+                value ^= source;
+            }
+        }
+
+        memcpy(buffers->planes[erased] + word * sizeof(uint64_t), &value, sizeof(value));
+    }
+
+    // the unused high bits of a partial last byte are always 0
+    if (count % BITS_PER_BYTE != 0) {
+        buffers->planes[erased][nbytes - 1] &= (uint8_t) ((1U << (count % BITS_PER_BYTE)) - 1U);
+    }
+}
+
+int hamming_plane_constant(const uint8_t plane[], size_t count) {
+    size_t full = count / BITS_PER_BYTE;
+    size_t rest = count % BITS_PER_BYTE;
+    // only the low bits of a partial last byte hold characters
+    uint8_t rest_mask = (uint8_t) ((1U << rest) - 1U);
+    uint8_t first;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (full == 0) {
+        first = (plane[0] & rest_mask) == rest_mask ? 0xFF : 0x00;
+    } else {
+        first = plane[0];
+    }
+
+    if (first != 0x00 && first != 0xFF) {
+        return -1;
+    }
+
+    for (size_t pos = 1; pos < full; pos++) {
+        if (plane[pos] != first) {
+            return -1;
+        }
+    }
+
+    if (rest != 0 && (plane[full] ^ first) & rest_mask) {
+        return -1;
+    }
+
+    return first == 0xFF;
+}
+
+void hamming_fill_plane(uint8_t plane[], size_t count, int value) {
+    size_t nbytes = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    memset(plane, value ? 0xFF : 0x00, nbytes);
+
+    if (value && count % BITS_PER_BYTE != 0) {
+        plane[nbytes - 1] = (uint8_t) ((1U << (count % BITS_PER_BYTE)) - 1U);
+    }
+}
+
+void generate_array_of_hamming_bits(uint8_t array_of_hamming_bits[NUMBER_HAMMING_BITS],
+                                    uint8_t array_of_bits[BITS_PER_BYTE],
+                                    int parity) {
+    int sum_of_8s_mod2 = (array_of_bits[4] + array_of_bits[5] + array_of_bits[6] + array_of_bits[7]) % 2;
+    int sum_of_4s_mod2 = (array_of_bits[1] + array_of_bits[2] + array_of_bits[3] + array_of_bits[7]) % 2;
+    int sum_of_2s_mod2 =
+            (array_of_bits[0] + array_of_bits[2] + array_of_bits[3] + array_of_bits[5] + array_of_bits[6]) % 2;
+    int sum_of_1s_mod2 =
+            (array_of_bits[0] + array_of_bits[1] + array_of_bits[3] + array_of_bits[4] + array_of_bits[6]) % 2;
+    // even
+    if (parity == 0) {
+        if (sum_of_1s_mod2 == 1) array_of_hamming_bits[0] = 1;
+        else array_of_hamming_bits[0] = 0;
+        if (sum_of_2s_mod2 == 1) array_of_hamming_bits[1] = 1;
+        else array_of_hamming_bits[1] = 0;
+        if (sum_of_4s_mod2 == 1) array_of_hamming_bits[2] = 1;
+        else array_of_hamming_bits[2] = 0;
+        if (sum_of_8s_mod2 == 1) array_of_hamming_bits[3] = 1;
+        else array_of_hamming_bits[3] = 0;
+    } else { // odd
+        if (sum_of_1s_mod2 == 1) array_of_hamming_bits[0] = 0;
+        else array_of_hamming_bits[0] = 1;
+        if (sum_of_2s_mod2 == 1) array_of_hamming_bits[1] = 0;
+        else array_of_hamming_bits[1] = 1;
+        if (sum_of_4s_mod2 == 1) array_of_hamming_bits[2] = 0;
+        else array_of_hamming_bits[2] = 1;
+        if (sum_of_8s_mod2 == 1) array_of_hamming_bits[3] = 0;
+        else array_of_hamming_bits[3] = 1;
+    }
+}
+
+void generate_array_of_bits_from_character(uint8_t array_of_bits[BITS_PER_BYTE], size_t length, const uint8_t byte) {
+    unsigned char masked;
+    uint8_t mask = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (i == 7) mask = B00000001;
+        if (i == 6) mask = B00000010;
+        if (i == 5) mask = B00000100;
+        if (i == 4) mask = B00001000;
+        if (i == 3) mask = B00010000;
+        if (i == 2) mask = B00100000;
+        if (i == 1) mask = B01000000;
+        if (i == 0) mask = B10000000;
+        masked = byte & mask;
+        if (mask == masked) {
+            array_of_bits[i] = 1;
+        } else {
+            array_of_bits[i] = 0;
+        }
+    }
+}
+
+void pack_plane(const uint8_t bits[], size_t count, uint8_t plane[]) {
+    size_t nbyte = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    // positions of byte.
+    for (size_t pos = 0; pos < nbyte; pos++) {
+        uint8_t writeValue = 0;
+        size_t upper_limit;
+        if (count < (BITS_PER_BYTE * (pos + 1))) {
+            upper_limit = count;
+        } else upper_limit = BITS_PER_BYTE * (pos + 1);
+        for (size_t j = BITS_PER_BYTE * pos; j < upper_limit; j++) {
+            if (bits[j] == 1) {
+                writeValue |= B00000001;
+            }
+            if (j != upper_limit - 1) { writeValue <<= 1; }
+        }
+        plane[pos] = writeValue;
+    }
+}
+
+enum hamming_check handleErrorDetection(int parity_int,
+                                        uint8_t array_bits[],
+                                        const uint8_t hamming_bits[],
+                                        uint8_t *value) {
+    enum hamming_check check = HAMMING_CLEAN;
+    int sum_of_8s_mod2 = (array_bits[4] + array_bits[5] + array_bits[6] + array_bits[7]) % 2;
+    int sum_of_4s_mod2 = (array_bits[1] + array_bits[2] + array_bits[3] + array_bits[7]) % 2;
+    int sum_of_2s_mod2 =
+            (array_bits[0] + array_bits[2] + array_bits[3] + array_bits[5] + array_bits[6]) % 2;
+    int sum_of_1s_mod2 =
+            (array_bits[0] + array_bits[1] + array_bits[3] + array_bits[4] + array_bits[6]) % 2;
+
+    int errors = 0;
+    bool error_pos_8 = false;
+    bool error_pos_4 = false;
+    bool error_pos_2 = false;
+    bool error_pos_1 = false;
+    uint8_t bit_mask = B00000001;
+
+    *value = 0;
+
+    if ((sum_of_8s_mod2 + hamming_bits[3]) % 2 == !parity_int) {
+        errors++;
+        error_pos_8 = true;
+    }
+    if ((sum_of_4s_mod2 + hamming_bits[2]) % 2 == !parity_int) {
+        error_pos_4 = true;
+        errors++;
+    }
+    if ((sum_of_2s_mod2 + hamming_bits[1]) % 2 == !parity_int) {
+        error_pos_2 = true;
+        errors++;
+    }
+    if ((sum_of_1s_mod2 + hamming_bits[0]) % 2 == !parity_int) {
+        error_pos_1 = true;
+        errors++;
+    }
+
+    if (errors == 2 || errors == 0) {
+        if (errors == 2) {
+            check = HAMMING_CORRECTED;
+        }
+        if (error_pos_1 && error_pos_2) {
+
+            array_bits[0] = flipBit(array_bits[0]);
+
+        } else if (error_pos_1 && error_pos_4) {
+
+            array_bits[1] = flipBit(array_bits[1]);
+
+        } else if (error_pos_1 && error_pos_8) {
+
+            array_bits[4] = flipBit(array_bits[4]);
+
+        } else if (error_pos_2 && error_pos_4) {
+
+            array_bits[2] = flipBit(array_bits[2]);
+
+        } else if (error_pos_2 && error_pos_8) {
+
+            array_bits[5] = flipBit(array_bits[5]);
+
+        } else if (error_pos_4 && error_pos_8) {
+
+            array_bits[7] = flipBit(array_bits[7]);
+
+        }
+    } else {
+        check = HAMMING_UNCORRECTABLE;
+    }
+    for (size_t q = 0; q < BITS_PER_BYTE; q++) {
+        if (array_bits[q] == 1) {
+            *value |= bit_mask;
+        }
+        if (q != 7) {
+            *value <<= 1;
+        }
+    }
+    return check;
+}
+
+uint8_t flipBit(uint8_t bitToFlip) {
+    if (bitToFlip == 0) {
+        return 1;
+    }
+    return 0;
+}
+
+void insertItemToArray(size_t messageIndex,
+                       size_t index,
+                       size_t nbytes,
+                       size_t numOfCharsInMessage,
+                       const uint8_t word[],
+                       uint8_t array_bits[],
+                       uint8_t hamming_bit[]) {
+    uint8_t byte = word[messageIndex / BITS_PER_BYTE];
+
+    // if last byte of reading file
+    if ((messageIndex / BITS_PER_BYTE) + 1 == nbytes) {
+        messageIndex += (BITS_PER_BYTE - (numOfCharsInMessage - BITS_PER_BYTE * (nbytes - 1)));
+    }
+    uint8_t add = 0;
+    if (messageIndex % BITS_PER_BYTE == 0) {
+        byte &= B10000000;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 1) {
+        byte &= B01000000;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 2) {
+        byte &= B00100000;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 3) {
+        byte &= B00010000;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 4) {
+        byte &= B00001000;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 5) {
+        byte &= B00000100;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 6) {
+        byte &= B00000010;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    } else if (messageIndex % BITS_PER_BYTE == 7) {
+        byte &= B00000001;
+        byte |= 0;
+        add = checkBit1Or0(byte);
+    }
+
+    if (index <= 7) {
+        array_bits[index] = add;
+    } else {
+        hamming_bit[index - BITS_PER_BYTE] = add;
+    }
+}
+
+uint8_t checkBit1Or0(uint8_t byteToCheck) {
+    if (byteToCheck == 0) {
+        return 0;
+    } else {
+        return 1;
+    }
+}
@@ -0,0 +1,503 @@
+#include "hamming_decode.h"
+#include "hamming_cache.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_pipeline.h"
+#include "hamming_sample.h"
+#include "hamming_stripe.h"
+#include "hamming_trace.h"
+#include <ctype.h>
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * No plane is erased.
+ */
+#define NO_ERASURE BITS_INC_HAMMING
+
+/**
+ * Appended to the path of a rebuilt plane until it is complete.
+ */
+#define REPAIR_SUFFIX ".rebuild"
+
+/**
+ * What the decoding stages share. The read stage owns the plane files, the remaining
+ * length and the rebuilt plane, and hands the planes of each chunk to the I/O workers. The
+ * write stage owns the output and the counters.
+ */
+struct decode_state {
+    int fds[BITS_INC_HAMMING];
+    int out_fd;
+    int repair_fd;      // receives the rebuilt plane, -1 when not repairing
+    int parity;
+    bool binary;
+    bool direct_io;
+    bool verify;
+    bool sparse;        // the sidecar says the plane files have holes
+    size_t erased;      // the plane rebuilt from the others, NO_ERASURE if none
+    uint64_t length;    // characters encoded when the sidecar is known, otherwise UINT64_MAX
+    unsigned int constant;      // planes that have no file, every bit is the same
+    unsigned int constant_ones; // the constant planes whose bits are all 1
+    uint64_t position;  // characters read so far
+    uint64_t offset;    // bytes read so far from each plane file
+    uint64_t remaining; // characters left to decode when the length is known
+    struct hamming_decode_stats *stats;
+    struct hamming_stripe stripe;
+    struct hamming_buffers *buffers; // the chunk the I/O workers are reading
+    uint64_t sequence;               // its sequence number
+    size_t nbyte;                    // bytes wanted from each plane of the chunk
+    ssize_t reads[BITS_INC_HAMMING]; // bytes each plane read
+};
+
+static int read_sidecar(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        bool required,
+                        struct decode_state *state);
+
+static int plan_erasure(struct dc_error *err,
+                        const char *prefix,
+                        struct decode_state *state,
+                        unsigned int *planes);
+
+static int open_repair(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, struct decode_state *state);
+
+static int finish_repair(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         const char *prefix,
+                         size_t erased,
+                         bool success);
+
+static int read_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int read_chunk_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg);
+
+static int decode_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int write_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+void hamming_decode_options_init(struct hamming_decode_options *options) {
+    options->parity = 0;
+    options->binary = false;
+    options->chunk_size = 0;
+    options->threads = 0;
+    options->direct_io = false;
+    options->verify = true;
+    options->repair = false;
+    options->huge_pages = false;
+    options->cache_dir = NULL;
+    options->cache_size = HAMMING_CACHE_DEFAULT_SIZE;
+}
+
+int hamming_decode(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   const char *prefix,
+                   int out_fd,
+                   const struct hamming_decode_options *options,
+                   struct hamming_decode_stats *stats) {
+    struct hamming_pipeline_config pipeline;
+    struct decode_state state;
+    unsigned int planes;
+    int oflag;
+    int ret_val;
+
+    DC_TRACE(env);
+
+    if (options->parity == HAMMING_PARITY_AUTO || options->parity == HAMMING_PARITY_CHECK) {
+        struct hamming_decode_options detected = *options;
+        struct hamming_parity_guess guess;
+
+        if (hamming_find_parity(env, err, arena, prefix, options->parity == HAMMING_PARITY_CHECK, &guess) == -1) {
+            return -1;
+        }
+
+        // when they disagree the planes win, they are what is decoded
+        detected.parity = guess.parity;
+        // an empty plane set without a sidecar takes the default, neither recorded nor found
+        stats->parity_detected = guess.sampled || guess.recorded != HAMMING_META_NO_PARITY;
+        stats->parity_sampled = guess.sampled;
+        stats->parity_mismatch = guess.sampled && guess.recorded != HAMMING_META_NO_PARITY &&
+                                 guess.recorded != guess.parity;
+        stats->parity = guess.parity;
+
+        return hamming_decode(env, err, arena, prefix, out_fd, &detected, stats);
+    }
+
+    // a miss comes back here without the cache
+    if (options->cache_dir != NULL) {
+        return hamming_cache_decode(env, err, arena, prefix, out_fd, options, stats);
+    }
+
+    state.out_fd = out_fd;
+    state.repair_fd = -1;
+    state.parity = options->parity;
+    state.binary = options->binary;
+    state.direct_io = options->direct_io;
+    state.verify = options->verify;
+    state.position = 0;
+    state.offset = 0;
+    state.stats = stats;
+
+    // binary payloads can end in bytes that look like padding, so the exact length is required
+    if (read_sidecar(env, err, prefix, options->binary, &state) == -1) {
+        return -1;
+    }
+
+    // the sidecar length also keeps the padding characters of the last plane byte out of text
+    state.remaining = state.length;
+
+    if (plan_erasure(err, prefix, &state, &planes) == -1) {
+        return -1;
+    }
+
+    pipeline.chunk_size = hamming_chunk_size(options->chunk_size);
+
+    if (options->direct_io) {
+        pipeline.chunk_size = hamming_direct_chunk_size(pipeline.chunk_size);
+    }
+
+    pipeline.workers = options->threads;
+    pipeline.depth = 0;
+    pipeline.read = read_chunk;
+    pipeline.work = decode_chunk;
+    pipeline.write = write_chunk;
+    pipeline.arg = &state;
+    pipeline.work_name = options->verify ? "correct" : "extract";
+
+    // every buffer is allocated once here and reused for every chunk
+    if (hamming_arena_reserve(env, err, arena, hamming_pipeline_arena_size(&pipeline),
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1) {
+        return -1;
+    }
+
+    oflag = DC_O_RDONLY;
+
+    if (options->direct_io) {
+        oflag |= HAMMING_O_DIRECT;
+    }
+
+    if (hamming_open_plane_set(env, err, prefix, planes, oflag, 0, state.fds) == -1) {
+        return -1;
+    }
+
+    if (options->repair && state.erased != NO_ERASURE && open_repair(env, err, prefix, &state) == -1) {
+        hamming_close_planes(env, err, state.fds);
+        return -1;
+    }
+
+    if (hamming_stripe_start(env, err, &state.stripe) == -1) {
+        hamming_close_planes(env, err, state.fds);
+
+        if (state.repair_fd != -1) {
+            dc_dc_close(env, err, state.repair_fd);
+            finish_repair(env, err, prefix, state.erased, false);
+        }
+
+        return -1;
+    }
+
+    ret_val = hamming_pipeline_run(env, err, arena, &pipeline);
+    hamming_stripe_stop(&state.stripe);
+    hamming_close_planes(env, err, state.fds);
+
+    if (state.repair_fd != -1) {
+        dc_dc_close(env, err, state.repair_fd);
+
+        if (finish_repair(env, err, prefix, state.erased, ret_val == 0 && dc_error_has_no_error(err)) == -1) {
+            ret_val = -1;
+        }
+    }
+
+    return ret_val == -1 || dc_error_has_error(err) ? -1 : 0;
+}
+
+static int read_sidecar(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        bool required,
+                        struct decode_state *state) {
+    struct hamming_meta meta;
+    struct stat status;
+    char *path;
+    size_t path_size;
+    bool exists;
+
+    state->length = UINT64_MAX;
+    state->constant = 0;
+    state->constant_ones = 0;
+    state->sparse = false;
+    path = hamming_meta_path(env, err, prefix, &path_size);
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    // plane sets written before the sidecar existed are still decoded as text
+    exists = stat(path, &status) == 0;
+    dc_free(env, path, path_size);
+
+    if (!exists && !required) {
+        return 0;
+    }
+
+    if (hamming_meta_read(env, err, prefix, &meta) == -1) {
+        return -1;
+    }
+
+    state->length = meta.length;
+    state->constant = meta.constant;
+    state->constant_ones = meta.constant_ones;
+    state->sparse = meta.sparse;
+
+    return 0;
+}
+
+static int plan_erasure(struct dc_error *err,
+                        const char *prefix,
+                        struct decode_state *state,
+                        unsigned int *planes) {
+    unsigned int erased;
+    unsigned int data_planes = HAMMING_ALL_PLANES >> NUMBER_HAMMING_BITS;
+    unsigned int stored = HAMMING_ALL_PLANES & ~state->constant;
+
+    if (hamming_find_erasures(prefix, stored, state->length, &erased) == -1) {
+        DC_ERROR_RAISE_USER(err, "no plane file found for the prefix", -1);
+        return -1;
+    }
+
+    state->erased = NO_ERASURE;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (erased == HAMMING_PLANE_BIT(index)) {
+            state->erased = index;
+        }
+    }
+
+    // without verification the parity planes are never opened, let alone read
+    if (!state->verify && !(erased & data_planes)) {
+        state->erased = NO_ERASURE;
+        *planes = data_planes & stored;
+
+        return 0;
+    }
+
+    if (erased != 0 && state->erased == NO_ERASURE) {
+        DC_ERROR_RAISE_USER(err, "more than one plane file is missing or short, the planes cannot be rebuilt", -1);
+        return -1;
+    }
+
+    *planes = stored & ~erased;
+    state->stats->erased |= erased;
+
+    return 0;
+}
+
+static int open_repair(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, struct decode_state *state) {
+    char path[PATH_MAX];
+    char repair_path[PATH_MAX + sizeof(REPAIR_SUFFIX)];
+
+    if (hamming_plane_path(prefix, state->erased, path, sizeof(path)) == -1) {
+        DC_ERROR_RAISE_USER(err, "plane file path is too long", -1);
+        return -1;
+    }
+
+    snprintf(repair_path, sizeof(repair_path), "%s%s", path, REPAIR_SUFFIX);
+    state->repair_fd = dc_open(env, err, repair_path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_error(err)) {
+        state->repair_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int finish_repair(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         const char *prefix,
+                         size_t erased,
+                         bool success) {
+    char path[PATH_MAX];
+    char repair_path[PATH_MAX + sizeof(REPAIR_SUFFIX)];
+
+    DC_TRACE(env);
+    hamming_plane_path(prefix, erased, path, sizeof(path));
+    snprintf(repair_path, sizeof(repair_path), "%s%s", path, REPAIR_SUFFIX);
+
+    // a partly rebuilt plane is worse than a missing one, it would not be detected again
+    if (!success) {
+        unlink(repair_path);
+        return 0;
+    }
+
+    if (rename(repair_path, path) == -1) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        unlink(repair_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int read_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct decode_state *state = arg;
+    struct hamming_buffers *buffers = &chunk->buffers;
+    size_t nbyte = buffers->chunk_size / BITS_PER_BYTE;
+    ssize_t nread = -1;
+    unsigned int planes = 0;
+    size_t exact;
+
+    if (state->remaining < buffers->chunk_size) {
+        nbyte = (size_t) (state->remaining + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (state->fds[index] != -1) {
+            planes |= HAMMING_PLANE_BIT(index);
+        }
+    }
+
+    state->buffers = buffers;
+    state->sequence = chunk->sequence;
+    state->nbyte = nbyte;
+
+    if (hamming_stripe_run(env, err, &state->stripe, planes, read_chunk_plane, state) == -1) {
+        return -1;
+    }
+
+    // the first plane decides how many characters there are, the others must have as many
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (state->fds[index] == -1) {
+            continue;
+        }
+
+        if (nread == -1) {
+            nread = state->reads[index];
+        } else if (state->reads[index] < nread) {
+            DC_ERROR_RAISE_USER(err, "plane file is shorter than the encoded message", -1);
+            return -1;
+        }
+    }
+
+    // constant planes have no file, so with nothing but constant planes the sidecar length decides
+    if (nread == -1) {
+        uint64_t left = (state->length - state->position + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+        nread = (ssize_t) (left < nbyte ? left : nbyte);
+    }
+
+    state->offset += (uint64_t) nread;
+    chunk->count = BITS_PER_BYTE * (size_t) nread;
+    exact = chunk->count;
+
+    // the exact count keeps the padding bits of a partial byte at 0
+    if (state->length != UINT64_MAX && state->length - state->position < exact) {
+        exact = (size_t) (state->length - state->position);
+    }
+
+    state->position += exact;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (state->constant & HAMMING_PLANE_BIT(index)) {
+            hamming_fill_plane(buffers->planes[index], exact, (state->constant_ones & HAMMING_PLANE_BIT(index)) != 0);
+        }
+    }
+
+    if (state->erased != NO_ERASURE) {
+        hamming_rebuild_plane(buffers, exact, state->parity, state->erased);
+
+        if (state->repair_fd != -1 &&
+            hamming_write_fully(env, err, state->repair_fd, buffers->planes[state->erased], (size_t) nread) == -1) {
+            return -1;
+        }
+    }
+
+    if (state->binary && (size_t) nread < nbyte) {
+        DC_ERROR_RAISE_USER(err, "plane file is shorter than the encoded message", -1);
+        return -1;
+    }
+
+    // without a sidecar remaining stays UINT64_MAX and text ends with the shortest plane
+    if (state->remaining < chunk->count) {
+        chunk->count = (size_t) state->remaining;
+    }
+
+    if (state->remaining != UINT64_MAX) {
+        state->remaining -= chunk->count;
+    }
+
+    chunk->final = state->remaining == 0 || (size_t) nread < nbyte;
+
+    return 0;
+}
+
+static int read_chunk_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg) {
+    struct decode_state *state = arg;
+    uint8_t *plane = state->buffers->planes[index];
+
+    hamming_trace_begin("read plane", state->sequence, index);
+
+    if (state->sparse) {
+        state->reads[index] = hamming_read_sparse(env, err, state->fds[index], plane, state->nbyte, state->offset,
+                                                  state->direct_io);
+    } else if (state->direct_io) {
+        state->reads[index] = hamming_read_direct(env, err, state->fds[index], plane, state->nbyte);
+    } else {
+        state->reads[index] = hamming_read_fully(env, err, state->fds[index], plane, state->nbyte);
+    }
+
+    hamming_trace_end();
+
+    return state->reads[index] == -1 ? -1 : 0;
+}
+
+static int decode_chunk(__attribute__((unused)) const struct dc_posix_env *env,
+                        __attribute__((unused)) struct dc_error *err,
+                        struct hamming_chunk *chunk,
+                        void *arg) {
+    const struct decode_state *state = arg;
+
+    chunk->stats.characters = 0;
+    chunk->stats.corrected = 0;
+    chunk->stats.uncorrectable = 0;
+    chunk->stats.erased = 0;
+
+    if (state->verify) {
+        hamming_decode_chunk(&chunk->buffers, chunk->count, state->parity, &chunk->stats);
+    } else {
+        hamming_extract_chunk(&chunk->buffers, chunk->count, &chunk->stats);
+    }
+
+    return 0;
+}
+
+static int write_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct decode_state *state = arg;
+    uint8_t *chars = chunk->buffers.chars;
+    size_t length = chunk->count;
+
+    state->stats->characters += chunk->stats.characters;
+    state->stats->corrected += chunk->stats.corrected;
+    state->stats->uncorrectable += chunk->stats.uncorrectable;
+
+    if (!state->binary) {
+        length = 0;
+
+        for (size_t i = 0; i < chunk->count; i++) {
+            if (isprint(chars[i])) {
+                chars[length++] = chars[i];
+            }
+        }
+    }
+
+    return hamming_write_fully(env, err, state->out_fd, chars, length);
+}
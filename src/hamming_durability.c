@@ -0,0 +1,234 @@
+#include "hamming_durability.h"
+#include "hamming_clock.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_stripe.h"
+#include "hamming_trace.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static int flush_path(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      const char *path,
+                      enum hamming_durability mode,
+                      struct hamming_flush_stats *stats);
+
+static int flush_directory(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *path,
+                           struct hamming_flush_stats *stats);
+
+int hamming_durability_parse(const struct dc_posix_env *env, const char *str, enum hamming_durability *mode) {
+    if (str == NULL) {
+        return -1;
+    }
+
+    if (!dc_strcmp(env, str, "none")) {
+        *mode = HAMMING_DURABILITY_NONE;
+    } else if (!dc_strcmp(env, str, "fdatasync")) {
+        *mode = HAMMING_DURABILITY_FDATASYNC;
+    } else if (!dc_strcmp(env, str, "batched")) {
+        *mode = HAMMING_DURABILITY_BATCHED;
+    } else if (!dc_strcmp(env, str, "syncfs")) {
+        *mode = HAMMING_DURABILITY_SYNCFS;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+int hamming_durability_planes(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const int fds[BITS_INC_HAMMING],
+                              enum hamming_durability mode,
+                              bool deferred,
+                              struct hamming_flush_stats *stats) {
+    double start = hamming_clock_now();
+
+    DC_TRACE(env);
+
+    if (mode == HAMMING_DURABILITY_NONE) {
+        return 0;
+    }
+
+    hamming_trace_begin("flush", HAMMING_TRACE_NO_CHUNK, HAMMING_TRACE_NO_PLANE);
+
+    switch (mode) {
+        case HAMMING_DURABILITY_FDATASYNC:
+            for (size_t index = 0; index < BITS_INC_HAMMING && dc_error_has_no_error(err); index++) {
+                dc_fdatasync(env, err, fds[index]);
+                stats->barriers++;
+            }
+            break;
+        case HAMMING_DURABILITY_BATCHED:
+#ifdef SYNC_FILE_RANGE_WRITE
+            // queue the write back of every plane first so the device can merge them
+            for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+                if (sync_file_range(fds[index], 0, 0, SYNC_FILE_RANGE_WRITE) == -1) {
+                    DC_ERROR_RAISE_ERRNO(err, errno);
+                    break;
+                }
+            }
+
+            // the syncfs of the caller waits for the write back and is the only barrier
+            if (deferred) {
+                break;
+            }
+
+            // waiting issues no barrier, the one fdatasync of the sidecar in
+            // hamming_durability_commit commits the sizes of the planes with it
+            for (size_t index = 0; index < BITS_INC_HAMMING && dc_error_has_no_error(err); index++) {
+                if (sync_file_range(fds[index], 0, 0,
+                                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) ==
+                    -1) {
+                    DC_ERROR_RAISE_ERRNO(err, errno);
+                }
+            }
+#else
+            // without sync_file_range a plane set on its own falls back to fdatasync mode, a batch
+            // still leaves everything to its syncfs
+            for (size_t index = 0; index < BITS_INC_HAMMING && dc_error_has_no_error(err) && !deferred; index++) {
+                dc_fdatasync(env, err, fds[index]);
+                stats->barriers++;
+            }
+#endif
+            break;
+        case HAMMING_DURABILITY_NONE:
+        case HAMMING_DURABILITY_SYNCFS:
+        default:
+            break;
+    }
+
+    stats->seconds += hamming_clock_now() - start;
+    hamming_trace_end();
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+int hamming_durability_commit(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *prefix,
+                              enum hamming_durability mode,
+                              struct hamming_flush_stats *stats) {
+    char *path;
+    size_t path_size;
+    int ret_val;
+
+    DC_TRACE(env);
+
+    if (mode == HAMMING_DURABILITY_NONE) {
+        return 0;
+    }
+
+    path = hamming_meta_path(env, err, prefix, &path_size);
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    hamming_trace_begin("commit", HAMMING_TRACE_NO_CHUNK, HAMMING_TRACE_NO_PLANE);
+    ret_val = flush_path(env, err, path, mode, stats);
+    dc_free(env, path, path_size);
+
+    // new files are only durable once the directory entries naming them are; in batched mode
+    // the sidecar's fdatasync above also stands for the planes, which relies on the file system
+    // committing the size changes of every file in one ordered journal, as ext4 and XFS do
+    if (ret_val == 0 && (mode == HAMMING_DURABILITY_FDATASYNC || mode == HAMMING_DURABILITY_BATCHED)) {
+        ret_val = flush_directory(env, err, prefix, stats);
+    }
+
+    // striped planes are named in other directories, which can be on other file systems
+    for (size_t device = 0; ret_val == 0 && device < hamming_stripe_devices() && hamming_stripe_dir(device) != NULL;
+         device++) {
+        char plane_path[PATH_MAX];
+
+        if (hamming_plane_path(prefix, device, plane_path, sizeof(plane_path)) == -1) {
+            DC_ERROR_RAISE_USER(err, "plane file path is too long", -1);
+            ret_val = -1;
+            break;
+        }
+
+        if (mode == HAMMING_DURABILITY_FDATASYNC || mode == HAMMING_DURABILITY_BATCHED) {
+            ret_val = flush_directory(env, err, plane_path, stats);
+        } else if (mode == HAMMING_DURABILITY_SYNCFS) {
+            ret_val = flush_path(env, err, hamming_stripe_dir(device), mode, stats);
+        }
+    }
+
+    hamming_trace_end();
+
+    return ret_val;
+}
+
+static int flush_path(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      const char *path,
+                      enum hamming_durability mode,
+                      struct hamming_flush_stats *stats) {
+    double start = hamming_clock_now();
+    int fd;
+
+    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    if (mode == HAMMING_DURABILITY_SYNCFS) {
+#ifdef __linux__
+        if (syncfs(fd) == -1) {
+            DC_ERROR_RAISE_ERRNO(err, errno);
+        }
+#else
+        sync();
+#endif
+    } else {
+        dc_fdatasync(env, err, fd);
+    }
+
+    dc_dc_close(env, err, fd);
+    stats->barriers++;
+    stats->seconds += hamming_clock_now() - start;
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static int flush_directory(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *path,
+                           struct hamming_flush_stats *stats) {
+    char directory[PATH_MAX];
+    const char *slash = strrchr(path, '/');
+    double start = hamming_clock_now();
+    int fd;
+
+    if (slash == NULL) {
+        snprintf(directory, sizeof(directory), ".");
+    } else if (slash == path) {
+        snprintf(directory, sizeof(directory), "/");
+    } else {
+        snprintf(directory, sizeof(directory), "%.*s", (int) (slash - path), path);
+    }
+
+    fd = dc_open(env, err, directory, DC_O_RDONLY, 0);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    dc_fsync(env, err, fd);
+    dc_dc_close(env, err, fd);
+    stats->barriers++;
+    stats->seconds += hamming_clock_now() - start;
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
@@ -0,0 +1,374 @@
+#include "hamming_encode.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_pipeline.h"
+#include "hamming_stripe.h"
+#include "hamming_trace.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * What the encoding stages share. The read stage owns the carried byte, the write stage
+ * owns the plane files and the size, and hands the planes of each chunk to the I/O workers.
+ */
+struct encode_state {
+    int in_fd;
+    int fds[BITS_INC_HAMMING];
+    int parity;
+    bool binary;
+    bool direct_io;
+    bool sparse;
+    bool has_carry;
+    uint8_t carry;              // the byte read past the end of the previous chunk
+    uint64_t size;
+    unsigned int constant;      // planes whose bits have all been the same so far, nothing is written for them
+    unsigned int constant_ones; // the constant planes whose bits are all 1
+    uint8_t *fill[2];           // fill_size bytes of 0x00 and of 0xFF, to write out a constant run
+    size_t fill_size;
+    struct hamming_stripe stripe;
+    struct hamming_chunk *chunk; // the chunk the I/O workers are writing
+    size_t nbyte;                // bytes of each plane of the chunk
+    uint64_t offset;             // where the chunk starts in each plane file
+    unsigned int flush;          // planes that stopped being constant, the skipped run is written first
+    unsigned int flush_ones;     // the planes of flush whose skipped run is all 1
+};
+
+static int read_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int encode_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int write_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int write_chunk_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg);
+
+static int write_constant_run(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const struct encode_state *state,
+                              size_t index,
+                              uint64_t size);
+
+static int write_plane(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const struct encode_state *state,
+                       size_t index,
+                       uint8_t *buf,
+                       size_t nbyte,
+                       uint64_t offset);
+
+static int truncate_planes(const struct dc_posix_env *env, struct dc_error *err, const struct encode_state *state);
+
+static void remove_constant_planes(const char *prefix, unsigned int constant);
+
+void hamming_encode_options_init(struct hamming_encode_options *options) {
+    options->parity = 0;
+    options->binary = false;
+    options->chunk_size = 0;
+    options->threads = 0;
+    options->direct_io = false;
+    options->durability = HAMMING_DURABILITY_NONE;
+    options->defer_commit = false;
+    options->elide_constant = false;
+    options->sparse = false;
+    options->huge_pages = false;
+}
+
+int hamming_encode(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   int in_fd,
+                   const char *prefix,
+                   const struct hamming_encode_options *options,
+                   struct hamming_encode_stats *stats) {
+    struct hamming_pipeline_config pipeline;
+    struct encode_state state;
+    struct hamming_meta meta;
+    int oflag;
+    int ret_val;
+
+    DC_TRACE(env);
+    state.in_fd = in_fd;
+    state.parity = options->parity;
+    state.binary = options->binary;
+    state.direct_io = options->direct_io;
+    state.sparse = options->sparse;
+    state.has_carry = false;
+    state.carry = 0;
+    state.size = 0;
+    state.constant = options->elide_constant ? HAMMING_ALL_PLANES : 0;
+    state.constant_ones = 0;
+
+    pipeline.chunk_size = hamming_chunk_size(options->chunk_size);
+
+    if (options->direct_io) {
+        pipeline.chunk_size = hamming_direct_chunk_size(pipeline.chunk_size);
+    }
+
+    pipeline.workers = options->threads;
+    pipeline.depth = 0;
+    pipeline.read = read_chunk;
+    pipeline.work = encode_chunk;
+    pipeline.write = write_chunk;
+    pipeline.arg = &state;
+    pipeline.work_name = "transpose and parity";
+
+    // a constant run is written out at most one plane buffer at a time
+    state.fill_size = ((pipeline.chunk_size / BITS_PER_BYTE + HAMMING_PLANE_ALIGNMENT - 1) / HAMMING_PLANE_ALIGNMENT) *
+                      HAMMING_PLANE_ALIGNMENT;
+
+    // every buffer is allocated once here and reused for every chunk
+    if (hamming_arena_reserve(env, err, arena,
+                              hamming_pipeline_arena_size(&pipeline) + 2 * state.fill_size + HAMMING_PLANE_ALIGNMENT,
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1) {
+        return -1;
+    }
+
+    state.fill[0] = hamming_arena_alloc_aligned(arena, state.fill_size, HAMMING_PLANE_ALIGNMENT);
+    state.fill[1] = hamming_arena_alloc_aligned(arena, state.fill_size, HAMMING_PLANE_ALIGNMENT);
+    memset(state.fill[0], 0x00, state.fill_size);
+    memset(state.fill[1], 0xFF, state.fill_size);
+
+    oflag = DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY;
+
+    if (options->direct_io) {
+        oflag |= HAMMING_O_DIRECT;
+    }
+
+    if (hamming_open_planes(env, err, prefix, oflag, S_IRUSR | S_IWUSR, state.fds) == -1) {
+        return -1;
+    }
+
+    if (hamming_stripe_start(env, err, &state.stripe) == -1) {
+        hamming_close_planes(env, err, state.fds);
+        return -1;
+    }
+
+    ret_val = hamming_pipeline_run(env, err, arena, &pipeline);
+    hamming_stripe_stop(&state.stripe);
+
+    if (ret_val == 0 && state.sparse) {
+        ret_val = truncate_planes(env, err, &state);
+    }
+
+    if (ret_val == 0) {
+        ret_val = hamming_durability_planes(env, err, state.fds, options->durability, options->defer_commit,
+                                            &stats->flush);
+    }
+
+    hamming_close_planes(env, err, state.fds);
+
+    if (ret_val == -1 || dc_error_has_error(err)) {
+        return -1;
+    }
+
+    remove_constant_planes(prefix, state.constant);
+
+    // record the exact length so the decoder can tell padding bits from payload
+    hamming_meta_init(&meta);
+    meta.length = state.size;
+    meta.parity = options->parity;
+    meta.constant = state.constant;
+    meta.constant_ones = state.constant_ones;
+    meta.sparse = options->sparse;
+
+    if (hamming_meta_write(env, err, prefix, &meta) == -1) {
+        return -1;
+    }
+
+    stats->characters += state.size;
+
+    // the planes are written back before the sidecar is written, so a durable sidecar vouches for them
+    if (!options->defer_commit &&
+        hamming_durability_commit(env, err, prefix, options->durability, &stats->flush) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int read_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct encode_state *state = arg;
+    struct hamming_buffers *buffers = &chunk->buffers;
+    size_t pending = 0;
+    ssize_t nread;
+
+    if (state->has_carry) {
+        buffers->chars[0] = state->carry;
+        pending = 1;
+    }
+
+    // read one byte past the chunk to know whether this is the last one
+    nread = hamming_read_fully(env, err, state->in_fd, buffers->chars + pending, buffers->chunk_size + 1 - pending);
+
+    if (nread == -1) {
+        return -1;
+    }
+
+    chunk->count = pending + (size_t) nread;
+
+    if (chunk->count > buffers->chunk_size) {
+        chunk->count = buffers->chunk_size;
+        state->carry = buffers->chars[buffers->chunk_size];
+        state->has_carry = true;
+    } else {
+        chunk->final = true;
+
+        // text input ends with the newline that submitted it, binary input is encoded byte for byte
+        if (!state->binary && chunk->count > 0 && buffers->chars[chunk->count - 1] == '\n') {
+            chunk->count--;
+        }
+    }
+
+    return 0;
+}
+
+static int encode_chunk(__attribute__((unused)) const struct dc_posix_env *env,
+                        __attribute__((unused)) struct dc_error *err,
+                        struct hamming_chunk *chunk,
+                        void *arg) {
+    const struct encode_state *state = arg;
+
+    hamming_encode_chunk(&chunk->buffers, chunk->count, state->parity);
+
+    return 0;
+}
+
+static int write_chunk(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct encode_state *state = arg;
+    size_t nbyte = (chunk->count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    // every chunk but the last fills whole blocks, so the offset of a direct write stays aligned
+    uint64_t offset = state->size / BITS_PER_BYTE;
+    unsigned int planes = 0;
+
+    state->flush = 0;
+    state->flush_ones = 0;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        unsigned int bit = HAMMING_PLANE_BIT(index);
+
+        if (state->constant & bit) {
+            int value = hamming_plane_constant(chunk->buffers.planes[index], chunk->count);
+
+            // the first chunk decides the value a plane must keep to stay constant
+            if (state->size == 0 && value == 1) {
+                state->constant_ones |= bit;
+            }
+
+            if (value != -1 && (state->size == 0 || value == ((state->constant_ones & bit) != 0))) {
+                continue;
+            }
+
+            // the plane stops being constant, so everything skipped so far is written first
+            state->flush |= bit;
+            state->flush_ones |= state->constant_ones & bit;
+            state->constant &= ~bit;
+            state->constant_ones &= ~bit;
+        }
+
+        planes |= bit;
+    }
+
+    state->chunk = chunk;
+    state->nbyte = nbyte;
+    state->offset = offset;
+
+    if (hamming_stripe_run(env, err, &state->stripe, planes, write_chunk_plane, state) == -1) {
+        return -1;
+    }
+
+    state->size += chunk->count;
+
+    return 0;
+}
+
+static int write_chunk_plane(const struct dc_posix_env *env, struct dc_error *err, size_t index, void *arg) {
+    const struct encode_state *state = arg;
+    int ret_val = 0;
+
+    hamming_trace_begin("write plane", state->chunk->sequence, index);
+
+    if ((state->flush & HAMMING_PLANE_BIT(index)) &&
+        write_constant_run(env, err, state, index, state->offset) == -1) {
+        ret_val = -1;
+    }
+
+    if (ret_val == 0) {
+        ret_val = write_plane(env, err, state, index, state->chunk->buffers.planes[index], state->nbyte, state->offset);
+    }
+
+    hamming_trace_end();
+
+    return ret_val;
+}
+
+static int write_constant_run(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const struct encode_state *state,
+                              size_t index,
+                              uint64_t size) {
+    uint8_t *fill = state->fill[(state->flush_ones & HAMMING_PLANE_BIT(index)) != 0];
+    uint64_t offset = 0;
+
+    while (offset < size) {
+        size_t nbyte = size - offset < state->fill_size ? (size_t) (size - offset) : state->fill_size;
+
+        if (write_plane(env, err, state, index, fill, nbyte, offset) == -1) {
+            return -1;
+        }
+
+        offset += nbyte;
+    }
+
+    return 0;
+}
+
+static int write_plane(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const struct encode_state *state,
+                       size_t index,
+                       uint8_t *buf,
+                       size_t nbyte,
+                       uint64_t offset) {
+    if (state->sparse) {
+        return hamming_write_sparse(env, err, state->fds[index], buf, nbyte, offset, state->direct_io);
+    }
+
+    if (state->direct_io) {
+        return hamming_write_direct(env, err, state->fds[index], buf, nbyte, offset);
+    }
+
+    return hamming_write_fully(env, err, state->fds[index], buf, nbyte);
+}
+
+static int truncate_planes(const struct dc_posix_env *env, struct dc_error *err, const struct encode_state *state) {
+    // a hole at the end of a plane was seeked over, which does not make the file any longer
+    off_t length = (off_t) ((state->size + BITS_PER_BYTE - 1) / BITS_PER_BYTE);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (state->constant & HAMMING_PLANE_BIT(index)) {
+            continue;
+        }
+
+        dc_ftruncate(env, err, state->fds[index], length);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void remove_constant_planes(const char *prefix, unsigned int constant) {
+    char path[PATH_MAX];
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if ((constant & HAMMING_PLANE_BIT(index)) && hamming_plane_path(prefix, index, path, sizeof(path)) == 0) {
+            unlink(path);
+        }
+    }
+}
@@ -0,0 +1,436 @@
+#include "hamming_io.h"
+#include "hamming_stripe.h"
+#include "hamming_syscalls.h"
+#include "hamming_throttle.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static size_t align_up(size_t size);
+
+static bool block_is_zero(const uint8_t *block, size_t size);
+
+static int write_run(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     int fd,
+                     uint8_t *buf,
+                     size_t size,
+                     uint64_t offset,
+                     bool direct);
+
+int hamming_plane_path(const char *prefix, size_t index, char *path, size_t size) {
+    const char *dir = hamming_stripe_dir(index);
+    int written;
+
+    if (dir != NULL) {
+        written = snprintf(path, size, "%s/%s_%zu.hamming", dir, prefix, index);
+    } else {
+        written = snprintf(path, size, "%s_%zu.hamming", prefix, index); // puts string into buffer
+    }
+
+    if (written < 0 || (size_t) written >= size) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int hamming_open_planes(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        int oflag,
+                        mode_t mode,
+                        int fds[BITS_INC_HAMMING]) {
+    return hamming_open_plane_set(env, err, prefix, HAMMING_ALL_PLANES, oflag, mode, fds);
+}
+
+int hamming_open_plane_set(const struct dc_posix_env *env,
+                           struct dc_error *err,
+                           const char *prefix,
+                           unsigned int planes,
+                           int oflag,
+                           mode_t mode,
+                           int fds[BITS_INC_HAMMING]) {
+    char path[PATH_MAX];
+
+    DC_TRACE(env);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        fds[index] = -1;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (!(planes & HAMMING_PLANE_BIT(index))) {
+            continue;
+        }
+
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == -1) {
+            DC_ERROR_RAISE_USER(err, "plane file path is too long", -1);
+            hamming_close_planes(env, err, fds);
+            return -1;
+        }
+
+        fds[index] = dc_open(env, err, path, oflag, mode);
+
+        if (dc_error_has_error(err)) {
+            fds[index] = -1;
+            hamming_close_planes(env, err, fds);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void hamming_close_planes(const struct dc_posix_env *env, struct dc_error *err, int fds[BITS_INC_HAMMING]) {
+    DC_TRACE(env);
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (fds[index] != -1) {
+            dc_dc_close(env, err, fds[index]);
+            fds[index] = -1;
+        }
+    }
+}
+
+ssize_t hamming_read_fully(const struct dc_posix_env *env, struct dc_error *err, int fd, void *buf, size_t size) {
+    size_t total = 0;
+
+    while (total < size) {
+        ssize_t nread = dc_read(env, err, fd, (char *) buf + total, size - total);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+
+        if (nread == 0) {
+            break;
+        }
+
+        total += (size_t) nread;
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, (size_t) nread);
+        hamming_throttle_read((size_t) nread);
+    }
+
+    return (ssize_t) total;
+}
+
+ssize_t hamming_pread_fully(const struct dc_posix_env *env,
+                            struct dc_error *err,
+                            int fd,
+                            void *buf,
+                            size_t size,
+                            uint64_t offset) {
+    size_t total = 0;
+
+    DC_TRACE(env);
+
+    while (total < size) {
+        // dc_posix has no pread
+        ssize_t nread = pread(fd, (char *) buf + total, size - total, (off_t) (offset + total));
+
+        hamming_syscalls_add_call(HAMMING_SYSCALL_READ);
+
+        if (nread == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (nread == -1) {
+            DC_ERROR_RAISE_ERRNO(err, errno);
+            return -1;
+        }
+
+        if (nread == 0) {
+            break;
+        }
+
+        total += (size_t) nread;
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, (size_t) nread);
+        hamming_throttle_read((size_t) nread);
+    }
+
+    return (ssize_t) total;
+}
+
+int hamming_write_fully(const struct dc_posix_env *env, struct dc_error *err, int fd, const void *buf, size_t size) {
+    size_t total = 0;
+
+    while (total < size) {
+        ssize_t nwrote = dc_write(env, err, fd, (const char *) buf + total, size - total);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+
+        total += (size_t) nwrote;
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_WRITE, (size_t) nwrote);
+        hamming_throttle_write((size_t) nwrote);
+    }
+
+    return 0;
+}
+
+int hamming_find_erasures(const char *prefix, unsigned int planes, uint64_t length, unsigned int *erased) {
+    off_t sizes[BITS_INC_HAMMING];
+    off_t expected = 0;
+    char path[PATH_MAX];
+
+    *erased = 0;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        struct stat status;
+
+        sizes[index] = -1;
+
+        if (!(planes & HAMMING_PLANE_BIT(index))) {
+            continue;
+        }
+
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == 0 && stat(path, &status) == 0) {
+            sizes[index] = status.st_size;
+        }
+
+        if (sizes[index] > expected) {
+            expected = sizes[index];
+        }
+    }
+
+    if (length != UINT64_MAX) {
+        expected = (off_t) ((length + BITS_PER_BYTE - 1) / BITS_PER_BYTE);
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if ((planes & HAMMING_PLANE_BIT(index)) && (sizes[index] < expected || sizes[index] == -1)) {
+            *erased |= HAMMING_PLANE_BIT(index);
+        }
+    }
+
+    return planes != 0 && *erased == planes ? -1 : 0;
+}
+
+size_t hamming_direct_chunk_size(size_t chunk_size) {
+    size_t granularity = HAMMING_PLANE_ALIGNMENT * BITS_PER_BYTE;
+
+    return ((chunk_size + granularity - 1) / granularity) * granularity;
+}
+
+ssize_t hamming_read_direct(const struct dc_posix_env *env, struct dc_error *err, int fd, void *buf, size_t size) {
+    size_t aligned = align_up(size);
+    size_t total = 0;
+
+    while (total < aligned) {
+        ssize_t nread = dc_read(env, err, fd, (char *) buf + total, aligned - total);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+
+        total += (size_t) nread;
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, (size_t) nread);
+        hamming_throttle_read((size_t) nread);
+
+        // a partial block is the end of the file, and the offset is no longer aligned
+        if (nread == 0 || (size_t) nread % HAMMING_PLANE_ALIGNMENT != 0) {
+            break;
+        }
+    }
+
+    return (ssize_t) (total < size ? total : size);
+}
+
+int hamming_write_direct(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         int fd,
+                         void *buf,
+                         size_t size,
+                         uint64_t offset) {
+    size_t aligned = align_up(size);
+
+    if (aligned == size) {
+        return hamming_write_fully(env, err, fd, buf, size);
+    }
+
+    memset((char *) buf + size, 0, aligned - size);
+
+    if (hamming_write_fully(env, err, fd, buf, aligned) == -1) {
+        return -1;
+    }
+
+    dc_ftruncate(env, err, fd, (off_t) (offset + size));
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+int hamming_write_sparse(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         int fd,
+                         uint8_t *buf,
+                         size_t size,
+                         uint64_t offset,
+                         bool direct) {
+    size_t start = 0;
+
+    // runs of whole blocks keep a direct write aligned, only the last block can be partial
+    while (start < size) {
+        size_t block = size - start < HAMMING_PLANE_ALIGNMENT ? size - start : HAMMING_PLANE_ALIGNMENT;
+        bool zero = block_is_zero(buf + start, block);
+        size_t end = start + block;
+
+        while (end < size) {
+            block = size - end < HAMMING_PLANE_ALIGNMENT ? size - end : HAMMING_PLANE_ALIGNMENT;
+
+            if (block_is_zero(buf + end, block) != zero) {
+                break;
+            }
+
+            end += block;
+        }
+
+        if (zero) {
+            dc_lseek(env, err, fd, (off_t) (end - start), SEEK_CUR);
+
+            if (dc_error_has_error(err)) {
+                return -1;
+            }
+        } else if (write_run(env, err, fd, buf + start, end - start, offset + start, direct) == -1) {
+            return -1;
+        }
+
+        start = end;
+    }
+
+    return 0;
+}
+
+ssize_t hamming_read_sparse(const struct dc_posix_env *env,
+                            struct dc_error *err,
+                            int fd,
+                            uint8_t *buf,
+                            size_t size,
+                            uint64_t offset,
+                            bool direct) {
+#ifdef SEEK_HOLE
+    uint64_t end = offset + size;
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        off_t data = lseek(fd, (off_t) pos, SEEK_DATA);
+        off_t start;
+        off_t hole;
+        uint64_t stop;
+        ssize_t nread;
+
+        // no data past pos, the rest of the file is a hole
+        if (data == -1 && errno == ENXIO) {
+            struct stat status;
+
+            if (fstat(fd, &status) == -1) {
+                DC_ERROR_RAISE_ERRNO(err, errno);
+                return -1;
+            }
+
+            if ((uint64_t) status.st_size > pos) {
+                stop = (uint64_t) status.st_size < end ? (uint64_t) status.st_size : end;
+                memset(buf + (pos - offset), 0, (size_t) (stop - pos));
+                pos = stop;
+            }
+
+            break;
+        }
+
+        if (data == -1) {
+            DC_ERROR_RAISE_ERRNO(err, errno);
+            return -1;
+        }
+
+        // a direct read starts on a block boundary, so it reads the start of the block the data is in
+        start = direct ? data & ~((off_t) HAMMING_PLANE_ALIGNMENT - 1) : data;
+
+        if ((uint64_t) start > pos) {
+            stop = (uint64_t) start < end ? (uint64_t) start : end;
+            memset(buf + (pos - offset), 0, (size_t) (stop - pos));
+            pos = stop;
+            continue;
+        }
+
+        hole = lseek(fd, data, SEEK_HOLE);
+
+        if (hole == -1) {
+            DC_ERROR_RAISE_ERRNO(err, errno);
+            return -1;
+        }
+
+        if (direct) {
+            hole = (off_t) align_up((size_t) hole);
+        }
+
+        stop = (uint64_t) hole < end ? (uint64_t) hole : end;
+        dc_lseek(env, err, fd, (off_t) pos, SEEK_SET);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+
+        if (direct) {
+            nread = hamming_read_direct(env, err, fd, buf + (pos - offset), (size_t) (stop - pos));
+        } else {
+            nread = hamming_read_fully(env, err, fd, buf + (pos - offset), (size_t) (stop - pos));
+        }
+
+        if (nread == -1) {
+            return -1;
+        }
+
+        // a short read is the end of the file
+        if ((uint64_t) nread < stop - pos) {
+            pos += (uint64_t) nread;
+            break;
+        }
+
+        pos = stop;
+    }
+
+    return (ssize_t) (pos - offset);
+#else
+    (void) offset;
+
+    if (direct) {
+        return hamming_read_direct(env, err, fd, buf, size);
+    }
+
+    return hamming_read_fully(env, err, fd, buf, size);
+#endif
+}
+
+static bool block_is_zero(const uint8_t *block, size_t size) {
+    uint8_t bits = 0;
+
+    for (size_t pos = 0; pos < size; pos++) {
+        bits |= block[pos];
+    }
+
+    return bits == 0;
+}
+
+static int write_run(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     int fd,
+                     uint8_t *buf,
+                     size_t size,
+                     uint64_t offset,
+                     bool direct) {
+    if (direct) {
+        return hamming_write_direct(env, err, fd, buf, size, offset);
+    }
+
+    return hamming_write_fully(env, err, fd, buf, size);
+}
+
+static size_t align_up(size_t size) {
+    return (size + HAMMING_PLANE_ALIGNMENT - 1) & ~(HAMMING_PLANE_ALIGNMENT - 1);
+}
@@ -0,0 +1,218 @@
+#include "hamming_meta.h"
+#include "hamming_codec.h"
+#include "hamming_syscalls.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static int parse_line(const struct dc_posix_env *env, const char *key, const char *value, struct hamming_meta *meta);
+
+void hamming_meta_init(struct hamming_meta *meta) {
+    meta->version = HAMMING_META_VERSION_PLANES;
+    meta->length = 0;
+    meta->parity = HAMMING_META_NO_PARITY;
+    meta->constant = 0;
+    meta->constant_ones = 0;
+    meta->sparse = false;
+}
+
+char *hamming_meta_path(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, size_t *size) {
+    char *path;
+
+    *size = dc_strlen(env, prefix) + sizeof(".meta");
+    path = hamming_malloc(env, err, *size);
+
+    if (path != NULL) {
+        snprintf(path, *size, "%s.meta", prefix);
+    }
+
+    return path;
+}
+
+int hamming_meta_write(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       const char *prefix,
+                       const struct hamming_meta *meta) {
+    char buf[HAMMING_META_MAX_SIZE];
+    char *path;
+    size_t path_size;
+    int written;
+    int fd;
+    int ret_val = -1;
+
+    DC_TRACE(env);
+    written = snprintf(buf, sizeof(buf), "version=%u\nlength=%" PRIu64 "\n",
+                       meta->constant ? HAMMING_META_VERSION : meta->version, meta->length);
+
+    if (written >= 0 && (size_t) written < sizeof(buf) && meta->parity != HAMMING_META_NO_PARITY) {
+        written += snprintf(buf + written, sizeof(buf) - (size_t) written, "parity=%s\n",
+                            meta->parity ? "odd" : "even");
+    }
+
+    if (written >= 0 && (size_t) written < sizeof(buf) && meta->constant) {
+        written += snprintf(buf + written, sizeof(buf) - (size_t) written, "constant=%#x\nconstant_ones=%#x\n",
+                            meta->constant, meta->constant_ones);
+    }
+
+    // holes read back as zeros, so the key is only a hint and older decoders can ignore it
+    if (written >= 0 && (size_t) written < sizeof(buf) && meta->sparse) {
+        written += snprintf(buf + written, sizeof(buf) - (size_t) written, "sparse=1\n");
+    }
+
+    if (written < 0 || (size_t) written >= sizeof(buf)) {
+        DC_ERROR_RAISE_USER(err, "metadata does not fit in the sidecar", -1);
+        return -1;
+    }
+
+    path = hamming_meta_path(env, err, prefix, &path_size);
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    fd = dc_open(env, err, path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_no_error(err)) {
+        if (dc_write(env, err, fd, buf, (size_t) written) == written) {
+            hamming_syscalls_add_bytes(HAMMING_SYSCALL_WRITE, (size_t) written);
+            ret_val = 0;
+        }
+        dc_dc_close(env, err, fd);
+    }
+
+    dc_free(env, path, path_size);
+
+    return dc_error_has_no_error(err) ? ret_val : -1;
+}
+
+int hamming_meta_read(const struct dc_posix_env *env, struct dc_error *err, const char *prefix, struct hamming_meta *meta) {
+    char buf[HAMMING_META_MAX_SIZE];
+    char *path;
+    char *line;
+    size_t path_size;
+    size_t total = 0;
+    ssize_t nread;
+    int fd;
+
+    DC_TRACE(env);
+    hamming_meta_init(meta);
+    meta->version = 0;
+    path = hamming_meta_path(env, err, prefix, &path_size);
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
+    dc_free(env, path, path_size);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    while (total < sizeof(buf) - 1 &&
+           (nread = dc_read(env, err, fd, buf + total, sizeof(buf) - 1 - total)) > 0) {
+        total += (size_t) nread;
+    }
+
+    hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, total);
+    dc_dc_close(env, err, fd);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    buf[total] = '\0';
+    line = buf;
+
+    while (*line != '\0') {
+        char *end = strchr(line, '\n');
+        char *equals;
+
+        if (end != NULL) {
+            *end = '\0';
+        }
+
+        equals = strchr(line, '=');
+
+        if (equals != NULL) {
+            *equals = '\0';
+
+            if (parse_line(env, line, equals + 1, meta) == -1) {
+                DC_ERROR_RAISE_USER(err, "malformed metadata sidecar", -1);
+                return -1;
+            }
+        }
+
+        if (end == NULL) {
+            break;
+        }
+
+        line = end + 1;
+    }
+
+    if (meta->version == 0 || meta->version > HAMMING_META_VERSION) {
+        DC_ERROR_RAISE_USER(err, "unsupported metadata sidecar version", -1);
+        return -1;
+    }
+
+    meta->constant_ones &= meta->constant;
+
+    return 0;
+}
+
+static int parse_line(const struct dc_posix_env *env, const char *key, const char *value, struct hamming_meta *meta) {
+    char *end;
+
+    if (dc_strcmp(env, key, "version") == 0) {
+        unsigned long version = strtoul(value, &end, 10);
+
+        if (*end != '\0' || version > UINT32_MAX) {
+            return -1;
+        }
+
+        meta->version = (unsigned int) version;
+    } else if (dc_strcmp(env, key, "length") == 0) {
+        meta->length = strtoull(value, &end, 10);
+
+        if (*end != '\0') {
+            return -1;
+        }
+    } else if (dc_strcmp(env, key, "constant") == 0 || dc_strcmp(env, key, "constant_ones") == 0) {
+        unsigned long planes = strtoul(value, &end, 0);
+
+        if (*end != '\0' || planes >= (1UL << BITS_INC_HAMMING)) {
+            return -1;
+        }
+
+        if (dc_strcmp(env, key, "constant") == 0) {
+            meta->constant = (unsigned int) planes;
+        } else {
+            meta->constant_ones = (unsigned int) planes;
+        }
+    } else if (dc_strcmp(env, key, "sparse") == 0) {
+        if (dc_strcmp(env, value, "1") == 0) {
+            meta->sparse = true;
+        } else if (dc_strcmp(env, value, "0") == 0) {
+            meta->sparse = false;
+        } else {
+            return -1;
+        }
+    } else if (dc_strcmp(env, key, "parity") == 0) {
+        if (dc_strcmp(env, value, "odd") == 0) {
+            meta->parity = 1;
+        } else if (dc_strcmp(env, value, "even") == 0) {
+            meta->parity = 0;
+        } else {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "hamming_noise.h"
+
+int main(int argc, char *argv[]) {
+    dc_posix_tracer tracer;
+    dc_error_reporter reporter;
+    struct dc_posix_env env;
+    struct dc_error err;
+    struct dc_application_info *info;
+    int ret_val;
+
+    reporter = error_reporter;
+    tracer = trace_reporter;
+    tracer = NULL;
+    dc_error_init(&err, reporter);
+    dc_posix_env_init(&env, tracer);
+    info = dc_application_info_create(&env, &err, "Hamming Channel Noise Application");
+    ret_val = dc_application_run(&env, &err, info, create_settings, destroy_settings, run, dc_default_create_lifecycle,
+                                 dc_default_destroy_lifecycle, NULL, argc, argv);
+    dc_application_info_destroy(&env, &info);
+    dc_error_reset(&err);
+
+    return ret_val;
+}
+
+static struct dc_application_settings *create_settings(const struct dc_posix_env *env, struct dc_error *err) {
+    struct application_settings *settings;
+    struct options opts[7];
+
+    DC_TRACE(env);
+    settings = dc_malloc(env, err, sizeof(struct application_settings));
+
+    if (settings == NULL) {
+        return NULL;
+    }
+
+    settings->opts.parent.config_path = dc_setting_path_create(env, err);
+    settings->prefix = dc_setting_string_create(env, err);
+    settings->mode = dc_setting_string_create(env, err);
+    settings->ber = dc_setting_string_create(env, err);
+    settings->burst_length = dc_setting_string_create(env, err);
+    settings->seed = dc_setting_string_create(env, err);
+    settings->plane_dirs = dc_setting_string_create(env, err);
+
+    opts[0] = (struct options) {(struct dc_setting *) settings->opts.parent.config_path,
+            dc_options_set_path,
+            "config",
+            required_argument,
+            'c',
+            "CONFIG",
+            dc_string_from_string,
+            NULL,
+            dc_string_from_config,
+            NULL};
+    opts[1] = (struct options) {(struct dc_setting *) settings->prefix,
+            dc_options_set_string,
+            "prefix",
+            required_argument,
+            'e',
+            "PREFIX",
+            dc_string_from_string,
+            "prefix",
+            dc_string_from_config,
+            NULL};
+    opts[2] = (struct options) {(struct dc_setting *) settings->mode,
+            dc_options_set_string,
+            "mode",
+            required_argument,
+            'o',
+            "MODE",
+            dc_string_from_string,
+            "mode",
+            dc_string_from_config,
+            "uniform"};
+    opts[3] = (struct options) {(struct dc_setting *) settings->ber,
+            dc_options_set_string,
+            "ber",
+            required_argument,
+            'r',
+            "BER",
+            dc_string_from_string,
+            "ber",
+            dc_string_from_config,
+            "1e-4"};
+    opts[4] = (struct options) {(struct dc_setting *) settings->burst_length,
+            dc_options_set_string,
+            "burst-length",
+            required_argument,
+            'l',
+            "BURST_LENGTH",
+            dc_string_from_string,
+            "burst-length",
+            dc_string_from_config,
+            "16"};
+    opts[5] = (struct options) {(struct dc_setting *) settings->seed,
+            dc_options_set_string,
+            "seed",
+            required_argument,
+            's',
+            "SEED",
+            dc_string_from_string,
+            "seed",
+            dc_string_from_config,
+            "1"};
+    opts[6] = (struct options) {(struct dc_setting *) settings->plane_dirs,
+            dc_options_set_string,
+            "plane-dirs",
+            required_argument,
+            'P',
+            "PLANE_DIRS",
+            dc_string_from_string,
+            "plane-dirs",
+            dc_string_from_config,
+            NULL};
+
+    settings->opts.opts_count = (sizeof(opts) / sizeof(struct options)) + 1;
+    settings->opts.opts_size = sizeof(struct options);
+    settings->opts.opts = dc_calloc(env, err, settings->opts.opts_count, settings->opts.opts_size);
+    dc_memcpy(env, settings->opts.opts, opts, sizeof(opts));
+    settings->opts.flags = "e:o:r:l:s:P:";
+    settings->opts.env_prefix = "ASCII_HAMMING_";
+    return (struct dc_application_settings *) settings;
+}
+
+static int destroy_settings(const struct dc_posix_env *env,
+                            __attribute__((unused)) struct dc_error *err,
+                            struct dc_application_settings **psettings) {
+    struct application_settings *app_settings;
+
+    DC_TRACE(env);
+    app_settings = (struct application_settings *) *psettings;
+    dc_setting_string_destroy(env, &app_settings->prefix);
+    dc_setting_string_destroy(env, &app_settings->mode);
+    dc_setting_string_destroy(env, &app_settings->ber);
+    dc_setting_string_destroy(env, &app_settings->burst_length);
+    dc_setting_string_destroy(env, &app_settings->seed);
+    dc_setting_string_destroy(env, &app_settings->plane_dirs);
+    dc_free(env, app_settings->opts.opts, app_settings->opts.opts_count);
+    dc_free(env, *psettings, sizeof(struct application_settings));
+
+    if (env->null_free) {
+        *psettings = NULL;
+    }
+    return 0;
+}
+
+static int run(const struct dc_posix_env *env, struct dc_error *err, struct dc_application_settings *settings) {
+    struct application_settings *app_settings;
+    const char *prefix;
+    enum hamming_channel_mode mode;
+    struct hamming_channel channel;
+    double ber;
+    size_t burst_length;
+    size_t seed;
+    size_t lost;
+
+    DC_TRACE(env);
+
+    app_settings = (struct application_settings *) settings;
+    prefix = dc_setting_string_get(env, app_settings->prefix);
+
+    if (hamming_channel_parse(env, dc_setting_string_get(env, app_settings->mode), &mode) == -1) {
+        printf("Incorrect mode entered! Either 'uniform', 'burst' or 'plane'\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_rate(dc_setting_string_get(env, app_settings->ber), &ber) == -1) {
+        printf("Incorrect bit error rate entered! Use a number from 0 to 1 such as 0.001 or 1e-4\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_count(dc_setting_string_get(env, app_settings->burst_length), SIZE_MAX, &burst_length) == -1 ||
+        burst_length == 0) {
+        printf("Incorrect burst length entered! Use a number of bits of 1 or more\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_parse_count(dc_setting_string_get(env, app_settings->seed), SIZE_MAX, &seed) == -1) {
+        printf("Incorrect seed entered! Use a decimal number\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (hamming_stripe_set(err, dc_setting_string_get(env, app_settings->plane_dirs)) == -1) {
+        printf("Incorrect plane directories entered! Use 1 to 12 directories separated by commas\n");
+        exit(EXIT_FAILURE);
+    }
+
+    hamming_channel_init(&channel, mode, ber, burst_length, (uint64_t) seed);
+
+    // without a prefix the tool is a filter, damaging a stream on its way through
+    if (prefix == NULL) {
+        if (mode == HAMMING_CHANNEL_PLANE) {
+            printf("A whole plane can only be lost from plane files, use --prefix\n");
+            exit(EXIT_FAILURE);
+        }
+
+        return runStream(env, err, &channel);
+    }
+
+    if (hamming_channel_planes(env, err, prefix, &channel, &lost) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    if (lost != BITS_INC_HAMMING) {
+        fprintf(stderr, "Plane %zu has been removed.\n", lost);
+    } else {
+        fprintf(stderr, "%" PRIu64 " bits have been flipped.\n", channel.flipped);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int runStream(const struct dc_posix_env *env, struct dc_error *err, struct hamming_channel *channel) {
+    uint8_t *buf;
+    ssize_t nread;
+    int ret_val = EXIT_SUCCESS;
+
+    buf = dc_malloc(env, err, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    if (buf == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    while ((nread = hamming_read_fully(env, err, STDIN_FILENO, buf, HAMMING_DEFAULT_CHUNK_SIZE)) > 0) {
+        hamming_channel_apply(channel, buf, (size_t) nread);
+
+        if (hamming_write_fully(env, err, STDOUT_FILENO, buf, (size_t) nread) == -1) {
+            break;
+        }
+    }
+
+    if (dc_error_has_error(err)) {
+        ret_val = EXIT_FAILURE;
+    }
+
+    dc_free(env, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+    fprintf(stderr, "%" PRIu64 " bits have been flipped.\n", channel->flipped);
+
+    return ret_val;
+}
+
+static void error_reporter(const struct dc_error *err) {
+    fprintf(stderr, "ERROR: %s : %s : @ %zu : %d\n", err->file_name, err->function_name, err->line_number, 0);
+    fprintf(stderr, "ERROR: %s\n", err->message);
+}
+
+static void trace_reporter(__attribute__((unused)) const struct dc_posix_env *env,
+                           const char *file_name,
+                           const char *function_name,
+                           size_t line_number) {
+    fprintf(stdout, "TRACE: %s : %s : @ %zu\n", file_name, function_name, line_number);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <dc_application/command_line.h>
+#include <dc_application/config.h>
+#include <dc_application/defaults.h>
+#include <dc_application/environment.h>
+#include <dc_application/options.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_string.h>
+#include <dc_posix/dc_unistd.h>
+#include "hamming_channel.h"
+#include "hamming_io.h"
+#include "hamming_options.h"
+#include "hamming_stripe.h"
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct application_settings {
+    struct dc_opt_settings opts;
+    struct dc_setting_string *prefix;
+    struct dc_setting_string *mode;
+    struct dc_setting_string *ber;
+    struct dc_setting_string *burst_length;
+    struct dc_setting_string *seed;
+    struct dc_setting_string *plane_dirs;
+};
+
+
+static struct dc_application_settings *create_settings(const struct dc_posix_env *env, struct dc_error *err);
+
+static int destroy_settings(const struct dc_posix_env *env,
+                            struct dc_error *err,
+                            struct dc_application_settings **psettings);
+
+static int run(const struct dc_posix_env *env, struct dc_error *err, struct dc_application_settings *settings);
+
+static void error_reporter(const struct dc_error *err);
+
+static void trace_reporter(const struct dc_posix_env *env,
+                           const char *file_name,
+                           const char *function_name,
+                           size_t line_number);
+
+/**
+ * Sends standard input through the channel to standard output.
+ * @param env Current working environment
+ * @param err Error tracking
+ * @param channel the channel
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE otherwise
+ */
+static int runStream(const struct dc_posix_env *env, struct dc_error *err, struct hamming_channel *channel);
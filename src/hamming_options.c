@@ -0,0 +1,142 @@
+#include "hamming_options.h"
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int hamming_parse_size(const char *str, size_t *value) {
+    uintmax_t number;
+    unsigned int shift = 0;
+    char *end;
+
+    if (str == NULL || !isdigit((unsigned char) *str)) {
+        return -1;
+    }
+
+    errno = 0;
+    number = strtoumax(str, &end, 10);
+
+    if (errno != 0) {
+        return -1;
+    }
+
+    switch (*end) {
+        case 'k':
+        case 'K':
+            shift = 10;
+            end++;
+            break;
+        case 'm':
+        case 'M':
+            shift = 20;
+            end++;
+            break;
+        case 'g':
+        case 'G':
+            shift = 30;
+            end++;
+            break;
+        default:
+            break;
+    }
+
+    if (*end != '\0' || number > (SIZE_MAX >> shift)) {
+        return -1;
+    }
+
+    *value = (size_t) number << shift;
+
+    return 0;
+}
+
+int hamming_parse_count(const char *str, size_t max, size_t *value) {
+    uintmax_t number;
+    char *end;
+
+    if (str == NULL || !isdigit((unsigned char) *str)) {
+        return -1;
+    }
+
+    errno = 0;
+    number = strtoumax(str, &end, 10);
+
+    if (errno != 0 || *end != '\0' || number > max) {
+        return -1;
+    }
+
+    *value = (size_t) number;
+
+    return 0;
+}
+
+int hamming_parse_rate(const char *str, double *value) {
+    double number;
+    char *end;
+
+    if (str == NULL || (!isdigit((unsigned char) *str) && *str != '.')) {
+        return -1;
+    }
+
+    errno = 0;
+    number = strtod(str, &end);
+
+    if (errno != 0 || *end != '\0' || !(number >= 0.0 && number <= 1.0)) {
+        return -1;
+    }
+
+    *value = number;
+
+    return 0;
+}
+
+int hamming_parse_limit(const char *str, double *value) {
+    double number;
+    char *end;
+
+    if (str == NULL || (!isdigit((unsigned char) *str) && *str != '.')) {
+        return -1;
+    }
+
+    errno = 0;
+    number = strtod(str, &end);
+
+    if (errno != 0 || *end != '\0') {
+        return -1;
+    }
+
+    *value = number;
+
+    return 0;
+}
+
+int hamming_parse_stores(const char *str, enum hamming_store_kernel *kernel) {
+    if (str == NULL) {
+        return -1;
+    }
+
+    if (strcmp(str, "auto") == 0) {
+        *kernel = HAMMING_STORES_AUTO;
+    } else if (strcmp(str, "cached") == 0) {
+        *kernel = HAMMING_STORES_CACHED;
+    } else if (strcmp(str, "streaming") == 0) {
+        *kernel = HAMMING_STORES_STREAMING;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+const char *hamming_stores_name(enum hamming_store_kernel kernel) {
+    switch (kernel) {
+        case HAMMING_STORES_CACHED:
+            return "cached";
+        case HAMMING_STORES_STREAMING:
+            return "streaming";
+        case HAMMING_STORES_AUTO:
+        default:
+            return "auto";
+    }
+}
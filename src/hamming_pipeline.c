@@ -0,0 +1,302 @@
+#include "hamming_pipeline.h"
+#include "hamming_ring.h"
+#include "hamming_trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+struct pipeline {
+    const struct dc_posix_env *env;
+    const struct hamming_pipeline_config *config;
+    size_t workers;
+    struct hamming_ring free_chunks; // writer to reader
+    struct hamming_ring *to_workers; // reader to each worker
+    struct hamming_ring *to_writer;  // each worker to writer
+    atomic_bool failed;
+};
+
+struct stage_thread {
+    struct pipeline *pipeline;
+    size_t index;
+    struct dc_error err;
+    pthread_t thread;
+    bool started;
+};
+
+static size_t chunk_count(const struct hamming_pipeline_config *config);
+
+static int run_sequential(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          const struct hamming_pipeline_config *config);
+
+static int run_stage(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const char *name,
+                     hamming_stage stage,
+                     struct hamming_chunk *chunk,
+                     void *arg);
+
+static void *reader_main(void *arg);
+
+static void *worker_main(void *arg);
+
+static int writer_main(struct pipeline *pipeline, struct dc_error *err);
+
+size_t hamming_pipeline_arena_size(const struct hamming_pipeline_config *config) {
+    size_t chunks = chunk_count(config);
+    size_t workers = config->workers;
+
+    if (workers == 0) {
+        return hamming_arena_align(sizeof(struct hamming_chunk)) + hamming_buffers_arena_size(config->chunk_size);
+    }
+
+    return hamming_arena_align(chunks * sizeof(struct hamming_chunk)) +
+           chunks * hamming_buffers_arena_size(config->chunk_size) +
+           hamming_arena_align(2 * workers * sizeof(struct hamming_ring)) +
+           (2 * workers + 1) * hamming_ring_arena_size(chunks + 1) +
+           hamming_arena_align((workers + 1) * sizeof(struct stage_thread));
+}
+
+int hamming_pipeline_run(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         const struct hamming_pipeline_config *config) {
+    struct pipeline pipeline;
+    struct hamming_chunk *chunks;
+    struct stage_thread *threads;
+    size_t count = chunk_count(config);
+    int ret_val;
+
+    DC_TRACE(env);
+
+    if (config->workers == 0) {
+        return run_sequential(env, err, arena, config);
+    }
+
+    if (config->workers > HAMMING_PIPELINE_MAX_WORKERS) {
+        DC_ERROR_RAISE_USER(err, "too many pipeline workers", -1);
+        return -1;
+    }
+
+    pipeline.env = env;
+    pipeline.config = config;
+    pipeline.workers = config->workers;
+    atomic_init(&pipeline.failed, false);
+    chunks = hamming_arena_alloc(arena, count * sizeof(struct hamming_chunk));
+    pipeline.to_workers = hamming_arena_alloc(arena, 2 * config->workers * sizeof(struct hamming_ring));
+    threads = hamming_arena_alloc(arena, (config->workers + 1) * sizeof(struct stage_thread));
+
+    if (chunks == NULL || pipeline.to_workers == NULL || threads == NULL ||
+        hamming_ring_init(&pipeline.free_chunks, arena, count + 1) == -1) {
+        DC_ERROR_RAISE_USER(err, "pipeline arena is too small", -1);
+        return -1;
+    }
+
+    pipeline.to_writer = pipeline.to_workers + config->workers;
+
+    for (size_t i = 0; i < 2 * config->workers; i++) {
+        if (hamming_ring_init(&pipeline.to_workers[i], arena, count + 1) == -1) {
+            DC_ERROR_RAISE_USER(err, "pipeline arena is too small", -1);
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (hamming_buffers_init(arena, &chunks[i].buffers, config->chunk_size) == -1) {
+            DC_ERROR_RAISE_USER(err, "pipeline arena is too small", -1);
+            return -1;
+        }
+
+        hamming_ring_try_push(&pipeline.free_chunks, &chunks[i]);
+    }
+
+    // threads[0] is the reader, the rest are the workers
+    for (size_t i = 0; i <= config->workers; i++) {
+        int result;
+
+        threads[i].pipeline = &pipeline;
+        threads[i].index = i - 1;
+        threads[i].started = false;
+        dc_error_init(&threads[i].err, NULL);
+        result = pthread_create(&threads[i].thread, NULL, i == 0 ? reader_main : worker_main, &threads[i]);
+
+        if (result != 0) {
+            DC_ERROR_RAISE_ERRNO(err, result);
+            atomic_store(&pipeline.failed, true);
+            break;
+        }
+
+        threads[i].started = true;
+    }
+
+    ret_val = dc_error_has_no_error(err) ? writer_main(&pipeline, err) : -1;
+
+    for (size_t i = 0; i <= config->workers; i++) {
+        if (threads[i].started) {
+            pthread_join(threads[i].thread, NULL);
+        }
+
+        if (dc_error_has_error(&threads[i].err)) {
+            if (dc_error_has_no_error(err)) {
+                DC_ERROR_RAISE_USER(err, threads[i].err.message, -1);
+            }
+
+            ret_val = -1;
+        }
+
+        dc_error_reset(&threads[i].err);
+    }
+
+    if (atomic_load(&pipeline.failed)) {
+        ret_val = -1;
+    }
+
+    return ret_val;
+}
+
+static size_t chunk_count(const struct hamming_pipeline_config *config) {
+    size_t depth = config->depth > 0 ? config->depth : HAMMING_PIPELINE_DEFAULT_DEPTH;
+
+    return config->workers > 0 ? config->workers * depth : 1;
+}
+
+static int run_sequential(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          const struct hamming_pipeline_config *config) {
+    struct hamming_chunk *chunk = hamming_arena_alloc(arena, sizeof(struct hamming_chunk));
+
+    if (chunk == NULL || hamming_buffers_init(arena, &chunk->buffers, config->chunk_size) == -1) {
+        DC_ERROR_RAISE_USER(err, "pipeline arena is too small", -1);
+        return -1;
+    }
+
+    chunk->sequence = 0;
+    chunk->final = false;
+
+    while (!chunk->final) {
+        chunk->count = 0;
+
+        if (run_stage(env, err, "read", config->read, chunk, config->arg) == -1 ||
+            run_stage(env, err, config->work_name, config->work, chunk, config->arg) == -1 ||
+            run_stage(env, err, "write", config->write, chunk, config->arg) == -1) {
+            return -1;
+        }
+
+        chunk->sequence++;
+    }
+
+    return 0;
+}
+
+static int run_stage(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     const char *name,
+                     hamming_stage stage,
+                     struct hamming_chunk *chunk,
+                     void *arg) {
+    int ret_val;
+
+    hamming_trace_begin(name == NULL ? "work" : name, chunk->sequence, HAMMING_TRACE_NO_PLANE);
+    ret_val = stage(env, err, chunk, arg);
+    hamming_trace_end();
+
+    return ret_val;
+}
+
+static void *reader_main(void *arg) {
+    struct stage_thread *self = arg;
+    struct pipeline *pipeline = self->pipeline;
+    const struct hamming_pipeline_config *config = pipeline->config;
+    uint64_t sequence = 0;
+    bool final = false;
+
+    hamming_trace_thread("reader");
+
+    while (!final) {
+        struct hamming_chunk *chunk;
+        void *item;
+
+        if (!hamming_ring_pop(&pipeline->free_chunks, &item, &pipeline->failed)) {
+            break;
+        }
+
+        chunk = item;
+        chunk->sequence = sequence;
+        chunk->count = 0;
+        chunk->final = false;
+
+        if (run_stage(pipeline->env, &self->err, "read", config->read, chunk, config->arg) == -1) {
+            atomic_store(&pipeline->failed, true);
+            break;
+        }
+
+        final = chunk->final;
+
+        // chunk n always goes to worker n % workers so the writer can restore the order
+        if (!hamming_ring_push(&pipeline->to_workers[sequence % pipeline->workers], chunk, &pipeline->failed)) {
+            break;
+        }
+
+        sequence++;
+    }
+
+    for (size_t i = 0; i < pipeline->workers; i++) {
+        hamming_ring_push(&pipeline->to_workers[i], NULL, &pipeline->failed);
+    }
+
+    return NULL;
+}
+
+static void *worker_main(void *arg) {
+    struct stage_thread *self = arg;
+    struct pipeline *pipeline = self->pipeline;
+    const struct hamming_pipeline_config *config = pipeline->config;
+    char name[HAMMING_TRACE_NAME_SIZE];
+    void *item;
+
+    snprintf(name, sizeof(name), "worker %zu", self->index);
+    hamming_trace_thread(name);
+
+    while (hamming_ring_pop(&pipeline->to_workers[self->index], &item, &pipeline->failed) && item != NULL) {
+        if (run_stage(pipeline->env, &self->err, config->work_name, config->work, item, config->arg) == -1) {
+            atomic_store(&pipeline->failed, true);
+            break;
+        }
+
+        if (!hamming_ring_push(&pipeline->to_writer[self->index], item, &pipeline->failed)) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static int writer_main(struct pipeline *pipeline, struct dc_error *err) {
+    const struct hamming_pipeline_config *config = pipeline->config;
+    uint64_t sequence = 0;
+    bool final = false;
+
+    while (!final) {
+        struct hamming_chunk *chunk;
+        void *item;
+
+        if (!hamming_ring_pop(&pipeline->to_writer[sequence % pipeline->workers], &item, &pipeline->failed)) {
+            return -1;
+        }
+
+        chunk = item;
+
+        if (run_stage(pipeline->env, err, "write", config->write, chunk, config->arg) == -1) {
+            atomic_store(&pipeline->failed, true);
+            return -1;
+        }
+
+        final = chunk->final;
+        hamming_ring_push(&pipeline->free_chunks, chunk, &pipeline->failed);
+        sequence++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "hamming_pool.h"
+#include "hamming_arena.h"
+#include "hamming_trace.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/**
+ * The tasks of one worker. The owner takes from the bottom and thieves take from the top,
+ * nothing is ever added once the pool is running.
+ */
+struct deque {
+    _Alignas(HAMMING_ARENA_ALIGNMENT) atomic_long top;    // next task a thief takes
+    _Alignas(HAMMING_ARENA_ALIGNMENT) atomic_long bottom; // one past the next task the owner takes
+    _Alignas(HAMMING_ARENA_ALIGNMENT) size_t *tasks;
+};
+
+struct pool {
+    const struct dc_posix_env *env;
+    size_t workers;
+    struct deque *deques;
+    hamming_task task;
+    void *arg;
+};
+
+struct pool_worker {
+    struct pool *pool;
+    size_t index;
+    pthread_t thread;
+};
+
+enum steal_result {
+    STEAL_EMPTY,
+    STEAL_RETRY,
+    STEAL_TAKEN
+};
+
+static bool take(struct deque *deque, size_t *task);
+
+static enum steal_result steal(struct deque *deque, size_t *task);
+
+static void *worker_main(void *arg);
+
+static void work(struct pool *pool, size_t index);
+
+size_t hamming_pool_default_workers(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return online > 0 ? (size_t) online : 1;
+}
+
+int hamming_pool_run(const struct dc_posix_env *env,
+                     struct dc_error *err,
+                     size_t workers,
+                     size_t tasks,
+                     hamming_task task,
+                     void *arg) {
+    struct hamming_arena arena;
+    struct pool pool;
+    struct pool_worker *threads;
+    size_t *assigned;
+    size_t started = 0;
+
+    DC_TRACE(env);
+
+    if (workers == 0 || workers > HAMMING_POOL_MAX_WORKERS) {
+        DC_ERROR_RAISE_USER(err, "invalid number of pool workers", -1);
+        return -1;
+    }
+
+    if (workers > tasks) {
+        workers = tasks > 0 ? tasks : 1;
+    }
+
+    if (hamming_arena_init(env, err, &arena,
+                           hamming_arena_align(workers * sizeof(struct deque)) +
+                           hamming_arena_align(workers * sizeof(struct pool_worker)) +
+                           hamming_arena_align(tasks * sizeof(size_t)), 0) == -1) {
+        return -1;
+    }
+
+    pool.env = env;
+    pool.workers = workers;
+    pool.task = task;
+    pool.arg = arg;
+    pool.deques = hamming_arena_alloc(&arena, workers * sizeof(struct deque));
+    threads = hamming_arena_alloc(&arena, workers * sizeof(struct pool_worker));
+    assigned = hamming_arena_alloc(&arena, tasks * sizeof(size_t));
+
+    // deal the tasks round robin so neighbouring tasks of similar size are spread out
+    for (size_t i = 0; i < workers; i++) {
+        size_t count = 0;
+
+        pool.deques[i].tasks = assigned;
+
+        for (size_t t = i; t < tasks; t += workers) {
+            assigned[count++] = t;
+        }
+
+        // the owner takes from the bottom, so reverse to run its tasks in input order
+        for (size_t j = 0; j < count / 2; j++) {
+            size_t swap = assigned[j];
+
+            assigned[j] = assigned[count - 1 - j];
+            assigned[count - 1 - j] = swap;
+        }
+
+        atomic_init(&pool.deques[i].top, 0);
+        atomic_init(&pool.deques[i].bottom, (long) count);
+        assigned += count;
+    }
+
+    for (size_t i = 1; i < workers; i++) {
+        int result;
+
+        threads[i].pool = &pool;
+        threads[i].index = i;
+        result = pthread_create(&threads[i].thread, NULL, worker_main, &threads[i]);
+
+        // the tasks of a worker that did not start are stolen by the others
+        if (result != 0) {
+            break;
+        }
+
+        started = i;
+    }
+
+    work(&pool, 0);
+
+    for (size_t i = 1; i <= started; i++) {
+        pthread_join(threads[i].thread, NULL);
+    }
+
+    hamming_arena_destroy(env, &arena);
+
+    return 0;
+}
+
+static void *worker_main(void *arg) {
+    struct pool_worker *self = arg;
+    char name[HAMMING_TRACE_NAME_SIZE];
+
+    snprintf(name, sizeof(name), "batch worker %zu", self->index);
+    hamming_trace_thread(name);
+    work(self->pool, self->index);
+
+    return NULL;
+}
+
+static void work(struct pool *pool, size_t index) {
+    struct dc_error err;
+    size_t task;
+
+    dc_error_init(&err, NULL);
+
+    for (;;) {
+        bool found = take(&pool->deques[index], &task);
+
+        while (!found) {
+            bool retry = false;
+
+            for (size_t i = 1; i < pool->workers && !found; i++) {
+                switch (steal(&pool->deques[(index + i) % pool->workers], &task)) {
+                    case STEAL_TAKEN:
+                        found = true;
+                        break;
+                    case STEAL_RETRY:
+                        retry = true;
+                        break;
+                    case STEAL_EMPTY:
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            // nothing is added once the pool runs, so every deque being empty means done
+            if (!found && !retry) {
+                dc_error_reset(&err);
+                return;
+            }
+        }
+
+        pool->task(pool->env, &err, index, task, pool->arg);
+        dc_error_reset(&err);
+    }
+}
+
+static bool take(struct deque *deque, size_t *task) {
+    long bottom = atomic_load(&deque->bottom) - 1;
+    long top;
+
+    atomic_store(&deque->bottom, bottom);
+    top = atomic_load(&deque->top);
+
+    if (top > bottom) {
+        atomic_store(&deque->bottom, bottom + 1);
+        return false;
+    }
+
+    *task = deque->tasks[bottom];
+
+    if (top == bottom) {
+        // the last task, race the thieves for it
+        bool won = atomic_compare_exchange_strong(&deque->top, &top, top + 1);
+
+        atomic_store(&deque->bottom, bottom + 1);
+
+        return won;
+    }
+
+    return true;
+}
+
+static enum steal_result steal(struct deque *deque, size_t *task) {
+    long top = atomic_load(&deque->top);
+    long bottom = atomic_load(&deque->bottom);
+
+    if (top >= bottom) {
+        return STEAL_EMPTY;
+    }
+
+    *task = deque->tasks[top];
+
+    if (!atomic_compare_exchange_strong(&deque->top, &top, top + 1)) {
+        return STEAL_RETRY;
+    }
+
+    return STEAL_TAKEN;
+}
@@ -0,0 +1,221 @@
+#include "hamming_push.h"
+#include <ctype.h>
+#include <string.h>
+
+/**
+ * Where a push can be. Every state but the decode one can run out of input and stop, and
+ * the next push starts again from DC_FSM_INIT into the state that stopped.
+ */
+enum push_state {
+    STATE_STREAM_HEADER = DC_FSM_USER_START,
+    STATE_FRAME_HEADER,
+    STATE_SLICES,
+    STATE_DECODE,
+    STATE_END,
+    STATE_FAILED
+};
+
+static int read_stream_header(const struct dc_posix_env *env, struct dc_error *err, void *arg);
+
+static int read_frame_header(const struct dc_posix_env *env, struct dc_error *err, void *arg);
+
+static int read_slices(const struct dc_posix_env *env, struct dc_error *err, void *arg);
+
+static int decode_frame(const struct dc_posix_env *env, struct dc_error *err, void *arg);
+
+static int end_stream(const struct dc_posix_env *env, struct dc_error *err, void *arg);
+
+static bool gather(struct hamming_push_decoder *decoder, uint8_t *buf, size_t size);
+
+static int suspend(struct hamming_push_decoder *decoder, int state, enum hamming_push_status status);
+
+static const struct dc_fsm_transition transitions[] = {
+        {DC_FSM_INIT, STATE_STREAM_HEADER, read_stream_header},
+        {DC_FSM_INIT, STATE_FRAME_HEADER, read_frame_header},
+        {DC_FSM_INIT, STATE_SLICES, read_slices},
+        {DC_FSM_INIT, STATE_END, end_stream},
+        {STATE_STREAM_HEADER, STATE_FRAME_HEADER, read_frame_header},
+        {STATE_FRAME_HEADER, STATE_SLICES, read_slices},
+        {STATE_FRAME_HEADER, STATE_END, end_stream},
+        {STATE_SLICES, STATE_DECODE, decode_frame},
+        {DC_FSM_IGNORE, DC_FSM_IGNORE, NULL},
+};
+
+int hamming_push_decoder_init(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              struct hamming_push_decoder *decoder,
+                              const struct hamming_decode_options *options) {
+    DC_TRACE(env);
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->state = STATE_STREAM_HEADER;
+    decoder->binary = options->binary;
+    decoder->verify = options->verify;
+    decoder->fsm = dc_fsm_info_create(env, err, "hamming_push");
+
+    return decoder->fsm == NULL ? -1 : 0;
+}
+
+void hamming_push_decoder_destroy(const struct dc_posix_env *env, struct hamming_push_decoder *decoder) {
+    DC_TRACE(env);
+
+    if (decoder->fsm != NULL) {
+        dc_fsm_info_destroy(env, &decoder->fsm);
+    }
+
+    if (decoder->arena.base != NULL) {
+        hamming_arena_destroy(env, &decoder->arena);
+    }
+}
+
+int hamming_push(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 struct hamming_push_decoder *decoder,
+                 const uint8_t *input,
+                 size_t size,
+                 size_t *consumed,
+                 const uint8_t **output,
+                 size_t *length) {
+    int from_state = DC_FSM_INIT;
+    int to_state = decoder->state;
+
+    *consumed = 0;
+    *output = NULL;
+    *length = 0;
+
+    if (decoder->state == STATE_FAILED) {
+        DC_ERROR_RAISE_USER(err, "stream decoder has already failed", -1);
+        return -1;
+    }
+
+    decoder->input = input;
+    decoder->input_size = size;
+    decoder->consumed = 0;
+    decoder->length = 0;
+    dc_fsm_run(env, err, decoder->fsm, &from_state, &to_state, decoder, transitions);
+    *consumed = decoder->consumed;
+
+    if (dc_error_has_error(err) || decoder->state == STATE_FAILED) {
+        decoder->state = STATE_FAILED;
+        return -1;
+    }
+
+    if (decoder->status == HAMMING_PUSH_OUTPUT) {
+        *output = decoder->buffers.chars;
+        *length = decoder->length;
+    }
+
+    return (int) decoder->status;
+}
+
+static int read_stream_header(const struct dc_posix_env *env, struct dc_error *err, void *arg) {
+    struct hamming_push_decoder *decoder = arg;
+
+    if (!gather(decoder, decoder->header, HAMMING_STREAM_HEADER_SIZE)) {
+        return suspend(decoder, STATE_STREAM_HEADER, HAMMING_PUSH_MORE);
+    }
+
+    // the frame buffers are allocated once the stream says how large its frames are
+    if (hamming_stream_header_parse(err, decoder->header, &decoder->frame_size, &decoder->parity) == -1 ||
+        hamming_arena_reserve(env, err, &decoder->arena, hamming_buffers_arena_size(decoder->frame_size), 0) == -1 ||
+        hamming_buffers_init(&decoder->arena, &decoder->buffers, decoder->frame_size) == -1) {
+        return suspend(decoder, STATE_FAILED, HAMMING_PUSH_MORE);
+    }
+
+    decoder->have = 0;
+
+    return STATE_FRAME_HEADER;
+}
+
+static int read_frame_header(__attribute__((unused)) const struct dc_posix_env *env, struct dc_error *err, void *arg) {
+    struct hamming_push_decoder *decoder = arg;
+
+    if (!gather(decoder, decoder->header, HAMMING_FRAME_HEADER_SIZE)) {
+        return suspend(decoder, STATE_FRAME_HEADER, HAMMING_PUSH_MORE);
+    }
+
+    if (hamming_frame_header_parse(err, decoder->header, decoder->sequence, decoder->frame_size, decoder->parity,
+                                   &decoder->count) == -1) {
+        return suspend(decoder, STATE_FAILED, HAMMING_PUSH_MORE);
+    }
+
+    decoder->sequence++;
+    decoder->plane = 0;
+    decoder->have = 0;
+
+    return decoder->count == 0 ? STATE_END : STATE_SLICES;
+}
+
+static int read_slices(__attribute__((unused)) const struct dc_posix_env *env,
+                       __attribute__((unused)) struct dc_error *err,
+                       void *arg) {
+    struct hamming_push_decoder *decoder = arg;
+    size_t nbyte = (decoder->count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    // a slice can be split across any number of pushes
+    for (; decoder->plane < BITS_INC_HAMMING; decoder->plane++) {
+        if (!gather(decoder, decoder->buffers.planes[decoder->plane], nbyte)) {
+            return suspend(decoder, STATE_SLICES, HAMMING_PUSH_MORE);
+        }
+
+        decoder->have = 0;
+    }
+
+    return STATE_DECODE;
+}
+
+static int decode_frame(__attribute__((unused)) const struct dc_posix_env *env,
+                        __attribute__((unused)) struct dc_error *err,
+                        void *arg) {
+    struct hamming_push_decoder *decoder = arg;
+    uint8_t *chars = decoder->buffers.chars;
+    size_t length = decoder->count;
+
+    if (decoder->verify) {
+        hamming_decode_chunk(&decoder->buffers, decoder->count, decoder->parity, &decoder->stats);
+    } else {
+        hamming_extract_chunk(&decoder->buffers, decoder->count, &decoder->stats);
+    }
+
+    if (!decoder->binary) {
+        length = 0;
+
+        for (size_t i = 0; i < decoder->count; i++) {
+            if (isprint(chars[i])) {
+                chars[length++] = chars[i];
+            }
+        }
+    }
+
+    decoder->length = length;
+
+    // the caller takes the frame before anything more is gathered into the buffers
+    return suspend(decoder, STATE_FRAME_HEADER, HAMMING_PUSH_OUTPUT);
+}
+
+static int end_stream(__attribute__((unused)) const struct dc_posix_env *env,
+                      __attribute__((unused)) struct dc_error *err,
+                      void *arg) {
+    return suspend(arg, STATE_END, HAMMING_PUSH_END);
+}
+
+static bool gather(struct hamming_push_decoder *decoder, uint8_t *buf, size_t size) {
+    size_t available = decoder->input_size - decoder->consumed;
+    size_t needed = size - decoder->have;
+    size_t taken = available < needed ? available : needed;
+
+    if (taken > 0) {
+        memcpy(buf + decoder->have, decoder->input + decoder->consumed, taken);
+    }
+
+    decoder->have += taken;
+    decoder->consumed += taken;
+
+    return decoder->have == size;
+}
+
+static int suspend(struct hamming_push_decoder *decoder, int state, enum hamming_push_status status) {
+    decoder->state = state;
+    decoder->status = status;
+
+    return DC_FSM_EXIT;
+}
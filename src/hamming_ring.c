@@ -0,0 +1,103 @@
+#include "hamming_ring.h"
+#include <sched.h>
+
+/**
+ * Number of times a waiting thread polls before giving up its time slice.
+ */
+#define HAMMING_RING_SPINS 64
+
+static void backoff(unsigned int *spins);
+
+size_t hamming_ring_arena_size(size_t capacity) {
+    size_t slots = 1;
+
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    return hamming_arena_align(slots * sizeof(void *));
+}
+
+int hamming_ring_init(struct hamming_ring *ring, struct hamming_arena *arena, size_t capacity) {
+    size_t slots = 1;
+
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    ring->slots = hamming_arena_alloc(arena, slots * sizeof(void *));
+
+    if (ring->slots == NULL) {
+        return -1;
+    }
+
+    ring->mask = slots - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    return 0;
+}
+
+bool hamming_ring_try_push(struct hamming_ring *ring, void *item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head > ring->mask) {
+        return false;
+    }
+
+    ring->slots[tail & ring->mask] = item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+bool hamming_ring_try_pop(struct hamming_ring *ring, void **item) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+
+    *item = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool hamming_ring_push(struct hamming_ring *ring, void *item, const atomic_bool *cancel) {
+    unsigned int spins = 0;
+
+    while (!hamming_ring_try_push(ring, item)) {
+        if (atomic_load_explicit(cancel, memory_order_relaxed)) {
+            return false;
+        }
+
+        backoff(&spins);
+    }
+
+    return true;
+}
+
+bool hamming_ring_pop(struct hamming_ring *ring, void **item, const atomic_bool *cancel) {
+    unsigned int spins = 0;
+
+    while (!hamming_ring_try_pop(ring, item)) {
+        if (atomic_load_explicit(cancel, memory_order_relaxed)) {
+            return false;
+        }
+
+        backoff(&spins);
+    }
+
+    return true;
+}
+
+static void backoff(unsigned int *spins) {
+    if (*spins < HAMMING_RING_SPINS) {
+        (*spins)++;
+    } else {
+        sched_yield();
+    }
+}
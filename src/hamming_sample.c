@@ -0,0 +1,429 @@
+#include "hamming_sample.h"
+#include "hamming_channel.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Characters in a sampled block.
+ */
+#define BLOCK_CHARS (HAMMING_SAMPLE_BLOCK_SIZE * BITS_PER_BYTE)
+
+/**
+ * The plane files of a plane set being sampled and the buffers its blocks are read into.
+ * Constant planes have no file, their slice of every block is filled in once.
+ */
+struct block_reader {
+    int fds[BITS_INC_HAMMING];
+    uint64_t length;
+    uint64_t total_blocks;
+    struct hamming_buffers buffers[2];
+};
+
+/**
+ * Sums over the sampled blocks of one kind of error, e the errors and n the characters of
+ * a block, which is all the interval needs.
+ */
+struct error_sums {
+    double e;
+    double ee;
+    double en;
+};
+
+static int read_sidecar(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        bool *has_sidecar,
+                        struct hamming_meta *meta);
+
+static bool plane_set_empty(const char *prefix, bool has_sidecar, const struct hamming_meta *meta);
+
+static int plane_set_size(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          const char *prefix,
+                          uint64_t *length,
+                          unsigned int *constant,
+                          unsigned int *constant_ones);
+
+static int open_reader(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       const char *prefix,
+                       size_t copies,
+                       struct block_reader *reader);
+
+static int read_block(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct block_reader *reader,
+                      uint64_t block,
+                      size_t *count);
+
+static void add_block(struct error_sums *sums, uint64_t errors, uint64_t characters);
+
+static void estimate(const struct error_sums *sums,
+                     double nn,
+                     const struct hamming_sample_report *report,
+                     struct hamming_sample_estimate *estimate);
+
+static void wilson(double errors, double characters, struct hamming_sample_estimate *estimate);
+
+int hamming_sample(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct hamming_arena *arena,
+                   const char *prefix,
+                   int parity,
+                   double rate,
+                   uint64_t seed,
+                   struct hamming_sample_report *report) {
+    struct hamming_channel rng;
+    struct block_reader reader;
+    struct error_sums corrected = {0};
+    struct error_sums uncorrectable = {0};
+    double nn = 0;
+    uint64_t wanted;
+
+    DC_TRACE(env);
+    memset(report, 0, sizeof(*report));
+
+    if (open_reader(env, err, arena, prefix, 1, &reader) == -1) {
+        return -1;
+    }
+
+    report->total_blocks = reader.total_blocks;
+    wanted = (uint64_t) (rate * (double) report->total_blocks);
+    wanted = wanted == 0 ? 1 : wanted;
+    wanted = wanted > report->total_blocks ? report->total_blocks : wanted;
+
+    // selection sampling: each block is taken with the chance that leaves exactly wanted, in order
+    hamming_channel_init(&rng, HAMMING_CHANNEL_UNIFORM, 0.0, 0, seed);
+
+    for (uint64_t block = 0; block < report->total_blocks && report->blocks < wanted; block++) {
+        struct hamming_decode_stats stats = {0};
+        double draw = (double) (hamming_channel_random(&rng) >> 11) / (double) (UINT64_C(1) << 53);
+        size_t count;
+
+        if (draw * (double) (report->total_blocks - block) >= (double) (wanted - report->blocks)) {
+            continue;
+        }
+
+        if (read_block(env, err, &reader, block, &count) == -1) {
+            hamming_close_planes(env, err, reader.fds);
+            return -1;
+        }
+
+        hamming_correct_planes(reader.buffers[0].planes, count, parity, &stats);
+        report->blocks++;
+        report->characters += count;
+        report->corrected += stats.corrected;
+        report->uncorrectable += stats.uncorrectable;
+        add_block(&corrected, stats.corrected, count);
+        add_block(&uncorrectable, stats.uncorrectable, count);
+        nn += (double) count * (double) count;
+    }
+
+    hamming_close_planes(env, err, reader.fds);
+    estimate(&corrected, nn, report, &report->corrected_rate);
+    estimate(&uncorrectable, nn, report, &report->uncorrectable_rate);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+int hamming_sample_parity(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          const char *prefix,
+                          struct hamming_parity_guess *guess) {
+    struct block_reader reader;
+    uint64_t blocks;
+
+    DC_TRACE(env);
+    memset(guess, 0, sizeof(*guess));
+
+    if (open_reader(env, err, arena, prefix, 2, &reader) == -1) {
+        return -1;
+    }
+
+    blocks = reader.total_blocks < HAMMING_SAMPLE_PARITY_BLOCKS ? reader.total_blocks : HAMMING_SAMPLE_PARITY_BLOCKS;
+
+    // spread over the plane set, one damaged region cannot decide alone
+    for (uint64_t i = 0; i < blocks; i++) {
+        struct hamming_decode_stats stats[2] = {{0}, {0}};
+        size_t count;
+
+        if (read_block(env, err, &reader, i * reader.total_blocks / blocks, &count) == -1) {
+            hamming_close_planes(env, err, reader.fds);
+            return -1;
+        }
+
+        // correcting changes the planes, so each parity checks its own copy
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            memcpy(reader.buffers[1].planes[index], reader.buffers[0].planes[index], HAMMING_SAMPLE_BLOCK_SIZE);
+        }
+
+        hamming_correct_planes(reader.buffers[0].planes, count, 0, &stats[0]);
+        hamming_correct_planes(reader.buffers[1].planes, count, 1, &stats[1]);
+        guess->characters += count;
+
+        for (size_t parity = 0; parity < 2; parity++) {
+            guess->flagged[parity] += stats[parity].corrected + stats[parity].uncorrectable;
+        }
+    }
+
+    hamming_close_planes(env, err, reader.fds);
+    guess->parity = guess->flagged[1] < guess->flagged[0];
+    guess->sampled = true;
+    guess->recorded = HAMMING_META_NO_PARITY;
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+int hamming_find_parity(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct hamming_arena *arena,
+                        const char *prefix,
+                        bool check,
+                        struct hamming_parity_guess *guess) {
+    struct hamming_meta meta;
+    bool has_sidecar;
+
+    DC_TRACE(env);
+
+    if (read_sidecar(env, err, prefix, &has_sidecar, &meta) == -1) {
+        return -1;
+    }
+
+    // the encoder wrote down the parity it used, reading it back costs no plane reads; an empty
+    // plane set has no block to sample and decodes to nothing under either parity
+    if ((meta.parity != HAMMING_META_NO_PARITY && !check) || plane_set_empty(prefix, has_sidecar, &meta)) {
+        memset(guess, 0, sizeof(*guess));
+        guess->parity = meta.parity != HAMMING_META_NO_PARITY ? meta.parity : 0;
+        guess->recorded = meta.parity;
+
+        return 0;
+    }
+
+    if (hamming_sample_parity(env, err, arena, prefix, guess) == -1) {
+        return -1;
+    }
+
+    guess->recorded = meta.parity;
+
+    return 0;
+}
+
+void hamming_sample_print(FILE *stream, const struct hamming_sample_report *report) {
+    fprintf(stream, "sampled %ju of %ju blocks, %ju characters\n", (uintmax_t) report->blocks,
+            (uintmax_t) report->total_blocks, (uintmax_t) report->characters);
+    fprintf(stream, "corrected: %ju, %.3e per character (95%% CI %.3e to %.3e)\n", (uintmax_t) report->corrected,
+            report->corrected_rate.rate, report->corrected_rate.low, report->corrected_rate.high);
+    fprintf(stream, "uncorrectable: %ju, %.3e per character (95%% CI %.3e to %.3e)\n",
+            (uintmax_t) report->uncorrectable, report->uncorrectable_rate.rate, report->uncorrectable_rate.low,
+            report->uncorrectable_rate.high);
+}
+
+static int read_sidecar(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        const char *prefix,
+                        bool *has_sidecar,
+                        struct hamming_meta *meta) {
+    struct stat status;
+    char *path;
+    size_t path_size;
+
+    path = hamming_meta_path(env, err, prefix, &path_size);
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    // a plane set without a sidecar leaves the defaults
+    *has_sidecar = stat(path, &status) == 0;
+    dc_free(env, path, path_size);
+    hamming_meta_init(meta);
+
+    if (*has_sidecar && hamming_meta_read(env, err, prefix, meta) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static bool plane_set_empty(const char *prefix, bool has_sidecar, const struct hamming_meta *meta) {
+    char path[PATH_MAX];
+    struct stat status;
+
+    if (has_sidecar) {
+        return meta->length == 0;
+    }
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == 0 && stat(path, &status) == 0 &&
+            status.st_size > 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int plane_set_size(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          const char *prefix,
+                          uint64_t *length,
+                          unsigned int *constant,
+                          unsigned int *constant_ones) {
+    struct hamming_meta meta;
+    struct stat status;
+    char path[PATH_MAX];
+    unsigned int erased;
+    bool has_sidecar;
+
+    if (read_sidecar(env, err, prefix, &has_sidecar, &meta) == -1) {
+        return -1;
+    }
+
+    *length = has_sidecar ? meta.length : UINT64_MAX;
+    *constant = meta.constant;
+    *constant_ones = meta.constant_ones;
+
+    // a missing plane has no bits to check the others against
+    if (hamming_find_erasures(prefix, HAMMING_ALL_PLANES & ~meta.constant, *length, &erased) == -1 || erased != 0) {
+        DC_ERROR_RAISE_USER(err, "a plane file is missing or short, a full decode is needed to rebuild it", -1);
+        return -1;
+    }
+
+    // without a sidecar every character the planes hold is counted, the padding too
+    if (*length == UINT64_MAX) {
+        for (size_t index = 0; index < BITS_INC_HAMMING && *length == UINT64_MAX; index++) {
+            if (!(meta.constant & HAMMING_PLANE_BIT(index)) &&
+                hamming_plane_path(prefix, index, path, sizeof(path)) == 0 && stat(path, &status) == 0) {
+                *length = (uint64_t) status.st_size * BITS_PER_BYTE;
+            }
+        }
+    }
+
+    if (*length == UINT64_MAX || *length == 0) {
+        DC_ERROR_RAISE_USER(err, "plane set is empty", -1);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int open_reader(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_arena *arena,
+                       const char *prefix,
+                       size_t copies,
+                       struct block_reader *reader) {
+    unsigned int constant;
+    unsigned int constant_ones;
+
+    if (plane_set_size(env, err, prefix, &reader->length, &constant, &constant_ones) == -1 ||
+        hamming_arena_reserve(env, err, arena, copies * hamming_buffers_arena_size(BLOCK_CHARS), 0) == -1) {
+        return -1;
+    }
+
+    for (size_t copy = 0; copy < copies; copy++) {
+        if (hamming_buffers_init(arena, &reader->buffers[copy], BLOCK_CHARS) == -1) {
+            DC_ERROR_RAISE_USER(err, "sample arena is too small", -1);
+            return -1;
+        }
+
+        // a constant plane has no file, its slice of every block is the same
+        for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+            if (constant & HAMMING_PLANE_BIT(index)) {
+                memset(reader->buffers[copy].planes[index], (constant_ones & HAMMING_PLANE_BIT(index)) ? 0xFF : 0x00,
+                       HAMMING_SAMPLE_BLOCK_SIZE);
+            }
+        }
+    }
+
+    reader->total_blocks = (reader->length + BLOCK_CHARS - 1) / BLOCK_CHARS;
+
+    return hamming_open_plane_set(env, err, prefix, HAMMING_ALL_PLANES & ~constant, DC_O_RDONLY, 0, reader->fds);
+}
+
+static int read_block(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct block_reader *reader,
+                      uint64_t block,
+                      size_t *count) {
+    uint64_t first = block * BLOCK_CHARS;
+    size_t nbyte;
+
+    *count = reader->length - first < BLOCK_CHARS ? (size_t) (reader->length - first) : BLOCK_CHARS;
+    nbyte = (*count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        ssize_t nread;
+
+        if (reader->fds[index] == -1) {
+            continue;
+        }
+
+        nread = hamming_pread_fully(env, err, reader->fds[index], reader->buffers[0].planes[index], nbyte,
+                                    first / BITS_PER_BYTE);
+
+        if (nread == -1) {
+            return -1;
+        }
+
+        if ((size_t) nread != nbyte) {
+            DC_ERROR_RAISE_USER(err, "plane file is shorter than the plane set", -1);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void add_block(struct error_sums *sums, uint64_t errors, uint64_t characters) {
+    sums->e += (double) errors;
+    sums->ee += (double) errors * (double) errors;
+    sums->en += (double) errors * (double) characters;
+}
+
+static void estimate(const struct error_sums *sums,
+                     double nn,
+                     const struct hamming_sample_report *report,
+                     struct hamming_sample_estimate *estimate) {
+    double k = (double) report->blocks;
+    double n = (double) report->characters;
+    double rate;
+    double spread;
+    double variance;
+    double margin;
+
+    if (report->blocks < 2 || sums->e < 1) {
+        wilson(sums->e, n, estimate);
+        return;
+    }
+
+    // the ratio estimator's variance, from the residuals of each block against the overall rate
+    rate = sums->e / n;
+    spread = (sums->ee - 2 * rate * sums->en + rate * rate * nn) / (k - 1);
+    variance = (1 - k / (double) report->total_blocks) * spread / (k * (n / k) * (n / k));
+    margin = HAMMING_SAMPLE_Z * sqrt(variance > 0 ? variance : 0);
+    estimate->rate = rate;
+    estimate->low = rate > margin ? rate - margin : 0;
+    estimate->high = rate + margin;
+}
+
+static void wilson(double errors, double characters, struct hamming_sample_estimate *estimate) {
+    double z2 = HAMMING_SAMPLE_Z * HAMMING_SAMPLE_Z;
+    double p = characters > 0 ? errors / characters : 0;
+    double centre = (p + z2 / (2 * characters)) / (1 + z2 / characters);
+    double margin = HAMMING_SAMPLE_Z * sqrt(p * (1 - p) / characters + z2 / (4 * characters * characters)) /
+                    (1 + z2 / characters);
+
+    estimate->rate = p;
+    // centre and margin are equal in theory with no errors, in floating point they differ by noise
+    estimate->low = errors > 0 && centre > margin ? centre - margin : 0;
+    estimate->high = centre + margin;
+}
@@ -0,0 +1,505 @@
+#include "hamming_stream.h"
+#include "hamming_io.h"
+#include "hamming_pipeline.h"
+#include "hamming_push.h"
+#include "hamming_syscalls.h"
+#include <ctype.h>
+#include <dc_posix/dc_unistd.h>
+#include <poll.h>
+#include <string.h>
+
+/**
+ * What the encoding stages share. The read stage owns the input and the carried newline,
+ * the write stage owns the output and the frame it assembles.
+ */
+struct encode_state {
+    int in_fd;
+    int out_fd;
+    int parity;
+    bool binary;
+    bool has_carry;   // a newline was held back from the previous frame
+    uint64_t sequence; // of the next frame written
+    uint64_t size;
+    uint8_t *frame;   // header and plane slices of the frame being written
+};
+
+/**
+ * What the decoding stages share. The read stage owns the input and the expected sequence
+ * number, the write stage owns the output and the counters.
+ */
+struct decode_state {
+    int in_fd;
+    int out_fd;
+    int parity;
+    bool binary;
+    bool verify;
+    size_t frame_size;
+    uint64_t sequence; // of the next frame read
+    struct hamming_decode_stats *stats;
+};
+
+static int read_input(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int encode_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int write_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int send_frame(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct encode_state *state,
+                      uint8_t *const planes[],
+                      size_t count);
+
+static int read_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int decode_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int write_output(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg);
+
+static int read_stream_header(const struct dc_posix_env *env, struct dc_error *err, struct decode_state *state);
+
+static int decode_pushed(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         int in_fd,
+                         int out_fd,
+                         const struct hamming_decode_options *options,
+                         struct hamming_decode_stats *stats);
+
+static bool input_ready(int fd);
+
+static void store_le(uint8_t *buf, uint64_t value, size_t size);
+
+static uint64_t load_le(const uint8_t *buf, size_t size);
+
+int hamming_encode_stream(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          int in_fd,
+                          int out_fd,
+                          const struct hamming_encode_options *options,
+                          struct hamming_encode_stats *stats) {
+    struct hamming_pipeline_config pipeline;
+    struct encode_state state;
+    uint8_t header[HAMMING_STREAM_HEADER_SIZE] = {0};
+    size_t frame_bytes;
+
+    DC_TRACE(env);
+    state.in_fd = in_fd;
+    state.out_fd = out_fd;
+    state.parity = options->parity;
+    state.binary = options->binary;
+    state.has_carry = false;
+    state.sequence = 0;
+    state.size = 0;
+
+    pipeline.chunk_size = hamming_chunk_size(options->chunk_size);
+    pipeline.workers = options->threads;
+    pipeline.depth = 0;
+    pipeline.read = read_input;
+    pipeline.work = encode_frame;
+    pipeline.write = write_frame;
+    pipeline.arg = &state;
+    pipeline.work_name = "transpose and parity";
+
+    if (pipeline.chunk_size > HAMMING_STREAM_MAX_FRAME_SIZE) {
+        DC_ERROR_RAISE_USER(err, "frame size is larger than a decoder accepts", -1);
+        return -1;
+    }
+
+    frame_bytes = HAMMING_FRAME_HEADER_SIZE + BITS_INC_HAMMING * (pipeline.chunk_size / BITS_PER_BYTE);
+
+    if (hamming_arena_reserve(env, err, arena, hamming_pipeline_arena_size(&pipeline) + hamming_arena_align(frame_bytes),
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1) {
+        return -1;
+    }
+
+    state.frame = hamming_arena_alloc(arena, frame_bytes);
+    memcpy(header, HAMMING_STREAM_MAGIC, 4);
+    store_le(header + 4, pipeline.chunk_size, 4);
+    header[8] = (uint8_t) options->parity;
+
+    if (hamming_write_fully(env, err, out_fd, header, sizeof(header)) == -1 ||
+        hamming_pipeline_run(env, err, arena, &pipeline) == -1) {
+        return -1;
+    }
+
+    stats->characters += state.size;
+
+    return 0;
+}
+
+int hamming_decode_stream(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct hamming_arena *arena,
+                          int in_fd,
+                          int out_fd,
+                          const struct hamming_decode_options *options,
+                          struct hamming_decode_stats *stats) {
+    struct hamming_pipeline_config pipeline;
+    struct decode_state state;
+
+    DC_TRACE(env);
+
+    // on the calling thread the stream is pushed through the same decoder an event loop would use
+    if (options->threads == 0) {
+        return decode_pushed(env, err, arena, in_fd, out_fd, options, stats);
+    }
+
+    state.in_fd = in_fd;
+    state.out_fd = out_fd;
+    state.binary = options->binary;
+    state.verify = options->verify;
+    state.sequence = 0;
+    state.stats = stats;
+
+    if (read_stream_header(env, err, &state) == -1) {
+        return -1;
+    }
+
+    // the buffers are sized for the largest frame the stream announced
+    pipeline.chunk_size = state.frame_size;
+    pipeline.workers = options->threads;
+    pipeline.depth = 0;
+    pipeline.read = read_frame;
+    pipeline.work = decode_frame;
+    pipeline.write = write_output;
+    pipeline.arg = &state;
+    pipeline.work_name = options->verify ? "correct" : "extract";
+
+    if (hamming_arena_reserve(env, err, arena, hamming_pipeline_arena_size(&pipeline),
+                              options->huge_pages ? HAMMING_ARENA_HUGE_PAGES : 0) == -1) {
+        return -1;
+    }
+
+    return hamming_pipeline_run(env, err, arena, &pipeline);
+}
+
+int hamming_stream_header_parse(struct dc_error *err,
+                                const uint8_t header[HAMMING_STREAM_HEADER_SIZE],
+                                size_t *frame_size,
+                                int *parity) {
+    if (memcmp(header, HAMMING_STREAM_MAGIC, 4) != 0) {
+        DC_ERROR_RAISE_USER(err, "input is not a hamming stream", -1);
+        return -1;
+    }
+
+    *frame_size = (size_t) load_le(header + 4, 4);
+    *parity = header[8];
+
+    if (*frame_size == 0 || *frame_size % BITS_PER_BYTE != 0 || *frame_size > HAMMING_STREAM_MAX_FRAME_SIZE ||
+        *parity > 1 || header[9] != 0 || header[10] != 0 || header[11] != 0) {
+        DC_ERROR_RAISE_USER(err, "stream header is damaged", -1);
+        return -1;
+    }
+
+    return 0;
+}
+
+int hamming_frame_header_parse(struct dc_error *err,
+                               const uint8_t header[HAMMING_FRAME_HEADER_SIZE],
+                               uint64_t sequence,
+                               size_t frame_size,
+                               int parity,
+                               size_t *count) {
+    uint64_t characters = load_le(header + 8, 4);
+
+    if (load_le(header, 8) != sequence || characters > frame_size || header[12] != parity || header[13] != 0 ||
+        header[14] != 0 || header[15] != 0) {
+        DC_ERROR_RAISE_USER(err, "stream frame is out of sequence or damaged", -1);
+        return -1;
+    }
+
+    *count = (size_t) characters;
+
+    return 0;
+}
+
+static int read_input(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct encode_state *state = arg;
+    struct hamming_buffers *buffers = &chunk->buffers;
+    size_t count = 0;
+    ssize_t nread = 0;
+
+    if (state->has_carry) {
+        buffers->chars[count++] = '\n';
+        state->has_carry = false;
+    }
+
+    // fill the frame while the input keeps up, send what there is as soon as it does not
+    while (count < buffers->chunk_size) {
+        nread = dc_read(env, err, state->in_fd, buffers->chars + count, buffers->chunk_size - count);
+
+        if (dc_error_has_error(err)) {
+            return -1;
+        }
+
+        count += (size_t) nread;
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, (size_t) nread);
+
+        if (nread == 0 || !input_ready(state->in_fd)) {
+            break;
+        }
+    }
+
+    chunk->final = nread == 0;
+
+    // text input ends with the newline that submitted it, which can only be told once the input ends
+    if (!state->binary && count > 0 && buffers->chars[count - 1] == '\n') {
+        count--;
+        state->has_carry = !chunk->final;
+    }
+
+    chunk->count = count;
+
+    return 0;
+}
+
+static int encode_frame(__attribute__((unused)) const struct dc_posix_env *env,
+                        __attribute__((unused)) struct dc_error *err,
+                        struct hamming_chunk *chunk,
+                        void *arg) {
+    const struct encode_state *state = arg;
+
+    hamming_encode_chunk(&chunk->buffers, chunk->count, state->parity);
+
+    return 0;
+}
+
+static int write_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct encode_state *state = arg;
+
+    // a frame of 0 characters ends the stream, so an empty read sends nothing
+    if (chunk->count > 0 && send_frame(env, err, state, chunk->buffers.planes, chunk->count) == -1) {
+        return -1;
+    }
+
+    if (chunk->final && send_frame(env, err, state, chunk->buffers.planes, 0) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int send_frame(const struct dc_posix_env *env,
+                      struct dc_error *err,
+                      struct encode_state *state,
+                      uint8_t *const planes[],
+                      size_t count) {
+    size_t nbyte = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+    uint8_t *slice = state->frame + HAMMING_FRAME_HEADER_SIZE;
+
+    memset(state->frame, 0, HAMMING_FRAME_HEADER_SIZE);
+    store_le(state->frame, state->sequence, 8);
+    store_le(state->frame + 8, count, 4);
+    state->frame[12] = (uint8_t) state->parity;
+
+    // one write per frame, so a reader never sees part of a frame for long
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        memcpy(slice + index * nbyte, planes[index], nbyte);
+    }
+
+    if (hamming_write_fully(env, err, state->out_fd, state->frame, HAMMING_FRAME_HEADER_SIZE + BITS_INC_HAMMING * nbyte) ==
+        -1) {
+        return -1;
+    }
+
+    state->sequence++;
+    state->size += count;
+
+    return 0;
+}
+
+static int read_frame(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct decode_state *state = arg;
+    struct hamming_buffers *buffers = &chunk->buffers;
+    uint8_t header[HAMMING_FRAME_HEADER_SIZE];
+    ssize_t nread;
+    size_t count;
+    size_t nbyte;
+
+    nread = hamming_read_fully(env, err, state->in_fd, header, sizeof(header));
+
+    if (nread == -1) {
+        return -1;
+    }
+
+    if ((size_t) nread < sizeof(header)) {
+        DC_ERROR_RAISE_USER(err, "stream ended before its last frame", -1);
+        return -1;
+    }
+
+    if (hamming_frame_header_parse(err, header, state->sequence, state->frame_size, state->parity, &count) == -1) {
+        return -1;
+    }
+
+    state->sequence++;
+    nbyte = (count + BITS_PER_BYTE - 1) / BITS_PER_BYTE;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        nread = hamming_read_fully(env, err, state->in_fd, buffers->planes[index], nbyte);
+
+        if (nread == -1) {
+            return -1;
+        }
+
+        if ((size_t) nread < nbyte) {
+            DC_ERROR_RAISE_USER(err, "stream ended in the middle of a frame", -1);
+            return -1;
+        }
+    }
+
+    chunk->count = count;
+    chunk->final = count == 0;
+
+    return 0;
+}
+
+static int decode_frame(__attribute__((unused)) const struct dc_posix_env *env,
+                        __attribute__((unused)) struct dc_error *err,
+                        struct hamming_chunk *chunk,
+                        void *arg) {
+    const struct decode_state *state = arg;
+
+    chunk->stats.characters = 0;
+    chunk->stats.corrected = 0;
+    chunk->stats.uncorrectable = 0;
+    chunk->stats.erased = 0;
+
+    if (state->verify) {
+        hamming_decode_chunk(&chunk->buffers, chunk->count, state->parity, &chunk->stats);
+    } else {
+        hamming_extract_chunk(&chunk->buffers, chunk->count, &chunk->stats);
+    }
+
+    return 0;
+}
+
+static int write_output(const struct dc_posix_env *env, struct dc_error *err, struct hamming_chunk *chunk, void *arg) {
+    struct decode_state *state = arg;
+    uint8_t *chars = chunk->buffers.chars;
+    size_t length = chunk->count;
+
+    state->stats->characters += chunk->stats.characters;
+    state->stats->corrected += chunk->stats.corrected;
+    state->stats->uncorrectable += chunk->stats.uncorrectable;
+
+    if (!state->binary) {
+        length = 0;
+
+        for (size_t i = 0; i < chunk->count; i++) {
+            if (isprint(chars[i])) {
+                chars[length++] = chars[i];
+            }
+        }
+    }
+
+    return hamming_write_fully(env, err, state->out_fd, chars, length);
+}
+
+static int read_stream_header(const struct dc_posix_env *env, struct dc_error *err, struct decode_state *state) {
+    uint8_t header[HAMMING_STREAM_HEADER_SIZE];
+    ssize_t nread;
+
+    nread = hamming_read_fully(env, err, state->in_fd, header, sizeof(header));
+
+    if (nread == -1) {
+        return -1;
+    }
+
+    if ((size_t) nread < sizeof(header)) {
+        DC_ERROR_RAISE_USER(err, "input is not a hamming stream", -1);
+        return -1;
+    }
+
+    return hamming_stream_header_parse(err, header, &state->frame_size, &state->parity);
+}
+
+static int decode_pushed(const struct dc_posix_env *env,
+                         struct dc_error *err,
+                         struct hamming_arena *arena,
+                         int in_fd,
+                         int out_fd,
+                         const struct hamming_decode_options *options,
+                         struct hamming_decode_stats *stats) {
+    struct hamming_push_decoder decoder;
+    int status = HAMMING_PUSH_MORE;
+    uint8_t *buf;
+
+    if (hamming_arena_reserve(env, err, arena, HAMMING_DEFAULT_CHUNK_SIZE, 0) == -1 ||
+        hamming_push_decoder_init(env, err, &decoder, options) == -1) {
+        return -1;
+    }
+
+    buf = hamming_arena_alloc(arena, HAMMING_DEFAULT_CHUNK_SIZE);
+
+    while (status != HAMMING_PUSH_END) {
+        ssize_t nread = dc_read(env, err, in_fd, buf, HAMMING_DEFAULT_CHUNK_SIZE);
+        size_t offset = 0;
+
+        if (dc_error_has_error(err)) {
+            break;
+        }
+
+        hamming_syscalls_add_bytes(HAMMING_SYSCALL_READ, (size_t) nread);
+
+        // a read can hold the end of one frame and several more
+        do {
+            const uint8_t *output;
+            size_t consumed;
+            size_t length;
+
+            status = hamming_push(env, err, &decoder, buf + offset, (size_t) nread - offset, &consumed, &output,
+                                  &length);
+
+            if (status == -1 || hamming_write_fully(env, err, out_fd, output, length) == -1) {
+                break;
+            }
+
+            offset += consumed;
+        } while (status == HAMMING_PUSH_OUTPUT);
+
+        if (status == -1 || dc_error_has_error(err)) {
+            break;
+        }
+
+        if (nread == 0 && status != HAMMING_PUSH_END) {
+            DC_ERROR_RAISE_USER(err, "stream ended before its last frame", -1);
+            break;
+        }
+    }
+
+    stats->characters += decoder.stats.characters;
+    stats->corrected += decoder.stats.corrected;
+    stats->uncorrectable += decoder.stats.uncorrectable;
+    hamming_push_decoder_destroy(env, &decoder);
+
+    return dc_error_has_error(err) ? -1 : 0;
+}
+
+static bool input_ready(int fd) {
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    // a regular file is always ready, a pipe only while the producer has written ahead
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN);
+}
+
+static void store_le(uint8_t *buf, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = (uint8_t) (value >> (BITS_PER_BYTE * i));
+    }
+}
+
+static uint64_t load_le(const uint8_t *buf, size_t size) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        value |= (uint64_t) buf[i] << (BITS_PER_BYTE * i);
+    }
+
+    return value;
+}
@@ -0,0 +1,229 @@
+#include "hamming_stripe.h"
+#include "hamming_io.h"
+#include "hamming_trace.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+static size_t dir_count;
+static char dir_paths[HAMMING_STRIPE_MAX_DIRS][PATH_MAX];
+
+static void *worker_main(void *arg);
+
+static int serve(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 const struct hamming_stripe *stripe,
+                 size_t device,
+                 unsigned int planes,
+                 hamming_plane_io io,
+                 void *arg);
+
+int hamming_stripe_set(struct dc_error *err, const char *dirs) {
+    const char *start = dirs;
+
+    dir_count = 0;
+
+    if (dirs == NULL || *dirs == '\0') {
+        return 0;
+    }
+
+    for (;;) {
+        const char *comma = strchr(start, ',');
+        size_t length = comma == NULL ? strlen(start) : (size_t) (comma - start);
+
+        if (length == 0 || length >= PATH_MAX || dir_count == HAMMING_STRIPE_MAX_DIRS) {
+            dir_count = 0;
+            DC_ERROR_RAISE_USER(err, "plane directories must be 1 to 12 non-empty paths separated by commas", -1);
+            return -1;
+        }
+
+        memcpy(dir_paths[dir_count], start, length);
+        dir_paths[dir_count][length] = '\0';
+        dir_count++;
+
+        if (comma == NULL) {
+            return 0;
+        }
+
+        start = comma + 1;
+    }
+}
+
+size_t hamming_stripe_devices(void) {
+    return dir_count > 0 ? dir_count : 1;
+}
+
+const char *hamming_stripe_dir(size_t index) {
+    return dir_count > 0 ? dir_paths[index % dir_count] : NULL;
+}
+
+int hamming_stripe_start(const struct dc_posix_env *env, struct dc_error *err, struct hamming_stripe *stripe) {
+    DC_TRACE(env);
+    stripe->env = env;
+    stripe->devices = hamming_stripe_devices();
+    stripe->round = 0;
+    stripe->pending = 0;
+    stripe->stopping = false;
+
+    if (stripe->devices == 1) {
+        return 0;
+    }
+
+    pthread_mutex_init(&stripe->lock, NULL);
+    pthread_cond_init(&stripe->start, NULL);
+    pthread_cond_init(&stripe->done, NULL);
+
+    for (size_t device = 0; device < stripe->devices; device++) {
+        stripe->workers[device].stripe = stripe;
+        stripe->workers[device].device = device;
+        stripe->workers[device].started = false;
+        dc_error_init(&stripe->workers[device].err, NULL);
+    }
+
+    // workers[0] is the calling thread
+    for (size_t device = 1; device < stripe->devices; device++) {
+        int result = pthread_create(&stripe->workers[device].thread, NULL, worker_main, &stripe->workers[device]);
+
+        if (result != 0) {
+            DC_ERROR_RAISE_ERRNO(err, result);
+            hamming_stripe_stop(stripe);
+            return -1;
+        }
+
+        stripe->workers[device].started = true;
+    }
+
+    return 0;
+}
+
+int hamming_stripe_run(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct hamming_stripe *stripe,
+                       unsigned int planes,
+                       hamming_plane_io io,
+                       void *arg) {
+    int ret_val;
+
+    if (stripe->devices == 1) {
+        return serve(env, err, stripe, 0, planes, io, arg);
+    }
+
+    pthread_mutex_lock(&stripe->lock);
+    stripe->planes = planes;
+    stripe->io = io;
+    stripe->arg = arg;
+    stripe->pending = stripe->devices - 1;
+    stripe->round++;
+    pthread_cond_broadcast(&stripe->start);
+    pthread_mutex_unlock(&stripe->lock);
+
+    ret_val = serve(env, err, stripe, 0, planes, io, arg);
+
+    pthread_mutex_lock(&stripe->lock);
+
+    while (stripe->pending > 0) {
+        pthread_cond_wait(&stripe->done, &stripe->lock);
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+
+    for (size_t device = 1; device < stripe->devices; device++) {
+        struct dc_error *worker_err = &stripe->workers[device].err;
+
+        if (dc_error_has_error(worker_err)) {
+            if (dc_error_has_no_error(err)) {
+                DC_ERROR_RAISE_USER(err, worker_err->message, -1);
+            }
+
+            ret_val = -1;
+        }
+
+        dc_error_reset(worker_err);
+    }
+
+    return ret_val;
+}
+
+void hamming_stripe_stop(struct hamming_stripe *stripe) {
+    if (stripe->devices == 1) {
+        return;
+    }
+
+    pthread_mutex_lock(&stripe->lock);
+    stripe->stopping = true;
+    pthread_cond_broadcast(&stripe->start);
+    pthread_mutex_unlock(&stripe->lock);
+
+    for (size_t device = 1; device < stripe->devices; device++) {
+        if (stripe->workers[device].started) {
+            pthread_join(stripe->workers[device].thread, NULL);
+            stripe->workers[device].started = false;
+        }
+
+        dc_error_reset(&stripe->workers[device].err);
+    }
+
+    pthread_cond_destroy(&stripe->done);
+    pthread_cond_destroy(&stripe->start);
+    pthread_mutex_destroy(&stripe->lock);
+    stripe->devices = 1;
+}
+
+static void *worker_main(void *arg) {
+    struct hamming_stripe_worker *worker = arg;
+    struct hamming_stripe *stripe = worker->stripe;
+    char name[HAMMING_TRACE_NAME_SIZE];
+    uint64_t seen = 0;
+
+    snprintf(name, sizeof(name), "plane I/O %zu", worker->device);
+    hamming_trace_thread(name);
+    pthread_mutex_lock(&stripe->lock);
+
+    for (;;) {
+        unsigned int planes;
+        hamming_plane_io io;
+        void *io_arg;
+
+        while (stripe->round == seen && !stripe->stopping) {
+            pthread_cond_wait(&stripe->start, &stripe->lock);
+        }
+
+        if (stripe->stopping) {
+            break;
+        }
+
+        seen = stripe->round;
+        planes = stripe->planes;
+        io = stripe->io;
+        io_arg = stripe->arg;
+        pthread_mutex_unlock(&stripe->lock);
+
+        serve(stripe->env, &worker->err, stripe, worker->device, planes, io, io_arg);
+
+        pthread_mutex_lock(&stripe->lock);
+
+        if (--stripe->pending == 0) {
+            pthread_cond_signal(&stripe->done);
+        }
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+
+    return NULL;
+}
+
+static int serve(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 const struct hamming_stripe *stripe,
+                 size_t device,
+                 unsigned int planes,
+                 hamming_plane_io io,
+                 void *arg) {
+    for (size_t index = device; index < BITS_INC_HAMMING; index += stripe->devices) {
+        if ((planes & HAMMING_PLANE_BIT(index)) && io(env, err, index, arg) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "hamming_syscalls.h"
+#include <dc_posix/dc_stdlib.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * The dc functions counted, as the tracer sees their names.
+ */
+struct traced_function {
+    const char *name;
+    enum hamming_syscall call;
+};
+
+static const struct traced_function traced_functions[] = {
+        {"dc_open", HAMMING_SYSCALL_OPEN},
+        {"dc_read", HAMMING_SYSCALL_READ},
+        {"dc_write", HAMMING_SYSCALL_WRITE},
+        {"dc_close", HAMMING_SYSCALL_CLOSE},
+        {"dc_dc_close", HAMMING_SYSCALL_CLOSE},
+        {"dc_malloc", HAMMING_SYSCALL_MALLOC},
+        {"dc_calloc", HAMMING_SYSCALL_CALLOC},
+};
+
+static atomic_bool counting;
+static atomic_uint_fast64_t calls[HAMMING_SYSCALLS];
+static atomic_uint_fast64_t bytes[HAMMING_SYSCALLS];
+
+void hamming_syscalls_start(void) {
+    atomic_store(&counting, true);
+}
+
+void hamming_syscalls_tracer(__attribute__((unused)) const struct dc_posix_env *env,
+                             __attribute__((unused)) const char *file_name,
+                             const char *function_name,
+                             __attribute__((unused)) size_t line_number) {
+    // every dc call and every DC_TRACE of the application comes through here
+    if (!atomic_load_explicit(&counting, memory_order_relaxed) || strncmp(function_name, "dc_", 3) != 0) {
+        return;
+    }
+
+    for (size_t i = 0; i < sizeof(traced_functions) / sizeof(traced_functions[0]); i++) {
+        if (strcmp(function_name, traced_functions[i].name) == 0) {
+            atomic_fetch_add_explicit(&calls[traced_functions[i].call], 1, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void hamming_syscalls_add_call(enum hamming_syscall call) {
+    if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&calls[call], 1, memory_order_relaxed);
+    }
+}
+
+void hamming_syscalls_add_bytes(enum hamming_syscall call, size_t size) {
+    if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&bytes[call], size, memory_order_relaxed);
+    }
+}
+
+void *hamming_malloc(const struct dc_posix_env *env, struct dc_error *err, size_t size) {
+    hamming_syscalls_add_bytes(HAMMING_SYSCALL_MALLOC, size);
+
+    return dc_malloc(env, err, size);
+}
+
+void *hamming_calloc(const struct dc_posix_env *env, struct dc_error *err, size_t count, size_t size) {
+    hamming_syscalls_add_bytes(HAMMING_SYSCALL_CALLOC, count * size);
+
+    return dc_calloc(env, err, count, size);
+}
+
+void hamming_syscalls_get(struct hamming_syscall_counts *counts) {
+    for (size_t i = 0; i < HAMMING_SYSCALLS; i++) {
+        counts->calls[i] = atomic_load(&calls[i]);
+        counts->bytes[i] = atomic_load(&bytes[i]);
+    }
+}
+
+void hamming_syscalls_print(FILE *stream) {
+    struct hamming_syscall_counts counts;
+
+    hamming_syscalls_get(&counts);
+    fprintf(stream, "syscalls: %ju opens, %ju reads of %ju bytes, %ju writes of %ju bytes, %ju closes\n",
+            (uintmax_t) counts.calls[HAMMING_SYSCALL_OPEN], (uintmax_t) counts.calls[HAMMING_SYSCALL_READ],
+            (uintmax_t) counts.bytes[HAMMING_SYSCALL_READ], (uintmax_t) counts.calls[HAMMING_SYSCALL_WRITE],
+            (uintmax_t) counts.bytes[HAMMING_SYSCALL_WRITE], (uintmax_t) counts.calls[HAMMING_SYSCALL_CLOSE]);
+    fprintf(stream, "allocations: %ju mallocs of %ju bytes, %ju callocs of %ju bytes\n",
+            (uintmax_t) counts.calls[HAMMING_SYSCALL_MALLOC], (uintmax_t) counts.bytes[HAMMING_SYSCALL_MALLOC],
+            (uintmax_t) counts.calls[HAMMING_SYSCALL_CALLOC], (uintmax_t) counts.bytes[HAMMING_SYSCALL_CALLOC]);
+}
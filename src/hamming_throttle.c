@@ -0,0 +1,162 @@
+#include "hamming_throttle.h"
+#include "hamming_clock.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * I/O priority class and scope from the kernel's ioprio interface, which has no header.
+ */
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_WHO_PROCESS 1
+
+/**
+ * The token buckets, one per limit.
+ */
+enum bucket_kind {
+    BUCKET_READ,
+    BUCKET_WRITE,
+    BUCKET_OPERATIONS,
+    BUCKETS
+};
+
+/**
+ * Tokens are bytes or operations. They go negative when a call takes more than there is,
+ * and the caller waits until the refill pays the debt back.
+ */
+struct bucket {
+    double rate;     // tokens per second, 0 for no limit
+    double capacity; // most tokens saved up while idle
+    double tokens;
+    double refilled; // when the tokens were last refilled
+};
+
+static atomic_bool throttling;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct bucket buckets[BUCKETS];
+static struct hamming_throttle_stats totals;
+
+static void start_bucket(struct bucket *bucket, double rate, double now);
+
+static double take(struct bucket *bucket, double amount, double now);
+
+static void account(enum bucket_kind kind, size_t size);
+
+void hamming_throttle_start(const struct hamming_throttle_limits *limits) {
+    double now = hamming_clock_now();
+
+    pthread_mutex_lock(&lock);
+    start_bucket(&buckets[BUCKET_READ], limits->read_mbps * 1e6, now);
+    start_bucket(&buckets[BUCKET_WRITE], limits->write_mbps * 1e6, now);
+    start_bucket(&buckets[BUCKET_OPERATIONS], limits->iops, now);
+    pthread_mutex_unlock(&lock);
+    atomic_store(&throttling, true);
+}
+
+void hamming_throttle_read(size_t size) {
+    account(BUCKET_READ, size);
+}
+
+void hamming_throttle_write(size_t size) {
+    account(BUCKET_WRITE, size);
+}
+
+int hamming_throttle_idle(struct dc_error *err) {
+#ifdef SYS_ioprio_set
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) == -1) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    return 0;
+#else
+    DC_ERROR_RAISE_USER(err, "I/O priorities are not supported on this system", -1);
+    return -1;
+#endif
+}
+
+void hamming_throttle_get(struct hamming_throttle_stats *stats) {
+    pthread_mutex_lock(&lock);
+    *stats = totals;
+    pthread_mutex_unlock(&lock);
+}
+
+void hamming_throttle_print(FILE *stream) {
+    struct hamming_throttle_stats stats;
+
+    hamming_throttle_get(&stats);
+    fprintf(stream, "throttle: %ju bytes read, %ju bytes written in %ju operations, held back %ju times for %.3f s\n",
+            (uintmax_t) stats.read_bytes, (uintmax_t) stats.write_bytes, (uintmax_t) stats.operations,
+            (uintmax_t) stats.waits, stats.seconds);
+}
+
+static void start_bucket(struct bucket *bucket, double rate, double now) {
+    bucket->rate = rate;
+    bucket->capacity = rate * HAMMING_THROTTLE_BURST_SECONDS;
+    bucket->tokens = bucket->capacity;
+    bucket->refilled = now;
+}
+
+static double take(struct bucket *bucket, double amount, double now) {
+    if (bucket->rate <= 0.0) {
+        return 0.0;
+    }
+
+    bucket->tokens += (now - bucket->refilled) * bucket->rate;
+    bucket->refilled = now;
+
+    if (bucket->tokens > bucket->capacity) {
+        bucket->tokens = bucket->capacity;
+    }
+
+    bucket->tokens -= amount;
+
+    return bucket->tokens < 0.0 ? -bucket->tokens / bucket->rate : 0.0;
+}
+
+static void account(enum bucket_kind kind, size_t size) {
+    double wait;
+    double operation_wait;
+    double now;
+
+    if (!atomic_load_explicit(&throttling, memory_order_relaxed)) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    now = hamming_clock_now();
+    wait = take(&buckets[kind], (double) size, now);
+    operation_wait = take(&buckets[BUCKET_OPERATIONS], 1.0, now);
+    wait = operation_wait > wait ? operation_wait : wait;
+
+    if (kind == BUCKET_READ) {
+        totals.read_bytes += size;
+    } else {
+        totals.write_bytes += size;
+    }
+
+    totals.operations++;
+
+    if (wait > 0.0) {
+        totals.waits++;
+        totals.seconds += wait;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    // the debt is already taken, so the threads waiting at the same time are paced one after another
+    if (wait > 0.0) {
+        struct timespec delay;
+
+        delay.tv_sec = (time_t) wait;
+        delay.tv_nsec = (long) ((wait - (double) delay.tv_sec) * 1e9);
+
+        while (nanosleep(&delay, &delay) == -1 && errno == EINTR) {
+        }
+    }
+}
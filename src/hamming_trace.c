@@ -0,0 +1,250 @@
+#include "hamming_trace.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * One begin ('B') or end ('E') event.
+ */
+struct trace_event {
+    const char *name; // NULL for an end
+    uint64_t nanoseconds;
+    uint64_t chunk;
+    size_t plane;
+};
+
+/**
+ * The events of one thread. Only the thread itself appends, publishing each event with a
+ * release store of the count, and the buffer is linked into the list of every buffer once.
+ */
+struct trace_buffer {
+    struct trace_buffer *next;
+    unsigned int tid;
+    char name[HAMMING_TRACE_NAME_SIZE];
+    size_t open;    // spans begun and not ended yet, each needs room for its end
+    size_t skipped; // spans whose begin was dropped, their ends are dropped too
+    uint64_t dropped;
+    atomic_size_t count;
+    struct trace_event events[HAMMING_TRACE_THREAD_EVENTS];
+};
+
+static atomic_bool tracing;
+static char trace_path[PATH_MAX];
+static uint64_t start_nanoseconds;
+static atomic_uint next_tid;
+static _Atomic(struct trace_buffer *) buffers;
+static _Thread_local struct trace_buffer *local_buffer;
+static _Thread_local bool no_buffer; // the buffer of the thread could not be allocated
+
+static uint64_t now(void);
+
+static struct trace_buffer *thread_buffer(void);
+
+static void append(struct trace_buffer *buffer, const char *name, uint64_t chunk, size_t plane);
+
+static void write_event(FILE *file, const struct trace_buffer *buffer, const struct trace_event *event, bool *first);
+
+int hamming_trace_start(struct dc_error *err, const char *path) {
+    size_t length = strlen(path);
+
+    if (length >= sizeof(trace_path)) {
+        DC_ERROR_RAISE_USER(err, "trace file path is too long", -1);
+        return -1;
+    }
+
+    memcpy(trace_path, path, length + 1);
+    start_nanoseconds = now();
+    atomic_store(&tracing, true);
+    hamming_trace_thread("main");
+
+    return 0;
+}
+
+void hamming_trace_thread(const char *name) {
+    struct trace_buffer *buffer;
+
+    if (!atomic_load_explicit(&tracing, memory_order_relaxed) || (buffer = thread_buffer()) == NULL) {
+        return;
+    }
+
+    strncpy(buffer->name, name, sizeof(buffer->name) - 1);
+    buffer->name[sizeof(buffer->name) - 1] = '\0';
+}
+
+void hamming_trace_begin(const char *name, uint64_t chunk, size_t plane) {
+    struct trace_buffer *buffer;
+    size_t count;
+
+    if (!atomic_load_explicit(&tracing, memory_order_relaxed) || (buffer = thread_buffer()) == NULL) {
+        return;
+    }
+
+    count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+
+    // a begin is only kept with room for its end and the ends of the spans around it
+    if (buffer->skipped > 0 || count + buffer->open + 2 > HAMMING_TRACE_THREAD_EVENTS) {
+        buffer->skipped++;
+        buffer->dropped++;
+        return;
+    }
+
+    buffer->open++;
+    append(buffer, name, chunk, plane);
+}
+
+void hamming_trace_end(void) {
+    struct trace_buffer *buffer = local_buffer;
+
+    if (buffer == NULL || !atomic_load_explicit(&tracing, memory_order_relaxed)) {
+        return;
+    }
+
+    if (buffer->skipped > 0) {
+        buffer->skipped--;
+        return;
+    }
+
+    if (buffer->open > 0) {
+        buffer->open--;
+        append(buffer, NULL, HAMMING_TRACE_NO_CHUNK, HAMMING_TRACE_NO_PLANE);
+    }
+}
+
+int hamming_trace_finish(struct dc_error *err) {
+    struct trace_buffer *buffer;
+    uint64_t dropped = 0;
+    bool first = true;
+    FILE *file;
+
+    if (!atomic_exchange(&tracing, false)) {
+        return 0;
+    }
+
+    file = fopen(trace_path, "w");
+
+    if (file == NULL) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+    } else {
+        fprintf(file, "{\"traceEvents\":[\n");
+    }
+
+    buffer = atomic_load_explicit(&buffers, memory_order_acquire);
+
+    while (buffer != NULL) {
+        struct trace_buffer *next = buffer->next;
+        size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+
+        if (file != NULL) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", (long) getpid(), buffer->tid, buffer->name);
+            first = false;
+
+            for (size_t i = 0; i < count; i++) {
+                write_event(file, buffer, &buffer->events[i], &first);
+            }
+        }
+
+        dropped += buffer->dropped;
+        free(buffer);
+        buffer = next;
+    }
+
+    atomic_store(&buffers, NULL);
+    local_buffer = NULL;
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped spans\":\"%ju\"}}\n", (uintmax_t) dropped);
+
+    if (fclose(file) == EOF) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    return 0;
+}
+
+static uint64_t now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t) time.tv_sec * 1000000000U + (uint64_t) time.tv_nsec;
+}
+
+static struct trace_buffer *thread_buffer(void) {
+    struct trace_buffer *buffer = local_buffer;
+
+    if (buffer != NULL || no_buffer) {
+        return buffer;
+    }
+
+    // allocated once per thread and handed to hamming_trace_finish, which frees it
+    buffer = malloc(sizeof(*buffer));
+
+    if (buffer == NULL) {
+        no_buffer = true;
+        return NULL;
+    }
+
+    buffer->tid = atomic_fetch_add(&next_tid, 1) + 1;
+    snprintf(buffer->name, sizeof(buffer->name), "thread %u", buffer->tid);
+    buffer->open = 0;
+    buffer->skipped = 0;
+    buffer->dropped = 0;
+    atomic_init(&buffer->count, 0);
+    buffer->next = atomic_load_explicit(&buffers, memory_order_relaxed);
+
+    while (!atomic_compare_exchange_weak_explicit(&buffers, &buffer->next, buffer, memory_order_release,
+                                                  memory_order_relaxed)) {
+    }
+
+    local_buffer = buffer;
+
+    return buffer;
+}
+
+static void append(struct trace_buffer *buffer, const char *name, uint64_t chunk, size_t plane) {
+    size_t count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+    struct trace_event *event = &buffer->events[count];
+
+    event->name = name;
+    event->nanoseconds = now();
+    event->chunk = chunk;
+    event->plane = plane;
+    atomic_store_explicit(&buffer->count, count + 1, memory_order_release);
+}
+
+static void write_event(FILE *file, const struct trace_buffer *buffer, const struct trace_event *event, bool *first) {
+    // the viewers take microseconds
+    double microseconds = (double) (event->nanoseconds - start_nanoseconds) / 1000.0;
+
+    fprintf(file, "%s{\"ph\":\"%c\",\"pid\":%ld,\"tid\":%u,\"ts\":%.3f", *first ? "" : ",\n",
+            event->name == NULL ? 'E' : 'B', (long) getpid(), buffer->tid, microseconds);
+    *first = false;
+
+    if (event->name != NULL) {
+        fprintf(file, ",\"name\":\"%s\",\"cat\":\"hamming\",\"args\":{", event->name);
+
+        if (event->chunk != HAMMING_TRACE_NO_CHUNK) {
+            fprintf(file, "\"chunk\":%ju%s", (uintmax_t) event->chunk,
+                    event->plane != HAMMING_TRACE_NO_PLANE ? "," : "");
+        }
+
+        if (event->plane != HAMMING_TRACE_NO_PLANE) {
+            fprintf(file, "\"plane\":%zu", event->plane);
+        }
+
+        fputc('}', file);
+    }
+
+    fputc('}', file);
+}
@@ -0,0 +1,614 @@
+#include "hamming_tune.h"
+#include "hamming_arena.h"
+#include "hamming_channel.h"
+#include "hamming_clock.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include "hamming_options.h"
+#include "hamming_pipeline.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Appended to the prefix for the scratch plane set; the message and the decoded output
+ * go next to it with ".in" and ".out" after that.
+ */
+#define SCRATCH_SUFFIX ".tune"
+
+/**
+ * Bytes of random message written at a time.
+ */
+#define FILL_SIZE ((size_t) 64 * 1024)
+
+/**
+ * Written to the config file in place of the lines of the same keys, the last only by the
+ * encoder.
+ */
+static const char *const config_keys[] = {"chunk-size", "threads", "direct-io", "parallel-threshold", "stores"};
+
+/**
+ * The chunk sizes tried.
+ */
+static const size_t chunk_sizes[] = {16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+
+/**
+ * The message sizes tried for the parallel threshold, largest first.
+ */
+static const size_t threshold_sizes[] = {16 * 1024 * 1024, 4 * 1024 * 1024, 1024 * 1024, 256 * 1024, 64 * 1024};
+
+/**
+ * The scratch files of a tune and what is run against them.
+ */
+struct tune_run {
+    enum hamming_tune_mode mode;
+    char prefix[PATH_MAX];
+    char in_path[PATH_MAX];
+    char out_path[PATH_MAX];
+    int in_fd;
+    int out_fd;
+    struct hamming_arena arena;
+    struct hamming_encode_options encode;
+    struct hamming_decode_options decode;
+    FILE *log;
+};
+
+static int open_scratch(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct tune_run *run,
+                        const char *prefix,
+                        size_t size);
+
+static void remove_scratch(const struct dc_posix_env *env, struct tune_run *run);
+
+static int fill_random(const struct dc_posix_env *env, struct dc_error *err, int fd, size_t size);
+
+static int prepare_planes(const struct dc_posix_env *env, struct dc_error *err, struct tune_run *run);
+
+static int measure(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct tune_run *run,
+                   const struct hamming_tune_result *setting,
+                   size_t size,
+                   double *mbps);
+
+static int try_setting(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct tune_run *run,
+                       const struct hamming_tune_result *setting,
+                       size_t size,
+                       struct hamming_tune_result *best);
+
+static int find_threshold(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct tune_run *run,
+                          size_t size,
+                          struct hamming_tune_result *best);
+
+static int copy_foreign_lines(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *path,
+                              enum hamming_tune_mode mode,
+                              int out_fd);
+
+static bool is_tuned_key(const char *line, size_t length, enum hamming_tune_mode mode);
+
+static int write_line(const struct dc_posix_env *env, struct dc_error *err, int fd, const char *key, const char *value);
+
+int hamming_tune(const struct dc_posix_env *env,
+                 struct dc_error *err,
+                 enum hamming_tune_mode mode,
+                 const char *prefix,
+                 size_t size,
+                 FILE *log,
+                 struct hamming_tune_result *result) {
+    struct tune_run run;
+    struct hamming_tune_result setting;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_threads;
+    int ret_val = -1;
+
+    DC_TRACE(env);
+
+    if (size == 0) {
+        DC_ERROR_RAISE_USER(err, "the tune size must be at least one character", -1);
+        return -1;
+    }
+
+    max_threads = online < 1 ? 1 : (size_t) online;
+
+    if (max_threads > HAMMING_PIPELINE_MAX_WORKERS) {
+        max_threads = HAMMING_PIPELINE_MAX_WORKERS;
+    }
+
+    if (open_scratch(env, err, &run, prefix, size) == -1) {
+        return -1;
+    }
+
+    run.mode = mode;
+    run.log = log;
+    memset(result, 0, sizeof(*result));
+    result->chunk_size = HAMMING_DEFAULT_CHUNK_SIZE;
+    result->stores = HAMMING_STORES_AUTO;
+
+    if (mode == HAMMING_TUNE_DECODE && prepare_planes(env, err, &run) == -1) {
+        goto done;
+    }
+
+    // one setting at a time, each from the best of the ones before
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++) {
+        setting = *result;
+        setting.chunk_size = chunk_sizes[i];
+
+        if (try_setting(env, err, &run, &setting, size, result) == -1) {
+            goto done;
+        }
+    }
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        setting = *result;
+        setting.threads = threads;
+
+        if (try_setting(env, err, &run, &setting, size, result) == -1) {
+            goto done;
+        }
+    }
+
+    if (mode == HAMMING_TUNE_ENCODE) {
+        for (int stores = HAMMING_STORES_CACHED; stores <= HAMMING_STORES_STREAMING; stores++) {
+            setting = *result;
+            setting.stores = (enum hamming_store_kernel) stores;
+
+            if (try_setting(env, err, &run, &setting, size, result) == -1) {
+                goto done;
+            }
+        }
+    }
+
+    setting = *result;
+    setting.direct_io = true;
+
+    if (try_setting(env, err, &run, &setting, size, result) == -1) {
+        // file systems without O_DIRECT only rule the setting out
+        fprintf(log, "direct-io=true is not supported here: %s\n", err->message);
+        dc_error_reset(err);
+    }
+
+    ret_val = find_threshold(env, err, &run, size, result);
+
+done:
+    hamming_set_store_kernel(HAMMING_STORES_AUTO);
+    remove_scratch(env, &run);
+
+    return ret_val;
+}
+
+int hamming_tune_write_config(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *path,
+                              enum hamming_tune_mode mode,
+                              const struct hamming_tune_result *result) {
+    char tmp_path[PATH_MAX];
+    char value[32];
+    int written = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd;
+
+    DC_TRACE(env);
+
+    if (written < 0 || (size_t) written >= sizeof(tmp_path)) {
+        DC_ERROR_RAISE_USER(err, "config file path is too long", -1);
+        return -1;
+    }
+
+    fd = dc_open(env, err, tmp_path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    if (copy_foreign_lines(env, err, path, mode, fd) == 0) {
+        snprintf(value, sizeof(value), "%zu", result->chunk_size);
+        write_line(env, err, fd, "chunk-size", value);
+        snprintf(value, sizeof(value), "%zu", result->threads);
+        write_line(env, err, fd, "threads", value);
+        write_line(env, err, fd, "direct-io", result->direct_io ? "true" : "false");
+        snprintf(value, sizeof(value), "%zu", result->parallel_threshold);
+        write_line(env, err, fd, "parallel-threshold", value);
+
+        if (mode == HAMMING_TUNE_ENCODE) {
+            write_line(env, err, fd, "stores", hamming_stores_name(result->stores));
+        }
+    }
+
+    dc_dc_close(env, err, fd);
+
+    if (dc_error_has_no_error(err) && rename(tmp_path, path) == -1) {
+        DC_ERROR_RAISE_ERRNO(err, errno);
+    }
+
+    if (dc_error_has_error(err)) {
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int open_scratch(const struct dc_posix_env *env,
+                        struct dc_error *err,
+                        struct tune_run *run,
+                        const char *prefix,
+                        size_t size) {
+    int written = snprintf(run->prefix, sizeof(run->prefix), "%s%s", prefix, SCRATCH_SUFFIX);
+    int in_written = snprintf(run->in_path, sizeof(run->in_path), "%s%s.in", prefix, SCRATCH_SUFFIX);
+    int out_written = snprintf(run->out_path, sizeof(run->out_path), "%s%s.out", prefix, SCRATCH_SUFFIX);
+
+    run->in_fd = -1;
+    run->out_fd = -1;
+    memset(&run->arena, 0, sizeof(run->arena));
+    hamming_encode_options_init(&run->encode);
+    hamming_decode_options_init(&run->decode);
+    run->encode.binary = true;
+    run->decode.binary = true;
+
+    if (written < 0 || (size_t) written >= sizeof(run->prefix) || in_written < 0 ||
+        (size_t) in_written >= sizeof(run->in_path) || out_written < 0 ||
+        (size_t) out_written >= sizeof(run->out_path)) {
+        DC_ERROR_RAISE_USER(err, "tune file path is too long", -1);
+        return -1;
+    }
+
+    run->in_fd = dc_open(env, err, run->in_path, DC_O_CREAT | DC_O_TRUNC | DC_O_RDWR, S_IRUSR | S_IWUSR);
+
+    if (dc_error_has_no_error(err)) {
+        run->out_fd = dc_open(env, err, run->out_path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+    }
+
+    if (dc_error_has_no_error(err)) {
+        fill_random(env, err, run->in_fd, size);
+    }
+
+    if (dc_error_has_error(err)) {
+        remove_scratch(env, run);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void remove_scratch(const struct dc_posix_env *env, struct tune_run *run) {
+    struct dc_error cleanup_err;
+    char path[PATH_MAX];
+    char *meta_path;
+    size_t meta_path_size;
+
+    // missing files are expected, the planes of a failed setting may never have been written
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (hamming_plane_path(run->prefix, index, path, sizeof(path)) == 0) {
+            unlink(path);
+        }
+    }
+
+    if (run->in_fd != -1) {
+        close(run->in_fd);
+        unlink(run->in_path);
+    }
+
+    if (run->out_fd != -1) {
+        close(run->out_fd);
+        unlink(run->out_path);
+    }
+
+    // the tune's own error may already be set, the cleanup is done regardless
+    dc_error_init(&cleanup_err, NULL);
+    meta_path = hamming_meta_path(env, &cleanup_err, run->prefix, &meta_path_size);
+
+    if (meta_path != NULL) {
+        unlink(meta_path);
+        dc_free(env, meta_path, meta_path_size);
+    }
+
+    dc_error_reset(&cleanup_err);
+
+    hamming_arena_destroy(env, &run->arena);
+}
+
+static int fill_random(const struct dc_posix_env *env, struct dc_error *err, int fd, size_t size) {
+    struct hamming_channel channel;
+    uint64_t *buf;
+
+    buf = dc_malloc(env, err, FILL_SIZE);
+
+    if (buf == NULL) {
+        return -1;
+    }
+
+    hamming_channel_init(&channel, HAMMING_CHANNEL_UNIFORM, 0, 0, (uint64_t) size);
+
+    for (size_t done = 0; done < size;) {
+        size_t count = size - done < FILL_SIZE ? size - done : FILL_SIZE;
+
+        for (size_t i = 0; i < FILL_SIZE / sizeof(*buf); i++) {
+            buf[i] = hamming_channel_random(&channel);
+        }
+
+        if (hamming_write_fully(env, err, fd, buf, count) == -1) {
+            dc_free(env, buf, FILL_SIZE);
+            return -1;
+        }
+
+        done += count;
+    }
+
+    dc_free(env, buf, FILL_SIZE);
+
+    return 0;
+}
+
+static int prepare_planes(const struct dc_posix_env *env, struct dc_error *err, struct tune_run *run) {
+    struct hamming_encode_options options;
+    struct hamming_encode_stats stats = {0};
+
+    // the planes are the same whatever the settings they are written with
+    hamming_encode_options_init(&options);
+    options.binary = true;
+    hamming_set_store_kernel(HAMMING_STORES_AUTO);
+    dc_lseek(env, err, run->in_fd, 0, SEEK_SET);
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    return hamming_encode(env, err, &run->arena, run->in_fd, run->prefix, &options, &stats);
+}
+
+static int measure(const struct dc_posix_env *env,
+                   struct dc_error *err,
+                   struct tune_run *run,
+                   const struct hamming_tune_result *setting,
+                   size_t size,
+                   double *mbps) {
+    double best = 0;
+    double total = 0;
+    size_t runs = 0;
+
+    run->encode.chunk_size = setting->chunk_size;
+    run->encode.threads = setting->threads;
+    run->encode.direct_io = setting->direct_io;
+    run->decode.chunk_size = setting->chunk_size;
+    run->decode.threads = setting->threads;
+    run->decode.direct_io = setting->direct_io;
+    hamming_set_store_kernel(setting->stores);
+
+    // the fastest of a few runs, the others were slowed by something else on the host
+    while (runs < 2 || (total < HAMMING_TUNE_MIN_SECONDS && runs < HAMMING_TUNE_MAX_RUNS)) {
+        double start = hamming_clock_now();
+        double elapsed;
+        int result;
+
+        if (run->mode == HAMMING_TUNE_ENCODE) {
+            struct hamming_encode_stats stats = {0};
+
+            dc_lseek(env, err, run->in_fd, 0, SEEK_SET);
+            result = dc_error_has_error(err) ? -1
+                                             : hamming_encode(env, err, &run->arena, run->in_fd, run->prefix,
+                                                              &run->encode, &stats);
+        } else {
+            struct hamming_decode_stats stats = {0};
+
+            dc_lseek(env, err, run->out_fd, 0, SEEK_SET);
+
+            if (dc_error_has_no_error(err)) {
+                dc_ftruncate(env, err, run->out_fd, 0);
+            }
+
+            result = dc_error_has_error(err) ? -1
+                                             : hamming_decode(env, err, &run->arena, run->prefix, run->out_fd,
+                                                              &run->decode, &stats);
+        }
+
+        if (result == -1) {
+            return -1;
+        }
+
+        elapsed = hamming_clock_now() - start;
+        total += elapsed;
+
+        if (runs == 0 || elapsed < best) {
+            best = elapsed;
+        }
+
+        runs++;
+    }
+
+    *mbps = best > 0 ? (double) size / best / 1e6 : 0;
+
+    if (run->mode == HAMMING_TUNE_ENCODE) {
+        fprintf(run->log, "%zu characters, chunk-size=%zu threads=%zu stores=%s direct-io=%s: %.1f MB/s\n", size,
+                setting->chunk_size, setting->threads, hamming_stores_name(setting->stores),
+                setting->direct_io ? "true" : "false", *mbps);
+    } else {
+        fprintf(run->log, "%zu characters, chunk-size=%zu threads=%zu direct-io=%s: %.1f MB/s\n", size,
+                setting->chunk_size, setting->threads, setting->direct_io ? "true" : "false", *mbps);
+    }
+
+    return 0;
+}
+
+static int try_setting(const struct dc_posix_env *env,
+                       struct dc_error *err,
+                       struct tune_run *run,
+                       const struct hamming_tune_result *setting,
+                       size_t size,
+                       struct hamming_tune_result *best) {
+    double mbps;
+
+    if (measure(env, err, run, setting, size, &mbps) == -1) {
+        return -1;
+    }
+
+    if (mbps > best->mbps) {
+        *best = *setting;
+        best->mbps = mbps;
+    }
+
+    return 0;
+}
+
+static int find_threshold(const struct dc_posix_env *env,
+                          struct dc_error *err,
+                          struct tune_run *run,
+                          size_t size,
+                          struct hamming_tune_result *best) {
+    struct hamming_tune_result single = *best;
+
+    if (best->threads == 0) {
+        best->parallel_threshold = 0;
+        return 0;
+    }
+
+    // the threads won at the full size, walk down until they stop winning
+    best->parallel_threshold = size;
+    single.threads = 0;
+
+    for (size_t i = 0; i < sizeof(threshold_sizes) / sizeof(threshold_sizes[0]); i++) {
+        size_t smaller = threshold_sizes[i];
+        double single_mbps;
+        double threaded_mbps;
+
+        if (smaller >= size) {
+            continue;
+        }
+
+        dc_ftruncate(env, err, run->in_fd, (off_t) smaller);
+
+        if (dc_error_has_error(err) ||
+            (run->mode == HAMMING_TUNE_DECODE && prepare_planes(env, err, run) == -1) ||
+            measure(env, err, run, &single, smaller, &single_mbps) == -1 ||
+            measure(env, err, run, best, smaller, &threaded_mbps) == -1) {
+            return -1;
+        }
+
+        if (threaded_mbps <= single_mbps) {
+            break;
+        }
+
+        best->parallel_threshold = smaller;
+    }
+
+    return 0;
+}
+
+static int copy_foreign_lines(const struct dc_posix_env *env,
+                              struct dc_error *err,
+                              const char *path,
+                              enum hamming_tune_mode mode,
+                              int out_fd) {
+    struct stat status;
+    char *text;
+    size_t capacity;
+    size_t size = 0;
+    int fd;
+    int ret_val = 0;
+
+    // no config file yet is only an empty one
+    if (stat(path, &status) == -1) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+
+        DC_ERROR_RAISE_ERRNO(err, errno);
+        return -1;
+    }
+
+    if ((uintmax_t) status.st_size > HAMMING_TUNE_MAX_CONFIG_SIZE) {
+        DC_ERROR_RAISE_USER(err, "config file is too large to update", -1);
+        return -1;
+    }
+
+    capacity = (size_t) status.st_size + 1;
+    text = dc_malloc(env, err, capacity);
+
+    if (text == NULL) {
+        return -1;
+    }
+
+    fd = dc_open(env, err, path, DC_O_RDONLY, 0);
+
+    if (dc_error_has_no_error(err)) {
+        ssize_t nread = hamming_read_fully(env, err, fd, text, capacity - 1);
+
+        dc_dc_close(env, err, fd);
+        size = nread > 0 ? (size_t) nread : 0;
+    }
+
+    for (size_t start = 0; dc_error_has_no_error(err) && start < size;) {
+        const char *newline = memchr(text + start, '\n', size - start);
+        size_t end = newline == NULL ? size : (size_t) (newline - text);
+
+        if (!is_tuned_key(text + start, end - start, mode)) {
+            if (hamming_write_fully(env, err, out_fd, text + start, end - start) == 0) {
+                hamming_write_fully(env, err, out_fd, "\n", 1);
+            }
+        }
+
+        start = end + 1;
+    }
+
+    if (dc_error_has_error(err)) {
+        ret_val = -1;
+    }
+
+    dc_free(env, text, capacity);
+
+    return ret_val;
+}
+
+static bool is_tuned_key(const char *line, size_t length, enum hamming_tune_mode mode) {
+    const char *equals = memchr(line, '=', length);
+    size_t keys = sizeof(config_keys) / sizeof(config_keys[0]);
+    size_t key_length;
+
+    if (equals == NULL) {
+        return false;
+    }
+
+    key_length = (size_t) (equals - line);
+
+    while (key_length > 0 && (line[key_length - 1] == ' ' || line[key_length - 1] == '\t')) {
+        key_length--;
+    }
+
+    if (mode == HAMMING_TUNE_DECODE) {
+        keys--;
+    }
+
+    for (size_t i = 0; i < keys; i++) {
+        if (strlen(config_keys[i]) == key_length && memcmp(config_keys[i], line, key_length) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int write_line(const struct dc_posix_env *env, struct dc_error *err, int fd, const char *key, const char *value) {
+    char line[128];
+    int written;
+
+    if (dc_error_has_error(err)) {
+        return -1;
+    }
+
+    written = snprintf(line, sizeof(line), "%s=%s\n", key, value);
+
+    return hamming_write_fully(env, err, fd, line, (size_t) written);
+}
@@ -0,0 +1,184 @@
+#include "tests.h"
+#include "hamming_archive.h"
+#include "hamming_arena.h"
+#include "hamming_batch.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Largest file a snapshot keeps.
+ */
+#define SNAPSHOT_SIZE 256
+
+/**
+ * The files of an archive: twelve planes, the index and the sidecar.
+ */
+#define ARCHIVE_FILES (BITS_INC_HAMMING + 2)
+
+static struct dc_posix_env env;
+static struct dc_error err;
+static struct hamming_arena arena;
+static char dir[PATH_MAX / 2];
+static char prefix[PATH_MAX];
+static char first_path[PATH_MAX];
+static char second_path[PATH_MAX];
+static char out_path[PATH_MAX];
+
+static int archive(const char *const *inputs, const char *const *ids, size_t count);
+
+static void write_file(const char *path, const char *text);
+
+static void archive_path(size_t file, char *path, size_t size);
+
+static void snapshot(char files[ARCHIVE_FILES][SNAPSHOT_SIZE], ssize_t sizes[ARCHIVE_FILES]);
+
+static void remove_files(void);
+
+Describe(hamming_archive);
+
+BeforeEach(hamming_archive) {
+    const char *parent = getenv("TMPDIR");
+
+    dc_error_init(&err, NULL);
+    dc_posix_env_init(&env, NULL);
+    memset(&arena, 0, sizeof(arena));
+    snprintf(dir, sizeof(dir), "%s/hamming_test.XXXXXX", parent != NULL ? parent : "/tmp");
+    assert_that(mkdtemp(dir), is_not_null);
+    snprintf(prefix, sizeof(prefix), "%s/archive", dir);
+    snprintf(first_path, sizeof(first_path), "%s/first", dir);
+    snprintf(second_path, sizeof(second_path), "%s/second", dir);
+    snprintf(out_path, sizeof(out_path), "%s/out", dir);
+}
+
+AfterEach(hamming_archive) {
+    remove_files();
+    rmdir(dir);
+    hamming_arena_destroy(&env, &arena);
+    dc_error_reset(&err);
+}
+
+Ensure(hamming_archive, rejects_a_duplicate_id_without_touching_an_existing_archive) {
+    const char *inputs[] = {first_path, second_path, first_path};
+    const char *ids[] = {"5", "2", "5"};
+    char before[ARCHIVE_FILES][SNAPSHOT_SIZE];
+    char after[ARCHIVE_FILES][SNAPSHOT_SIZE];
+    ssize_t before_sizes[ARCHIVE_FILES];
+    ssize_t after_sizes[ARCHIVE_FILES];
+    struct hamming_decode_options options;
+    struct hamming_decode_stats stats = {0};
+    char decoded[64];
+    ssize_t nread;
+    int fd;
+
+    write_file(first_path, "first member\n");
+    write_file(second_path, "second member\n");
+    assert_that(archive(inputs, ids, 2), is_equal_to(0));
+    snapshot(before, before_sizes);
+
+    // a longer manifest would rewrite every plane if it got that far
+    write_file(first_path, "a first member that is longer than the one archived\n");
+    assert_that(archive(inputs, ids, 3), is_equal_to(-1));
+    assert_that(strstr(err.message, "appears twice"), is_not_null);
+    dc_error_reset(&err);
+    snapshot(after, after_sizes);
+
+    for (size_t file = 0; file < ARCHIVE_FILES; file++) {
+        assert_that(after_sizes[file], is_equal_to(before_sizes[file]));
+        assert_that(memcmp(after[file], before[file], (size_t) before_sizes[file]), is_equal_to(0));
+    }
+
+    hamming_decode_options_init(&options);
+    options.binary = true;
+    fd = dc_open(&env, &err, out_path, DC_O_CREAT | DC_O_TRUNC | DC_O_RDWR, S_IRUSR | S_IWUSR);
+    assert_that(hamming_archive_decode(&env, &err, &arena, prefix, 2, fd, &options, &stats), is_equal_to(0));
+    dc_lseek(&env, &err, fd, 0, SEEK_SET);
+    nread = hamming_read_fully(&env, &err, fd, decoded, sizeof(decoded));
+    dc_dc_close(&env, &err, fd);
+    assert_that(nread, is_equal_to((ssize_t) strlen("second member\n")));
+    assert_that(memcmp(decoded, "second member\n", (size_t) nread), is_equal_to(0));
+}
+
+TestSuite *hamming_archive_tests(void) {
+    TestSuite *suite = create_test_suite();
+
+    add_test_with_context(suite, hamming_archive, rejects_a_duplicate_id_without_touching_an_existing_archive);
+
+    return suite;
+}
+
+static int archive(const char *const *inputs, const char *const *ids, size_t count) {
+    struct hamming_batch_job jobs[3];
+    struct hamming_batch batch;
+    struct hamming_encode_options options;
+    struct hamming_encode_stats stats = {0};
+
+    memset(jobs, 0, sizeof(jobs));
+    memset(&batch, 0, sizeof(batch));
+
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].input = inputs[i];
+        jobs[i].output = ids[i];
+        jobs[i].parity = -1;
+    }
+
+    batch.jobs = jobs;
+    batch.count = count;
+    batch.capacity = count;
+    hamming_encode_options_init(&options);
+    options.binary = true;
+
+    return hamming_archive_encode(&env, &err, &arena, &batch, prefix, &options, &stats);
+}
+
+static void write_file(const char *path, const char *text) {
+    int fd = dc_open(&env, &err, path, DC_O_CREAT | DC_O_TRUNC | DC_O_WRONLY, S_IRUSR | S_IWUSR);
+
+    assert_that(hamming_write_fully(&env, &err, fd, text, strlen(text)), is_equal_to(0));
+    dc_dc_close(&env, &err, fd);
+}
+
+static void archive_path(size_t file, char *path, size_t size) {
+    if (file < BITS_INC_HAMMING) {
+        hamming_plane_path(prefix, file, path, size);
+    } else if (file == BITS_INC_HAMMING) {
+        snprintf(path, size, "%s.index", prefix);
+    } else {
+        snprintf(path, size, "%s.meta", prefix);
+    }
+}
+
+static void snapshot(char files[ARCHIVE_FILES][SNAPSHOT_SIZE], ssize_t sizes[ARCHIVE_FILES]) {
+    char path[PATH_MAX];
+
+    for (size_t file = 0; file < ARCHIVE_FILES; file++) {
+        int fd;
+
+        archive_path(file, path, sizeof(path));
+        fd = dc_open(&env, &err, path, DC_O_RDONLY, 0);
+        assert_that(dc_error_has_no_error(&err), is_true);
+        sizes[file] = hamming_read_fully(&env, &err, fd, files[file], SNAPSHOT_SIZE);
+        dc_dc_close(&env, &err, fd);
+    }
+}
+
+static void remove_files(void) {
+    char path[PATH_MAX];
+
+    for (size_t file = 0; file < ARCHIVE_FILES; file++) {
+        archive_path(file, path, sizeof(path));
+        unlink(path);
+    }
+
+    unlink(first_path);
+    unlink(second_path);
+    unlink(out_path);
+}
@@ -0,0 +1,141 @@
+#include "tests.h"
+#include "hamming_arena.h"
+#include "hamming_decode.h"
+#include "hamming_encode.h"
+#include "hamming_io.h"
+#include "hamming_meta.h"
+#include <dc_posix/dc_fcntl.h>
+#include <dc_posix/dc_stdlib.h>
+#include <dc_posix/dc_unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static struct dc_posix_env env;
+static struct dc_error err;
+static struct hamming_arena arena;
+static char dir[PATH_MAX / 2];
+static char prefix[PATH_MAX];
+static char in_path[PATH_MAX];
+static char out_path[PATH_MAX];
+
+static void round_trip(int parity, int decode_parity, bool binary, const char *message, const char *expected);
+
+static void remove_files(void);
+
+Describe(hamming_decode);
+
+BeforeEach(hamming_decode) {
+    const char *parent = getenv("TMPDIR");
+
+    dc_error_init(&err, NULL);
+    dc_posix_env_init(&env, NULL);
+    memset(&arena, 0, sizeof(arena));
+    snprintf(dir, sizeof(dir), "%s/hamming_test.XXXXXX", parent != NULL ? parent : "/tmp");
+    assert_that(mkdtemp(dir), is_not_null);
+    snprintf(prefix, sizeof(prefix), "%s/message", dir);
+    snprintf(in_path, sizeof(in_path), "%s/in", dir);
+    snprintf(out_path, sizeof(out_path), "%s/out", dir);
+}
+
+AfterEach(hamming_decode) {
+    remove_files();
+    rmdir(dir);
+    hamming_arena_destroy(&env, &arena);
+    dc_error_reset(&err);
+}
+
+Ensure(hamming_decode, round_trips_odd_parity_text_of_a_partial_plane_byte) {
+    round_trip(1, 1, false, "Hi\n", "Hi");
+    round_trip(1, 1, false, "Hello, world\n", "Hello, world");
+}
+
+Ensure(hamming_decode, round_trips_even_parity_text_of_a_partial_plane_byte) {
+    round_trip(0, 0, false, "Hi\n", "Hi");
+    round_trip(0, 0, false, "Hello, world\n", "Hello, world");
+}
+
+Ensure(hamming_decode, round_trips_binary_of_a_partial_plane_byte) {
+    round_trip(1, 1, true, "odd\001", "odd\001");
+    round_trip(0, 0, true, "even\001", "even\001");
+}
+
+Ensure(hamming_decode, checks_the_parity_of_an_empty_plane_set_without_sampling) {
+    round_trip(1, HAMMING_PARITY_CHECK, false, "", "");
+    round_trip(0, HAMMING_PARITY_CHECK, true, "", "");
+}
+
+TestSuite *hamming_decode_tests(void) {
+    TestSuite *suite = create_test_suite();
+
+    add_test_with_context(suite, hamming_decode, round_trips_odd_parity_text_of_a_partial_plane_byte);
+    add_test_with_context(suite, hamming_decode, round_trips_even_parity_text_of_a_partial_plane_byte);
+    add_test_with_context(suite, hamming_decode, round_trips_binary_of_a_partial_plane_byte);
+    add_test_with_context(suite, hamming_decode, checks_the_parity_of_an_empty_plane_set_without_sampling);
+
+    return suite;
+}
+
+static void round_trip(int parity, int decode_parity, bool binary, const char *message, const char *expected) {
+    struct hamming_encode_options encode_options;
+    struct hamming_decode_options decode_options;
+    struct hamming_encode_stats encode_stats = {0};
+    struct hamming_decode_stats decode_stats = {0};
+    size_t expected_length = strlen(expected);
+    char decoded[64];
+    ssize_t nread;
+    int fd;
+
+    hamming_encode_options_init(&encode_options);
+    hamming_decode_options_init(&decode_options);
+    encode_options.parity = parity;
+    encode_options.binary = binary;
+    decode_options.parity = decode_parity;
+    decode_options.binary = binary;
+
+    fd = dc_open(&env, &err, in_path, DC_O_CREAT | DC_O_TRUNC | DC_O_RDWR, S_IRUSR | S_IWUSR);
+    assert_that(hamming_write_fully(&env, &err, fd, message, strlen(message)), is_equal_to(0));
+    dc_lseek(&env, &err, fd, 0, SEEK_SET);
+    assert_that(hamming_encode(&env, &err, &arena, fd, prefix, &encode_options, &encode_stats), is_equal_to(0));
+    dc_dc_close(&env, &err, fd);
+
+    fd = dc_open(&env, &err, out_path, DC_O_CREAT | DC_O_TRUNC | DC_O_RDWR, S_IRUSR | S_IWUSR);
+    assert_that(hamming_decode(&env, &err, &arena, prefix, fd, &decode_options, &decode_stats), is_equal_to(0));
+    dc_lseek(&env, &err, fd, 0, SEEK_SET);
+    nread = hamming_read_fully(&env, &err, fd, decoded, sizeof(decoded));
+    dc_dc_close(&env, &err, fd);
+
+    // the padding characters of the last plane byte are neither checked nor counted
+    assert_that(dc_error_has_no_error(&err), is_true);
+    assert_that(nread, is_equal_to((ssize_t) expected_length));
+    assert_that(memcmp(decoded, expected, expected_length), is_equal_to(0));
+    assert_that(decode_stats.characters, is_equal_to(expected_length));
+    assert_that(decode_stats.uncorrectable, is_equal_to(0));
+    assert_that(decode_stats.corrected, is_equal_to(0));
+    remove_files();
+}
+
+static void remove_files(void) {
+    char path[PATH_MAX];
+    char *meta_path;
+    size_t meta_path_size;
+
+    for (size_t index = 0; index < BITS_INC_HAMMING; index++) {
+        if (hamming_plane_path(prefix, index, path, sizeof(path)) == 0) {
+            unlink(path);
+        }
+    }
+
+    meta_path = hamming_meta_path(&env, &err, prefix, &meta_path_size);
+
+    if (meta_path != NULL) {
+        unlink(meta_path);
+        dc_free(&env, meta_path, meta_path_size);
+    }
+
+    unlink(in_path);
+    unlink(out_path);
+}
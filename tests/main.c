@@ -8,6 +8,8 @@ int main(int argc, char **argv)
     int           suite_result;
 
     suite    = create_test_suite();
+    add_suite(suite, hamming_archive_tests());
+    add_suite(suite, hamming_decode_tests());
     reporter = create_text_reporter();
 
     if(argc > 1)
@@ -4,5 +4,16 @@
 
 #include <cgreen/cgreen.h>
 
+/**
+ * Archives rejected before they touch the plane files.
+ * @return the suite
+ */
+TestSuite *hamming_archive_tests(void);
+
+/**
+ * Round trips through hamming_encode and hamming_decode.
+ * @return the suite
+ */
+TestSuite *hamming_decode_tests(void);
 
 #endif // LIBDC_POSIX_TESTS_H